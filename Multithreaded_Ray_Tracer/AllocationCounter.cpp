@@ -0,0 +1,83 @@
+/// @file AllocationCounter.cpp
+/// @brief Contains the replacement global operator new and delete that count allocations
+/// Replacing them here covers every allocation in the program, containers and std::function included. The count is one relaxed atomic add
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace
+{
+	std::atomic<long long> g_allocations(0);
+
+	void* CountedAllocate(std::size_t _size)
+	{
+		g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+		return std::malloc(_size > 0 ? _size : 1);   // new has to hand back a unique pointer even for 0 bytes
+	}
+}
+
+long long AllocationCount()
+{
+	return g_allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t _size)
+{
+	void *memory = CountedAllocate(_size);
+
+	if ( memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+void* operator new[](std::size_t _size)
+{
+	return operator new(_size);
+}
+
+void* operator new(std::size_t _size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(_size);
+}
+
+void* operator new[](std::size_t _size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(_size);
+}
+
+void operator delete(void *_memory) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete[](void *_memory) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete(void *_memory, std::size_t) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete[](void *_memory, std::size_t) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete(void *_memory, const std::nothrow_t&) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete[](void *_memory, const std::nothrow_t&) noexcept
+{
+	std::free(_memory);
+}
@@ -0,0 +1,9 @@
+/// \file AllocationCounter.h
+/// \brief Counts every heap allocation the program makes, so the render loop can be checked to make none
+/// \author Thomas Hardy
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+long long AllocationCount();   // Calls to operator new on any thread since the program started, take it before and after the code being checked
+#endif
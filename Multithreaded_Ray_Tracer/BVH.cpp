@@ -0,0 +1,588 @@
+/// @file BVH.cpp
+/// @brief Contains functions for building and querying the bounding volume hierarchy
+/// https://pbr-book.org/3ed-2018/Primitives_and_Intersection_Acceleration/Bounding_Volume_Hierarchies used for help with the SAH build
+
+#include <algorithm>
+#include <cmath>
+
+#include "BVH.h"
+
+#if SPHERE_SIMD_WIDTH > 1
+#include <immintrin.h>
+#endif
+
+#define BVH_BIN_COUNT (16)   // Macro for how many buckets the surface area heuristic tries split planes between
+#define BVH_TRAVERSAL_COST (1.0f)   // Macro for the cost of visiting a node relative to one intersection test
+
+namespace
+{
+	float SurfaceArea(glm::vec3 _boundsMin, glm::vec3 _boundsMax)
+	{
+		glm::vec3 extent = glm::max(_boundsMax - _boundsMin, glm::vec3(0.0f));
+		return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	struct Bin
+	{
+		glm::vec3 boundsMin = glm::vec3(INFINITY);
+		glm::vec3 boundsMax = glm::vec3(-INFINITY);
+		int count = 0;
+	};
+
+	int CountLanes(unsigned int _laneMask)
+	{
+		int count = 0;
+
+		for ( ; _laneMask != 0; _laneMask &= _laneMask - 1 )
+		{
+			count++;
+		}
+
+		return count;
+	}
+
+	// Packet lanes are worked on in groups of four with SSE whether or not AVX2 is on, every packet size is a multiple of four.
+	// Arrays passed in must be 16 byte aligned and _laneCount a multiple of four
+
+	unsigned int PacketHitsBox(glm::vec3 _boundsMin, glm::vec3 _boundsMax, glm::vec3 _rayOrigin, const float *_inverseX, const float *_inverseY, const float *_inverseZ, const float *_minT, int _laneCount)
+	{
+		unsigned int laneMask = 0;
+
+#if SPHERE_SIMD_WIDTH > 1
+		const __m128 minX = _mm_set1_ps(_boundsMin.x - _rayOrigin.x);
+		const __m128 minY = _mm_set1_ps(_boundsMin.y - _rayOrigin.y);
+		const __m128 minZ = _mm_set1_ps(_boundsMin.z - _rayOrigin.z);
+		const __m128 maxX = _mm_set1_ps(_boundsMax.x - _rayOrigin.x);
+		const __m128 maxY = _mm_set1_ps(_boundsMax.y - _rayOrigin.y);
+		const __m128 maxZ = _mm_set1_ps(_boundsMax.z - _rayOrigin.z);
+		const __m128 zero = _mm_setzero_ps();
+
+		for ( int lane = 0; lane < _laneCount; lane += 4 )
+		{
+			__m128 inverseX = _mm_load_ps(&_inverseX[lane]);
+			__m128 inverseY = _mm_load_ps(&_inverseY[lane]);
+			__m128 inverseZ = _mm_load_ps(&_inverseZ[lane]);
+
+			__m128 tx0 = _mm_mul_ps(minX, inverseX);
+			__m128 tx1 = _mm_mul_ps(maxX, inverseX);
+			__m128 ty0 = _mm_mul_ps(minY, inverseY);
+			__m128 ty1 = _mm_mul_ps(maxY, inverseY);
+			__m128 tz0 = _mm_mul_ps(minZ, inverseZ);
+			__m128 tz1 = _mm_mul_ps(maxZ, inverseZ);
+
+			__m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1));
+			__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_load_ps(&_minT[lane])));
+
+			__m128 hit = _mm_and_ps(_mm_cmple_ps(entry, exit), _mm_cmpge_ps(exit, zero));
+			laneMask |= (unsigned int)_mm_movemask_ps(hit) << lane;
+		}
+#else
+		for ( int lane = 0; lane < _laneCount; ++lane )
+		{
+			float tx0 = (_boundsMin.x - _rayOrigin.x) * _inverseX[lane];
+			float tx1 = (_boundsMax.x - _rayOrigin.x) * _inverseX[lane];
+			float ty0 = (_boundsMin.y - _rayOrigin.y) * _inverseY[lane];
+			float ty1 = (_boundsMax.y - _rayOrigin.y) * _inverseY[lane];
+			float tz0 = (_boundsMin.z - _rayOrigin.z) * _inverseZ[lane];
+			float tz1 = (_boundsMax.z - _rayOrigin.z) * _inverseZ[lane];
+
+			float entry = glm::max(glm::max(glm::min(tx0, tx1), glm::min(ty0, ty1)), glm::min(tz0, tz1));
+			float exit = glm::min(glm::min(glm::max(tx0, tx1), glm::max(ty0, ty1)), glm::min(glm::max(tz0, tz1), _minT[lane]));
+
+			laneMask |= (unsigned int)(entry <= exit && exit >= 0.0f) << lane;
+		}
+#endif
+
+		return laneMask;
+	}
+
+	// One sphere against every active lane, same sums in the same order as SphereSoA::ClosestHitScalar so t comes out the same
+
+	void PacketHitsSphere(glm::vec3 _L, float _lengthSquared, float _radiusSquared, int _primitive, const RayPacket &_packet, unsigned int _laneMask, int _laneCount, float *_minT, int *_shapeHit)
+	{
+#if SPHERE_SIMD_WIDTH > 1
+		const __m128 lx = _mm_set1_ps(_L.x);
+		const __m128 ly = _mm_set1_ps(_L.y);
+		const __m128 lz = _mm_set1_ps(_L.z);
+		const __m128 lengthSquared = _mm_set1_ps(_lengthSquared);
+		const __m128 radiusSquared = _mm_set1_ps(_radiusSquared);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128i primitive = _mm_set1_epi32(_primitive);
+		const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+
+		for ( int lane = 0; lane < _laneCount; lane += 4 )
+		{
+			__m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)(_laneMask >> lane)), laneBits), laneBits));
+
+			__m128 delta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_load_ps(&_packet.directionX[lane])), _mm_mul_ps(ly, _mm_load_ps(&_packet.directionY[lane]))),
+				_mm_mul_ps(lz, _mm_load_ps(&_packet.directionZ[lane])));
+			__m128 s2 = _mm_sub_ps(lengthSquared, _mm_mul_ps(delta, delta));
+			__m128 t0 = _mm_sub_ps(delta, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSquared, s2), zero)));
+
+			__m128 minT = _mm_load_ps(&_minT[lane]);
+			__m128 closer = _mm_and_ps(_mm_and_ps(active, _mm_cmpge_ps(delta, zero)), _mm_and_ps(_mm_cmple_ps(s2, radiusSquared), _mm_cmplt_ps(t0, minT)));
+			__m128i closerIndex = _mm_castps_si128(closer);
+
+			_mm_store_ps(&_minT[lane], _mm_or_ps(_mm_and_ps(closer, t0), _mm_andnot_ps(closer, minT)));
+			_mm_store_si128((__m128i*)&_shapeHit[lane], _mm_or_si128(_mm_and_si128(closerIndex, primitive), _mm_andnot_si128(closerIndex, _mm_load_si128((const __m128i*)&_shapeHit[lane]))));
+		}
+#else
+		for ( int lane = 0; lane < _laneCount; ++lane )
+		{
+			float delta = _L.x * _packet.directionX[lane] + _L.y * _packet.directionY[lane] + _L.z * _packet.directionZ[lane];
+			float s2 = _lengthSquared - (delta * delta);
+
+			if ( !((_laneMask >> lane) & 1) || delta < 0 || s2 > _radiusSquared )
+			{
+				continue;
+			}
+
+			float thc = sqrt(_radiusSquared - s2);
+			float t0 = delta - thc;
+
+			if ( t0 < _minT[lane] )
+			{
+				_minT[lane] = t0;
+				_shapeHit[lane] = _primitive;
+			}
+		}
+#endif
+	}
+}
+
+BVH::BVH()
+{
+	m_leafWidth = SPHERE_SIMD_WIDTH;   // A leaf of spheres costs one kernel step
+	m_scene = nullptr;
+}
+
+void BVH::Build(Scene &_scene)
+{
+	std::vector<glm::vec3> boundsMin;
+	std::vector<glm::vec3> boundsMax;
+	std::vector<int> boundedShapes;
+
+	m_scene = &_scene;
+
+	for ( int i = 0; i < _scene.getShapeCount(); ++i )   // Planes go round the tree, the scene tests them itself
+	{
+		glm::vec3 shapeMin;
+		glm::vec3 shapeMax;
+
+		if ( _scene.GetBounds(i, &shapeMin, &shapeMax) )
+		{
+			boundsMin.push_back(shapeMin);
+			boundsMax.push_back(shapeMax);
+			boundedShapes.push_back(i);
+		}
+	}
+
+	BuildFromBounds(boundsMin, boundsMax);
+
+	m_spheres.Clear();
+	m_otherShapes.clear();
+
+	for ( size_t i = 0; i < m_primitives.size(); ++i )   // Swap box indices for shape indices and lay the spheres out in leaf order
+	{
+		m_primitives[i] = boundedShapes[m_primitives[i]];
+
+		if ( _scene.getShapeType(m_primitives[i]) == SHAPE_SPHERE )
+		{
+			Sphere &sphere = _scene.getSphere(m_primitives[i]);
+			m_spheres.Add(sphere.getPosition(), sphere.getRadius());
+		}
+		else
+		{
+			m_spheres.AddPlaceholder();   // Keeps the sphere store lined up with the leaf entries
+			m_otherShapes.push_back((int)i);
+		}
+	}
+}
+
+void BVH::BuildFromBounds(const std::vector<glm::vec3> &_boundsMin, const std::vector<glm::vec3> &_boundsMax)
+{
+	m_nodes.clear();
+	m_primitives.clear();
+
+	if ( _boundsMin.empty() )
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centroids;
+
+	for ( size_t i = 0; i < _boundsMin.size(); ++i )
+	{
+		m_primitives.push_back((int)i);
+		centroids.push_back((_boundsMin[i] + _boundsMax[i]) * 0.5f);
+	}
+
+	m_nodes.reserve(2 * _boundsMin.size());   // A binary tree with one primitive per leaf at worst
+
+	BuildNode(0, (int)_boundsMin.size(), 0, _boundsMin, _boundsMax, centroids);
+}
+
+int BVH::BuildNode(int _first, int _count, int _depth, const std::vector<glm::vec3> &_boundsMin, const std::vector<glm::vec3> &_boundsMax, std::vector<glm::vec3> &_centroids)
+{
+	int nodeIndex = (int)m_nodes.size();
+	m_nodes.push_back(BVHNode());
+
+	glm::vec3 nodeMin = glm::vec3(INFINITY);
+	glm::vec3 nodeMax = glm::vec3(-INFINITY);
+	glm::vec3 centroidMin = glm::vec3(INFINITY);
+	glm::vec3 centroidMax = glm::vec3(-INFINITY);
+
+	for ( int i = _first; i < _first + _count; ++i )
+	{
+		int primitive = m_primitives[i];
+
+		nodeMin = glm::min(nodeMin, _boundsMin[primitive]);
+		nodeMax = glm::max(nodeMax, _boundsMax[primitive]);
+		centroidMin = glm::min(centroidMin, _centroids[primitive]);
+		centroidMax = glm::max(centroidMax, _centroids[primitive]);
+	}
+
+	m_nodes[nodeIndex].boundsMin = nodeMin;
+	m_nodes[nodeIndex].boundsMax = nodeMax;
+
+	// Split along the axis the centroids are most spread out on
+
+	glm::vec3 centroidExtent = centroidMax - centroidMin;
+	int axis = 0;
+
+	if ( centroidExtent.y > centroidExtent.x )
+	{
+		axis = 1;
+	}
+
+	if ( centroidExtent.z > centroidExtent[axis] )
+	{
+		axis = 2;
+	}
+
+	int mid = -1;
+	bool mustSplit = _count > 0xFFFF;   // A leaf's count has to fit in 16 bits
+
+	if ( _count > 1 && _depth < BVH_MAX_DEPTH - 1 && centroidExtent[axis] > 0.0f )
+	{
+		Bin bins[BVH_BIN_COUNT];
+		float binScale = BVH_BIN_COUNT / centroidExtent[axis];
+
+		for ( int i = _first; i < _first + _count; ++i )
+		{
+			int primitive = m_primitives[i];
+			int bin = std::min(BVH_BIN_COUNT - 1, (int)((_centroids[primitive][axis] - centroidMin[axis]) * binScale));
+
+			bins[bin].count++;
+			bins[bin].boundsMin = glm::min(bins[bin].boundsMin, _boundsMin[primitive]);
+			bins[bin].boundsMax = glm::max(bins[bin].boundsMax, _boundsMax[primitive]);
+		}
+
+		// Sweep from both ends so every split plane's cost comes out of two passes rather than one per plane
+
+		float rightArea[BVH_BIN_COUNT];
+		int rightCount[BVH_BIN_COUNT];
+		glm::vec3 sweepMin = glm::vec3(INFINITY);
+		glm::vec3 sweepMax = glm::vec3(-INFINITY);
+		int sweepCount = 0;
+
+		for ( int i = BVH_BIN_COUNT - 1; i > 0; --i )
+		{
+			sweepMin = glm::min(sweepMin, bins[i].boundsMin);
+			sweepMax = glm::max(sweepMax, bins[i].boundsMax);
+			sweepCount += bins[i].count;
+			rightArea[i] = SurfaceArea(sweepMin, sweepMax);
+			rightCount[i] = sweepCount;
+		}
+
+		float bestCost = INFINITY;
+		int bestBin = -1;
+
+		sweepMin = glm::vec3(INFINITY);
+		sweepMax = glm::vec3(-INFINITY);
+		sweepCount = 0;
+
+		for ( int i = 0; i < BVH_BIN_COUNT - 1; ++i )
+		{
+			sweepMin = glm::min(sweepMin, bins[i].boundsMin);
+			sweepMax = glm::max(sweepMax, bins[i].boundsMax);
+			sweepCount += bins[i].count;
+
+			if ( sweepCount == 0 || rightCount[i + 1] == 0 )
+			{
+				continue;
+			}
+
+			float cost = SurfaceArea(sweepMin, sweepMax) * sweepCount + rightArea[i + 1] * rightCount[i + 1];
+
+			if ( cost < bestCost )
+			{
+				bestCost = cost;
+				bestBin = i;
+			}
+		}
+
+		// Primitives are tested m_leafWidth at a time, so a leaf costs one test per group rather than one per primitive
+
+		float parentArea = SurfaceArea(nodeMin, nodeMax);
+		float leafCost = (float)((_count + m_leafWidth - 1) / m_leafWidth);
+		float splitCost = BVH_TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / (parentArea * m_leafWidth) : 0.0f);
+
+		if ( bestBin >= 0 && (splitCost < leafCost || _count > m_leafWidth) )
+		{
+			int *middle = std::partition(&m_primitives[_first], &m_primitives[_first] + _count, [&](int _primitive)
+			{
+				return std::min(BVH_BIN_COUNT - 1, (int)((_centroids[_primitive][axis] - centroidMin[axis]) * binScale)) <= bestBin;
+			});
+
+			mid = (int)(middle - &m_primitives[0]);
+		}
+	}
+
+	if ( mid < 0 && mustSplit )   // Every centroid is in the same place, halve the list so the leaves stay small enough
+	{
+		mid = _first + _count / 2;
+	}
+
+	if ( mid < 0 )
+	{
+		m_nodes[nodeIndex].offset = _first;
+		m_nodes[nodeIndex].count = (unsigned short)_count;
+		m_nodes[nodeIndex].axis = 0;
+
+		return nodeIndex;
+	}
+
+	BuildNode(_first, mid - _first, _depth + 1, _boundsMin, _boundsMax, _centroids);   // First child lands straight after its parent
+	int secondChild = BuildNode(mid, _first + _count - mid, _depth + 1, _boundsMin, _boundsMax, _centroids);
+
+	m_nodes[nodeIndex].offset = secondChild;
+	m_nodes[nodeIndex].count = 0;
+	m_nodes[nodeIndex].axis = (unsigned short)axis;
+
+	return nodeIndex;
+}
+
+bool BVH::ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_t, int *_shapeHit)
+{
+	float minT = INFINITY;
+	int shapeHit = -1;
+
+	if ( m_scene == nullptr )
+	{
+		*_t = minT;
+		*_shapeHit = shapeHit;
+
+		return false;
+	}
+
+	m_scene->UnboundedClosestHit(_rayOrigin, _rayDirection, &minT, &shapeHit);
+
+	ClosestHitFrom(0, _rayOrigin, _rayDirection, &minT, &shapeHit);
+
+	*_t = minT;
+	*_shapeHit = shapeHit;
+
+	return shapeHit != -1;
+}
+
+void BVH::ClosestHitFrom(int _rootNode, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_minT, int *_shapeHit)
+{
+	float t0 = 0.0f;
+
+	Traverse(_rayOrigin, _rayDirection, _minT, false, [&](int _firstEntry, int _entryCount, float *_maxT)
+	{
+		bool hit = false;
+		int sphereHit = -1;
+
+		if ( m_spheres.ClosestHit(_rayOrigin, _rayDirection, _firstEntry, _entryCount, &t0, &sphereHit) && t0 < *_maxT )
+		{
+			*_maxT = t0;
+			*_shapeHit = m_primitives[sphereHit];
+			hit = true;
+		}
+
+		hit = OtherShapesClosestHit(_rayOrigin, _rayDirection, _firstEntry, _entryCount, _maxT, _shapeHit) || hit;
+
+		return hit;
+	}, _rootNode);
+}
+
+bool BVH::AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _maxT)
+{
+	if ( m_scene == nullptr )
+	{
+		return false;
+	}
+
+	if ( m_scene->UnboundedAnyHit(_rayOrigin, _rayDirection, _maxT) )
+	{
+		return true;
+	}
+
+	bool hit = false;
+
+	Traverse(_rayOrigin, _rayDirection, &_maxT, true, [&](int _firstEntry, int _entryCount, float *_maxT)
+	{
+		int shapeHit = -1;
+
+		hit = m_spheres.AnyHit(_rayOrigin, _rayDirection, _firstEntry, _entryCount, *_maxT) || OtherShapesClosestHit(_rayOrigin, _rayDirection, _firstEntry, _entryCount, _maxT, &shapeHit);
+		return hit;
+	});
+
+	return hit;
+}
+
+bool BVH::OtherShapesClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _firstEntry, int _entryCount, float *_maxT, int *_shapeHit)
+{
+	bool hit = false;
+	float t0 = 0.0f;
+
+	// m_otherShapes is sorted, so the leaf's share of it is one run found by binary search
+
+	std::vector<int>::iterator entry = std::lower_bound(m_otherShapes.begin(), m_otherShapes.end(), _firstEntry);
+
+	for ( ; entry != m_otherShapes.end() && *entry < _firstEntry + _entryCount; ++entry )
+	{
+		if ( m_scene->Intersection(m_primitives[*entry], _rayOrigin, _rayDirection, &t0) && t0 < *_maxT )
+		{
+			*_maxT = t0;
+			*_shapeHit = m_primitives[*entry];
+			hit = true;
+		}
+	}
+
+	return hit;
+}
+
+void BVH::ClosestHitPacket(const RayPacket &_packet, float *_t, int *_shapeHit)
+{
+	alignas(16) float minT[RAY_PACKET_MAX];
+	alignas(16) int shapeHit[RAY_PACKET_MAX];
+	alignas(16) float inverseX[RAY_PACKET_MAX];
+	alignas(16) float inverseY[RAY_PACKET_MAX];
+	alignas(16) float inverseZ[RAY_PACKET_MAX];
+	int laneCount = (_packet.size + 3) & ~3;   // Lanes are worked on four at a time, the spare ones are masked off
+	unsigned int allLanes = (1u << _packet.size) - 1;
+	int negativeX = 0;
+	int negativeY = 0;
+	int negativeZ = 0;
+
+	for ( int lane = 0; lane < laneCount; ++lane )
+	{
+		minT[lane] = INFINITY;
+		shapeHit[lane] = -1;
+		inverseX[lane] = 1.0f / _packet.directionX[lane];
+		inverseY[lane] = 1.0f / _packet.directionY[lane];
+		inverseZ[lane] = 1.0f / _packet.directionZ[lane];
+	}
+
+	for ( int lane = 0; lane < _packet.size; ++lane )
+	{
+		glm::vec3 direction = glm::vec3(_packet.directionX[lane], _packet.directionY[lane], _packet.directionZ[lane]);
+
+		if ( m_scene != nullptr )   // Planes sit outside the tree and are tested ray by ray
+		{
+			m_scene->UnboundedClosestHit(_packet.origin, direction, &minT[lane], &shapeHit[lane]);
+		}
+
+		negativeX += inverseX[lane] < 0;
+		negativeY += inverseY[lane] < 0;
+		negativeZ += inverseZ[lane] < 0;
+	}
+
+	// The packet walks the tree in one order, so its rays all have to point into the same octant. If they don't it has diverged before it started
+
+	bool coherent = (negativeX == 0 || negativeX == _packet.size) && (negativeY == 0 || negativeY == _packet.size) && (negativeZ == 0 || negativeZ == _packet.size);
+
+	if ( !coherent || m_nodes.empty() )
+	{
+		for ( int lane = 0; lane < _packet.size; ++lane )
+		{
+			glm::vec3 direction = glm::vec3(_packet.directionX[lane], _packet.directionY[lane], _packet.directionZ[lane]);
+			ClosestHitFrom(0, _packet.origin, direction, &minT[lane], &shapeHit[lane]);
+		}
+	}
+	else
+	{
+		int directionIsNegative[3] = { negativeX > 0, negativeY > 0, negativeZ > 0 };
+
+		int stack[BVH_MAX_DEPTH];
+		unsigned int stackMask[BVH_MAX_DEPTH];   // Lanes still active when the entry was pushed
+		int stackSize = 0;
+		int nodeIndex = 0;
+		unsigned int activeMask = allLanes;
+
+		while ( true )
+		{
+			const BVHNode &node = m_nodes[nodeIndex];
+
+			// Lanes that missed the box drop out of this subtree
+
+			unsigned int nodeMask = PacketHitsBox(node.boundsMin, node.boundsMax, _packet.origin, inverseX, inverseY, inverseZ, minT, laneCount) & activeMask;
+			int activeCount = CountLanes(nodeMask);
+
+			if ( activeCount > 0 && activeCount < BVH_PACKET_MIN_ACTIVE && activeCount < _packet.size && node.count == 0 )
+			{
+				// Too few rays left to fill the lanes, the packet has diverged so the survivors finish this subtree on their own
+
+				for ( int lane = 0; lane < _packet.size; ++lane )
+				{
+					if ( (nodeMask >> lane) & 1 )
+					{
+						glm::vec3 direction = glm::vec3(_packet.directionX[lane], _packet.directionY[lane], _packet.directionZ[lane]);
+						ClosestHitFrom(nodeIndex, _packet.origin, direction, &minT[lane], &shapeHit[lane]);
+					}
+				}
+			}
+			else if ( activeCount > 0 && node.count > 0 )
+			{
+				for ( int entry = node.offset; entry < node.offset + node.count; ++entry )
+				{
+					// The origin is shared so L and its length only need working out once per sphere, then each lane is a few multiply-adds
+
+					glm::vec3 L = m_spheres.getCentre(entry) - _packet.origin;
+
+					PacketHitsSphere(L, dot(L, L), m_spheres.getRadiusSquared(entry), m_primitives[entry], _packet, nodeMask, laneCount, minT, shapeHit);
+				}
+
+				for ( int lane = 0; lane < _packet.size; ++lane )   // Entries that aren't spheres, usually none
+				{
+					if ( (nodeMask >> lane) & 1 )
+					{
+						glm::vec3 direction = glm::vec3(_packet.directionX[lane], _packet.directionY[lane], _packet.directionZ[lane]);
+						OtherShapesClosestHit(_packet.origin, direction, node.offset, node.count, &minT[lane], &shapeHit[lane]);
+					}
+				}
+			}
+			else if ( activeCount > 0 )
+			{
+				int nearChild = directionIsNegative[node.axis] ? node.offset : nodeIndex + 1;
+				int farChild = directionIsNegative[node.axis] ? nodeIndex + 1 : node.offset;
+
+				stack[stackSize] = farChild;
+				stackMask[stackSize] = nodeMask;
+				stackSize++;
+
+				nodeIndex = nearChild;
+				activeMask = nodeMask;
+				continue;
+			}
+
+			if ( stackSize == 0 )
+			{
+				break;
+			}
+
+			stackSize--;
+			nodeIndex = stack[stackSize];
+			activeMask = stackMask[stackSize];
+		}
+	}
+
+	for ( int lane = 0; lane < _packet.size; ++lane )
+	{
+		_t[lane] = minT[lane];
+		_shapeHit[lane] = shapeHit[lane];
+	}
+}
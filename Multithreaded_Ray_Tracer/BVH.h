@@ -0,0 +1,179 @@
+/// \file BVH.h
+/// \brief Class for the 'BVH' (bounding volume hierarchy) used to skip shapes a ray can't hit
+/// \author Thomas Hardy
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <memory>
+#include <vector>
+#include <glm.hpp>
+
+#include "Scene.h"
+#include "SphereSoA.h"
+#include "RayPacket.h"
+
+#define BVH_MAX_DEPTH (64)   // Macro for the size of the traversal stack, the builder stops splitting before this
+#define BVH_PACKET_MIN_ACTIVE (4)   // Macro for the fewest rays a packet can have left in a subtree before they carry on one at a time
+
+struct BVHNode   // 32 bytes so two nodes share a cache line
+{
+	glm::vec3 boundsMin;
+	int offset;   // Leaf: first entry in the primitive list. Interior: index of the second child, the first child always follows its parent
+	glm::vec3 boundsMax;
+	unsigned short count;   // Number of primitives in a leaf, 0 for interior nodes
+	unsigned short axis;   // Axis the node was split along, used to visit the nearer child first
+};
+
+class BVH
+{
+public:
+
+	BVH();
+
+	void Build(Scene &_scene);   // Bounded shapes go in the tree, anything else (planes) is tested by the scene. The scene has to outlive the tree
+
+	void BuildFromBounds(const std::vector<glm::vec3> &_boundsMin, const std::vector<glm::vec3> &_boundsMax);   // Builds over plain boxes, getPrimitives() then holds box indices in leaf order
+
+	bool ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_t, int *_shapeHit);   // _shapeHit is an index into the vector the tree was built from
+
+	bool AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _maxT);   // Shadow query, stops at the first hit closer than _maxT
+
+	void ClosestHitPacket(const RayPacket &_packet, float *_t, int *_shapeHit);   // ClosestHit for every lane of the packet, same results as tracing them one by one
+
+	template <typename LeafFunction>
+	void Traverse(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_maxT, bool _anyHit, LeafFunction _leafFunction, int _rootNode = 0);
+
+	template <typename LeafFunction>
+	void TraversePoint(glm::vec3 _point, float _margin, LeafFunction _leafFunction);   // Every leaf whose box, grown by _margin, holds _point
+
+	int getNodeCount() { return (int)m_nodes.size(); }
+
+	int getLeafWidth() { return m_leafWidth; }
+	void setLeafWidth( int _leafWidth ) { m_leafWidth = _leafWidth; }   // Primitives tested together in one go, leaves are filled up to this many
+
+	const std::vector<int>& getPrimitives() { return m_primitives; }
+
+private:
+
+	void ClosestHitFrom(int _rootNode, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_minT, int *_shapeHit);   // Bounded shapes only, starting from any node
+
+	bool OtherShapesClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _firstEntry, int _entryCount, float *_maxT, int *_shapeHit);   // Goes through the scene for any leaf entries that aren't spheres
+
+	int BuildNode(int _first, int _count, int _depth, const std::vector<glm::vec3> &_boundsMin, const std::vector<glm::vec3> &_boundsMax, std::vector<glm::vec3> &_centroids);
+
+	std::vector<BVHNode> m_nodes;   // Flattened depth first so a parent and its first child are next to each other
+	std::vector<int> m_primitives;   // Primitive indices in leaf order
+
+	int m_leafWidth;
+
+	Scene *m_scene;   // The scene the tree was built over, it tests the unbounded shapes and any leaf entry that isn't a sphere
+	SphereSoA m_spheres;   // The bounded spheres in leaf order, so a whole leaf goes through the SIMD kernel
+	std::vector<int> m_otherShapes;   // Leaf entries that aren't spheres
+};
+
+/// Calls _leafFunction(firstEntry, entryCount, &maxT) for every leaf the ray reaches before *_maxT, entries index getPrimitives().
+/// The function returns true when it found a hit and shortened maxT, with _anyHit set traversal stops there
+template <typename LeafFunction>
+void BVH::Traverse(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_maxT, bool _anyHit, LeafFunction _leafFunction, int _rootNode)
+{
+	if ( m_nodes.empty() )
+	{
+		return;
+	}
+
+	glm::vec3 inverseDirection = 1.0f / _rayDirection;
+	int directionIsNegative[3] = { inverseDirection.x < 0, inverseDirection.y < 0, inverseDirection.z < 0 };
+
+	int stack[BVH_MAX_DEPTH];
+	int stackSize = 0;
+	int nodeIndex = _rootNode;
+
+	while ( true )
+	{
+		const BVHNode &node = m_nodes[nodeIndex];
+
+		// Slab test, a ray starting inside the box still counts so spheres around the origin are found
+
+		glm::vec3 t0 = (node.boundsMin - _rayOrigin) * inverseDirection;
+		glm::vec3 t1 = (node.boundsMax - _rayOrigin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float entry = glm::max(glm::max(tNear.x, tNear.y), tNear.z);
+		float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, *_maxT));
+
+		if ( entry <= exit && exit >= 0.0f )
+		{
+			if ( node.count > 0 )
+			{
+				if ( _leafFunction(node.offset, (int)node.count, _maxT) && _anyHit )
+				{
+					return;
+				}
+			}
+			else if ( directionIsNegative[node.axis] )   // Visit the child nearer the ray first so later boxes get culled by a shorter maxT
+			{
+				stack[stackSize++] = nodeIndex + 1;
+				nodeIndex = node.offset;
+				continue;
+			}
+			else
+			{
+				stack[stackSize++] = node.offset;
+				nodeIndex = nodeIndex + 1;
+				continue;
+			}
+		}
+
+		if ( stackSize == 0 )
+		{
+			return;
+		}
+
+		nodeIndex = stack[--stackSize];
+	}
+}
+
+/// Calls _leafFunction(firstEntry, entryCount) for every leaf whose box, grown by _margin on each side, contains _point
+template <typename LeafFunction>
+void BVH::TraversePoint(glm::vec3 _point, float _margin, LeafFunction _leafFunction)
+{
+	if ( m_nodes.empty() )
+	{
+		return;
+	}
+
+	int stack[BVH_MAX_DEPTH];
+	int stackSize = 0;
+	int nodeIndex = 0;
+
+	while ( true )
+	{
+		const BVHNode &node = m_nodes[nodeIndex];
+
+		bool inside = glm::all(glm::greaterThanEqual(_point, node.boundsMin - _margin)) && glm::all(glm::lessThanEqual(_point, node.boundsMax + _margin));
+
+		if ( inside )
+		{
+			if ( node.count > 0 )
+			{
+				_leafFunction(node.offset, (int)node.count);
+			}
+			else
+			{
+				stack[stackSize++] = node.offset;
+				nodeIndex = nodeIndex + 1;
+				continue;
+			}
+		}
+
+		if ( stackSize == 0 )
+		{
+			return;
+		}
+
+		nodeIndex = stack[--stackSize];
+	}
+}
+#endif
@@ -0,0 +1,1658 @@
+/// @file Benchmark.cpp
+/// @brief Contains the benchmarks that can be ran from the main menu
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <thread>
+#include <string>
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Benchmark.h"
+#include "Sphere.h"
+#include "Shape.h"
+#include "Scene.h"
+#include "BVH.h"
+#include "SphereSoA.h"
+#include "RayPacket.h"
+#include "Plane.h"
+#include "Mesh.h"
+#include "Instance.h"
+#include "Renderer.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+#include "DirtyRegion.h"
+#include "AllocationCounter.h"
+#include "NumaTopology.h"
+#include "Checkpoint.h"
+
+namespace
+{
+	double SecondsSince(std::chrono::steady_clock::time_point _start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+	}
+
+	std::vector<std::shared_ptr<Shape>> CreateRandomSpheres(int _sphereCount, std::mt19937 &_random)
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector;
+
+		// Spheres fill a fixed box in front of the camera and shrink as the count goes up, so the picture stays about as busy
+
+		float radius = 4.0f / std::cbrt((float)_sphereCount);
+		std::uniform_real_distribution<float> spreadX(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> spreadY(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> spreadZ(-60.0f, -10.0f);
+
+		for ( int i = 0; i < _sphereCount; ++i )
+		{
+			glm::vec3 position = glm::vec3(spreadX(_random), spreadY(_random), spreadZ(_random));
+			shapeVector.push_back(std::make_shared<Sphere>(position, radius, glm::vec3(1.0f, 1.0f, 1.0f)));
+		}
+
+		return shapeVector;
+	}
+
+	std::vector<glm::vec3> CreateRayDirections(int _rayCount, std::mt19937 &_random)
+	{
+		std::vector<glm::vec3> directions;
+		std::uniform_real_distribution<float> screen(-1.0f, 1.0f);   // Same 90 degree field of view as the default Camera
+
+		for ( int i = 0; i < _rayCount; ++i )
+		{
+			directions.push_back(glm::normalize(glm::vec3(screen(_random), screen(_random), -1.0f)));
+		}
+
+		return directions;
+	}
+
+	float SphereHitTolerance(glm::vec3 _L, glm::vec3 _rayDirection, float _radius)   // How far apart two correct roundings of a sphere's t can be
+	{
+		// s^2 = L.L - delta^2 is only good to a few ulps of L.L, whether or not the multiplies and adds were fused into FMAs,
+		// and t = delta - sqrt(r^2 - s^2) magnifies that error as the ray nears the silhouette
+
+		float delta = dot(_L, _rayDirection);
+		float thc = std::sqrt(std::max(_radius * _radius - (dot(_L, _L) - delta * delta), 1e-12f));
+
+		return 1e-6f * std::abs(delta) + 4.0f * FLT_EPSILON * dot(_L, _L) / thc;
+	}
+
+	std::vector<unsigned char> ReadWholeFile(const std::string &_path)   // Empty if it couldn't be opened
+	{
+		std::ifstream ifs(_path, std::ios::in | std::ios::binary);
+
+		return std::vector<unsigned char>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	}
+
+	bool LinearClosestHit(const std::vector<std::shared_ptr<Shape>> &_shapeVector, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_t, int *_shapeHit)
+	{
+		float minT = INFINITY;
+		int shapeHit = -1;
+		float t0 = 0.0f;
+
+		for ( int k = 0; k < (int)_shapeVector.size(); ++k )   // The same scan DrawPixel did before the BVH
+		{
+			if ( _shapeVector[k]->Intersection(_rayOrigin, _rayDirection, &t0) && t0 < minT )
+			{
+				minT = t0;
+				shapeHit = k;
+			}
+		}
+
+		*_t = minT;
+		*_shapeHit = shapeHit;
+
+		return shapeHit != -1;
+	}
+
+	bool LinearAnyHit(const std::vector<std::shared_ptr<Shape>> &_shapeVector, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _maxT)
+	{
+		float t0 = 0.0f;
+
+		for ( int k = 0; k < (int)_shapeVector.size(); ++k )
+		{
+			if ( _shapeVector[k]->Intersection(_rayOrigin, _rayDirection, &t0) && t0 < _maxT )
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::vector<glm::vec3> CreateSphereRays(int _rayCount, glm::vec3 _centre, float _radius, float _minOffset, float _maxOffset, std::mt19937 &_random)
+	{
+		std::vector<glm::vec3> directions;
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> offset(_minOffset * _radius, _maxOffset * _radius);
+
+		// Each ray from the origin aims at a point beside the centre, offsets under the radius hit, over it miss and near it graze
+
+		for ( int i = 0; i < _rayCount; ++i )
+		{
+			float a = angle(_random);
+			float r = offset(_random);
+			directions.push_back(glm::normalize(_centre + glm::vec3(r * std::cos(a), r * std::sin(a), 0.0f)));
+		}
+
+		return directions;
+	}
+
+	std::shared_ptr<Mesh> CreateSphereMesh(int _rings, int _segments)   // Unit sphere around the origin made of triangles
+	{
+		std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(glm::vec3(0.82f, 0.90f, 1.00f));
+
+		for ( int ring = 0; ring <= _rings; ++ring )
+		{
+			float polar = 3.14159265f * ring / _rings;
+
+			for ( int segment = 0; segment < _segments; ++segment )
+			{
+				float azimuth = 6.2831853f * segment / _segments;
+				mesh->AddVertex(glm::vec3(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth)));
+			}
+		}
+
+		for ( int ring = 0; ring < _rings; ++ring )
+		{
+			for ( int segment = 0; segment < _segments; ++segment )
+			{
+				unsigned int a = ring * _segments + segment;
+				unsigned int b = ring * _segments + (segment + 1) % _segments;
+				unsigned int c = a + _segments;
+				unsigned int d = b + _segments;
+
+				mesh->AddTriangle(a, c, d);
+				mesh->AddTriangle(a, d, b);
+			}
+		}
+
+		mesh->Build();
+
+		return mesh;
+	}
+
+	glm::mat4 CreateRandomTransform(glm::vec3 _boxMin, glm::vec3 _boxMax, float _minScale, float _maxScale, std::mt19937 &_random)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		glm::vec3 position = _boxMin + (_boxMax - _boxMin) * glm::vec3(unit(_random), unit(_random), unit(_random));
+		glm::vec3 axis = glm::normalize(glm::vec3(unit(_random), unit(_random), unit(_random)) + 0.1f);
+		float angle = 6.2831853f * unit(_random);
+		float scale = _minScale + (_maxScale - _minScale) * unit(_random);
+
+		return glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), position), angle, axis), glm::vec3(scale));
+	}
+
+	std::vector<glm::vec3> CreatePlaneRays(int _rayCount, float _minY, float _maxY, std::mt19937 &_random)
+	{
+		std::vector<glm::vec3> directions;
+		std::uniform_real_distribution<float> spreadX(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> spreadY(_minY, _maxY);   // The floor is below the camera, so only rays heading down can hit it
+
+		for ( int i = 0; i < _rayCount; ++i )
+		{
+			directions.push_back(glm::normalize(glm::vec3(spreadX(_random), spreadY(_random), -1.0f)));
+		}
+
+		return directions;
+	}
+
+	// Hardware cache misses from the CPU's counters, for this thread and every thread it starts after Open. Only on Linux, and virtual machines often hide the counters
+
+	class CacheMissCounter
+	{
+	public:
+
+		CacheMissCounter() { m_file = -1; }
+		~CacheMissCounter() { Close(); }
+
+		bool Open()
+		{
+#if defined(__linux__)
+			perf_event_attr attributes = perf_event_attr();
+			attributes.size = sizeof(attributes);
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = PERF_COUNT_HW_CACHE_MISSES;   // Last level cache misses on most CPUs
+			attributes.disabled = 1;
+			attributes.inherit = 1;   // Threads started later are counted too, their counts come back when they exit
+			attributes.exclude_kernel = 1;
+
+			m_file = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+			return m_file >= 0;
+		}
+
+		void Start()
+		{
+#if defined(__linux__)
+			if ( m_file >= 0 )
+			{
+				ioctl(m_file, PERF_EVENT_IOC_RESET, 0);
+				ioctl(m_file, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		void Stop()
+		{
+#if defined(__linux__)
+			if ( m_file >= 0 )
+			{
+				ioctl(m_file, PERF_EVENT_IOC_DISABLE, 0);
+			}
+#endif
+		}
+
+		long long Read()   // Call once the threads being counted have exited, -1 if there is no counter
+		{
+			long long count = -1;
+#if defined(__linux__)
+			if ( m_file >= 0 && read(m_file, &count, sizeof(count)) != sizeof(count) )
+			{
+				count = -1;
+			}
+#endif
+			return count;
+		}
+
+		void Close()
+		{
+#if defined(__linux__)
+			if ( m_file >= 0 )
+			{
+				close(m_file);
+			}
+#endif
+			m_file = -1;
+		}
+
+	private:
+
+		int m_file;
+	};
+
+	// Calls _function once to warm the caches, then _repetitions more times, each call doing _itemsPerCall items.
+	// Prints the mean time per item, the standard deviation between repetitions, the best repetition and the throughput
+
+	void ReportKernel(const std::string &_name, int _repetitions, long long _itemsPerCall, const std::function<void()> &_function)
+	{
+		_function();
+
+		std::vector<double> seconds;
+
+		for ( int i = 0; i < _repetitions; ++i )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			_function();
+			seconds.push_back(SecondsSince(start));
+		}
+
+		double mean = 0.0;
+		double best = seconds[0];
+
+		for ( double time : seconds )
+		{
+			mean += time / _repetitions;
+			best = std::min(best, time);
+		}
+
+		double variance = 0.0;
+
+		for ( double time : seconds )
+		{
+			variance += (time - mean) * (time - mean) / std::max(1, _repetitions - 1);
+		}
+
+		double deviation = std::sqrt(variance);
+
+		std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(30) << _name << std::right << std::setw(8) << _repetitions
+			<< std::setw(12) << mean * 1e9 / _itemsPerCall << std::setw(12) << deviation * 1e9 / _itemsPerCall << std::setw(10) << 100.0 * deviation / mean
+			<< std::setw(12) << best * 1e9 / _itemsPerCall << std::setw(14) << _itemsPerCall / mean / 1e6 << std::endl;
+	}
+}
+
+void BenchmarkBVH()
+{
+	const int sphereCounts[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 1024, 4096, 16384, 65536, 262144, 1048576 };
+	const int bvhRayCount = 1 << 16;
+	const glm::vec3 rayOrigin = glm::vec3(0, 0, 0);
+	const glm::vec3 lightDirection = glm::normalize(glm::vec3(25, 155, -2));   // Towards the scene light
+
+	std::mt19937 random(1234);   // Fixed seed so runs are comparable
+	std::vector<glm::vec3> directions = CreateRayDirections(bvhRayCount, random);
+
+	int crossover = -1;
+	int mismatches = 0;
+
+	std::cout << std::setw(10) << "Spheres" << std::setw(12) << "Build ms" << std::setw(14) << "Linear ns" << std::setw(14) << "BVH ns"
+		<< std::setw(16) << "Shadow lin ns" << std::setw(16) << "Shadow BVH ns" << std::setw(10) << "Speedup" << std::endl;
+
+	for ( int sphereCount : sphereCounts )
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector = CreateRandomSpheres(sphereCount, random);
+		Scene scene(shapeVector);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		BVH bvh;
+		bvh.Build(scene);
+
+		double buildSeconds = SecondsSince(start);
+
+		// The linear scan gets fewer rays as the scene grows so the big scenes still finish, results are per ray either way
+
+		int linearRayCount = (int)glm::clamp((1 << 24) / sphereCount, 64, bvhRayCount);
+		volatile float sink = 0.0f;   // Keeps the optimiser from dropping the loops
+		float t = 0.0f;
+		int shapeHit = -1;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < linearRayCount; ++i )
+		{
+			LinearClosestHit(shapeVector, rayOrigin, directions[i], &t, &shapeHit);
+			sink = sink + shapeHit;
+		}
+
+		double linearNs = SecondsSince(start) * 1e9 / linearRayCount;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < bvhRayCount; ++i )
+		{
+			bvh.ClosestHit(rayOrigin, directions[i], &t, &shapeHit);
+			sink = sink + shapeHit;
+		}
+
+		double bvhNs = SecondsSince(start) * 1e9 / bvhRayCount;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < linearRayCount; ++i )
+		{
+			sink = sink + LinearAnyHit(shapeVector, directions[i] * 30.0f, lightDirection, INFINITY);   // Shadow rays start out in the middle of the spheres
+		}
+
+		double shadowLinearNs = SecondsSince(start) * 1e9 / linearRayCount;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < bvhRayCount; ++i )
+		{
+			sink = sink + bvh.AnyHit(directions[i] * 30.0f, lightDirection, INFINITY);
+		}
+
+		double shadowBvhNs = SecondsSince(start) * 1e9 / bvhRayCount;
+
+		for ( int i = 0; i < linearRayCount; ++i )   // Both paths have to agree on what was hit or the timings mean nothing
+		{
+			float linearT = 0.0f;
+			int linearHit = -1;
+
+			LinearClosestHit(shapeVector, rayOrigin, directions[i], &linearT, &linearHit);
+			bvh.ClosestHit(rayOrigin, directions[i], &t, &shapeHit);
+
+			if ( linearHit != shapeHit && linearT != t )
+			{
+				mismatches++;
+			}
+		}
+
+		if ( crossover == -1 && bvhNs < linearNs )
+		{
+			crossover = sphereCount;
+		}
+
+		std::cout << std::fixed << std::setprecision(1) << std::setw(10) << sphereCount << std::setw(12) << buildSeconds * 1000.0
+			<< std::setw(14) << linearNs << std::setw(14) << bvhNs << std::setw(16) << shadowLinearNs << std::setw(16) << shadowBvhNs
+			<< std::setw(9) << linearNs / bvhNs << "x" << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+
+	if ( crossover != -1 )
+	{
+		std::cout << "The BVH overtakes the linear scan at " << crossover << " spheres" << std::endl;
+	}
+	else
+	{
+		std::cout << "The linear scan was faster at every sphere count tested" << std::endl;
+	}
+
+	std::cout << "Rays where the two disagreed: " << mismatches << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkSphereKernel()
+{
+	const int sphereCounts[] = { 8, 64, 1024, 16384 };
+	const int rayCount = 1 << 14;
+	const glm::vec3 rayOrigin = glm::vec3(0, 0, 0);
+
+	std::mt19937 random(1234);
+	std::vector<glm::vec3> directions = CreateRayDirections(rayCount, random);
+
+	std::cout << "Sphere kernel: " << SphereSoA::getKernelName() << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::cout << std::setw(10) << "Spheres" << std::setw(14) << "Virtual ns" << std::setw(14) << "SoA scalar ns" << std::setw(14) << "SoA SIMD ns"
+		<< std::setw(10) << "Speedup" << std::setw(12) << "Mismatches" << std::setw(10) << "Grazing" << std::endl;
+
+	bool parityPassed = true;
+
+	for ( int sphereCount : sphereCounts )
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector = CreateRandomSpheres(sphereCount, random);
+		SphereSoA spheres;
+
+		for ( int i = 0; i < sphereCount; ++i )
+		{
+			Sphere *sphere = static_cast<Sphere*>(shapeVector[i].get());
+			spheres.Add(sphere->getPosition(), sphere->getRadius());
+		}
+
+		// Parity against the scalar fallback and Sphere::Intersection. The compiler is free to fuse the scalar paths' multiplies and adds into FMAs
+		// where the kernel rounds each one, and the kernel rejects on s^2 > r^2 where the original rejects on s > r, so t only has to agree to within
+		// rounding. A ray within rounding of a silhouette, or of two spheres the same distance away, may land either way, those are counted apart as grazing
+
+		auto compareHits = [&](int _hitA, float _tA, int _hitB, float _tB, glm::vec3 _direction)   // 0 if they agree, 1 if grazing, 2 if they don't
+		{
+			auto tolerance = [&](int _sphere)
+			{
+				return SphereHitTolerance(spheres.getCentre(_sphere) - rayOrigin, _direction, static_cast<Sphere*>(shapeVector[_sphere].get())->getRadius());
+			};
+
+			if ( _hitA == _hitB )
+			{
+				return _hitA == -1 || std::abs(_tA - _tB) <= tolerance(_hitA) ? 0 : 2;
+			}
+
+			if ( _hitA != -1 && _hitB != -1 )
+			{
+				return std::abs(_tA - _tB) <= std::max(tolerance(_hitA), tolerance(_hitB)) ? 1 : 2;
+			}
+
+			int sphere = _hitA != -1 ? _hitA : _hitB;
+			glm::vec3 L = spheres.getCentre(sphere) - rayOrigin;
+			float delta = dot(L, _direction);
+			float s2 = dot(L, L) - delta * delta;
+			float radius = static_cast<Sphere*>(shapeVector[sphere].get())->getRadius();
+
+			return std::abs(s2 - radius * radius) <= 1e-5f * radius * radius + 4.0f * FLT_EPSILON * dot(L, L) ? 1 : 2;   // s^2 is only good to a few ulps of L.L
+		};
+
+		int mismatches = 0;
+		int grazing = 0;
+
+		for ( int i = 0; i < rayCount; ++i )
+		{
+			float linearT = 0.0f;
+			int linearHit = -1;
+			float simdT = 0.0f;
+			int simdHit = -1;
+			float scalarT = 0.0f;
+			int scalarHit = -1;
+
+			LinearClosestHit(shapeVector, rayOrigin, directions[i], &linearT, &linearHit);
+			spheres.ClosestHit(rayOrigin, directions[i], 0, sphereCount, &simdT, &simdHit);
+			spheres.ClosestHitScalar(rayOrigin, directions[i], 0, sphereCount, &scalarT, &scalarHit);
+
+			int result = std::max(compareHits(simdHit, simdT, scalarHit, scalarT, directions[i]), compareHits(simdHit, simdT, linearHit, linearT, directions[i]));
+
+			mismatches += result == 2;
+			grazing += result == 1;
+		}
+
+		parityPassed = parityPassed && mismatches == 0;
+
+		volatile float sink = 0.0f;
+		float t = 0.0f;
+		int sphereHit = -1;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < rayCount; ++i )
+		{
+			LinearClosestHit(shapeVector, rayOrigin, directions[i], &t, &sphereHit);
+			sink = sink + t;
+		}
+
+		double virtualNs = SecondsSince(start) * 1e9 / rayCount;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < rayCount; ++i )
+		{
+			spheres.ClosestHitScalar(rayOrigin, directions[i], 0, sphereCount, &t, &sphereHit);
+			sink = sink + t;
+		}
+
+		double scalarNs = SecondsSince(start) * 1e9 / rayCount;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( int i = 0; i < rayCount; ++i )
+		{
+			spheres.ClosestHit(rayOrigin, directions[i], 0, sphereCount, &t, &sphereHit);
+			sink = sink + t;
+		}
+
+		double simdNs = SecondsSince(start) * 1e9 / rayCount;
+
+		std::cout << std::fixed << std::setprecision(1) << std::setw(10) << sphereCount << std::setw(14) << virtualNs << std::setw(14) << scalarNs
+			<< std::setw(14) << simdNs << std::setw(9) << virtualNs / simdNs << "x" << std::setw(12) << mismatches << std::setw(10) << grazing << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << (parityPassed ? "Parity check passed" : "Parity check FAILED") << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkRayPackets()
+{
+	const int sphereCounts[] = { 8, 64, 1024, 16384 };
+	const int packetSizes[] = { 4, 8, 16 };
+	const int gridSize = 512;   // Primary rays for a 512x512 image, so neighbouring rays are as close as they are in TraceHits
+	const glm::vec3 rayOrigin = glm::vec3(0, 0, 0);
+
+	std::mt19937 random(1234);
+
+	std::cout << std::setw(10) << "Spheres" << std::setw(14) << "Single Mray/s";
+
+	for ( int packetSize : packetSizes )
+	{
+		std::cout << std::setw(11) << "Packet " << std::setw(2) << packetSize;
+	}
+
+	std::cout << std::setw(12) << "Mismatches" << std::endl;
+
+	bool parityPassed = true;
+
+	for ( int sphereCount : sphereCounts )
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector = CreateRandomSpheres(sphereCount, random);
+		Scene scene(shapeVector);
+		BVH bvh;
+		bvh.Build(scene);
+
+		volatile float sink = 0.0f;
+		float t = 0.0f;
+		int shapeHit = -1;
+
+		std::vector<float> singleT(gridSize * gridSize);
+		std::vector<int> singleHit(gridSize * gridSize);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for ( int y = 0; y < gridSize; ++y )
+		{
+			for ( int x = 0; x < gridSize; ++x )
+			{
+				glm::vec3 direction = glm::normalize(glm::vec3((x + 0.5f) * 2.0f / gridSize - 1.0f, 1.0f - (y + 0.5f) * 2.0f / gridSize, -1.0f));
+				bvh.ClosestHit(rayOrigin, direction, &t, &shapeHit);
+				singleT[y * gridSize + x] = t;
+				singleHit[y * gridSize + x] = shapeHit;
+				sink = sink + t;
+			}
+		}
+
+		double singleRate = gridSize * gridSize / SecondsSince(start) / 1e6;
+
+		std::cout << std::fixed << std::setprecision(1) << std::setw(10) << sphereCount << std::setw(14) << singleRate;
+
+		int mismatches = 0;
+
+		for ( int packetSize : packetSizes )
+		{
+			int blockWidth = packetSize >= 8 ? 4 : 2;   // Same block shapes as TraceHits
+			int blockHeight = packetSize / blockWidth;
+
+			RayPacket packet;
+			packet.origin = rayOrigin;
+			packet.size = packetSize;
+
+			float packetT[RAY_PACKET_MAX];
+			int packetHit[RAY_PACKET_MAX];
+
+			start = std::chrono::steady_clock::now();
+
+			for ( int blockY = 0; blockY < gridSize; blockY += blockHeight )
+			{
+				for ( int blockX = 0; blockX < gridSize; blockX += blockWidth )
+				{
+					for ( int lane = 0; lane < packetSize; ++lane )
+					{
+						int x = blockX + lane % blockWidth;
+						int y = blockY + lane / blockWidth;
+						glm::vec3 direction = glm::normalize(glm::vec3((x + 0.5f) * 2.0f / gridSize - 1.0f, 1.0f - (y + 0.5f) * 2.0f / gridSize, -1.0f));
+
+						packet.directionX[lane] = direction.x;
+						packet.directionY[lane] = direction.y;
+						packet.directionZ[lane] = direction.z;
+					}
+
+					bvh.ClosestHitPacket(packet, packetT, packetHit);
+
+					for ( int lane = 0; lane < packetSize; ++lane )   // Every lane has to land on the same shape at the same t as the single ray
+					{
+						int pixel = (blockY + lane / blockWidth) * gridSize + blockX + lane % blockWidth;
+
+						if ( packetHit[lane] != singleHit[pixel] || (packetHit[lane] != -1 && packetT[lane] != singleT[pixel]) )
+						{
+							mismatches++;
+						}
+
+						sink = sink + packetT[lane];
+					}
+				}
+			}
+
+			double packetRate = gridSize * gridSize / SecondsSince(start) / 1e6;
+
+			std::cout << std::setw(9) << packetRate << " (" << std::setprecision(2) << packetRate / singleRate << "x)" << std::setprecision(1);
+		}
+
+		parityPassed = parityPassed && mismatches == 0;
+
+		std::cout << std::setw(12) << mismatches << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Packet rates include building the packets and checking them against the single rays" << std::endl;
+	std::cout << (parityPassed ? "Parity check passed" : "Parity check FAILED") << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkKernels()
+{
+	const int rayCount = 1 << 12;
+	const int width = 800;
+	const int height = 800;
+	const glm::vec3 rayOrigin = glm::vec3(0, 0, 0);
+	const glm::vec3 sphereCentre = glm::vec3(0, 0, -10);
+	const float sphereRadius = 2.0f;
+
+	std::mt19937 random(1234);   // Fixed seed so runs are comparable
+	volatile float sink = 0.0f;
+
+	std::cout << std::left << std::setw(30) << "Kernel" << std::right << std::setw(8) << "Reps" << std::setw(12) << "ns/op" << std::setw(12) << "+/- ns"
+		<< std::setw(10) << "Spread %" << std::setw(12) << "Best ns" << std::setw(14) << "Mitems/s" << std::endl;
+
+	// Intersection tests, one op is one ray against one shape, called directly rather than through Shape
+
+	Sphere sphere(sphereCentre, sphereRadius, glm::vec3(1.0f, 1.0f, 1.0f));
+	Plane plane(glm::vec3(0, -4, 0), glm::vec3(0, 1, 0), glm::vec3(0.57f, 0.57f, 0.57f));
+
+	const char *mixNames[] = { "hit", "miss", "grazing" };
+	std::vector<glm::vec3> sphereRays[3] =
+	{
+		CreateSphereRays(rayCount, sphereCentre, sphereRadius, 0.0f, 0.9f, random),
+		CreateSphereRays(rayCount, sphereCentre, sphereRadius, 1.5f, 3.0f, random),
+		CreateSphereRays(rayCount, sphereCentre, sphereRadius, 0.999f, 1.001f, random)
+	};
+	std::vector<glm::vec3> planeRays[3] =
+	{
+		CreatePlaneRays(rayCount, -1.0f, -0.2f, random),
+		CreatePlaneRays(rayCount, 0.2f, 1.0f, random),
+		CreatePlaneRays(rayCount, -0.001f, -0.0001f, random)   // Nearly parallel to the floor
+	};
+
+	for ( int mix = 0; mix < 3; ++mix )
+	{
+		const std::vector<glm::vec3> &directions = sphereRays[mix];
+
+		ReportKernel(std::string("Sphere::Intersection ") + mixNames[mix], 50, rayCount, [&]()
+		{
+			float t = 0.0f;
+			float total = 0.0f;   // Summed locally, a volatile add per ray would be all the loop measured
+
+			for ( const glm::vec3 &direction : directions )
+			{
+				total += sphere.Intersection(rayOrigin, direction, &t) ? t : 0.0f;
+			}
+
+			sink = sink + total;
+		});
+	}
+
+	for ( int mix = 0; mix < 3; ++mix )
+	{
+		const std::vector<glm::vec3> &directions = planeRays[mix];
+
+		ReportKernel(std::string("Plane::Intersection ") + mixNames[mix], 50, rayCount, [&]()
+		{
+			float t = 0.0f;
+			float total = 0.0f;
+
+			for ( const glm::vec3 &direction : directions )
+			{
+				total += plane.Intersection(rayOrigin, direction, &t) ? t : 0.0f;
+			}
+
+			sink = sink + total;
+		});
+	}
+
+	// The render's own pieces on the demo scene, one op is one pixel
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	settings.width = width;
+	settings.height = height;
+
+	Camera &camera = scene.getCamera();
+	camera.setResolution(width, height);
+
+	HitBuffer hits(width, height);
+	Framebuffer image(width, height);
+
+	TraceHits(0, width, 0, height, scene, bvh, settings, hits);   // Shading reads the whole frame's hits
+
+	ReportKernel("Camera::PixelDirection", 20, width * height, [&]()
+	{
+		float total = 0.0f;
+
+		for ( int y = 0; y < height; ++y )
+		{
+			for ( int x = 0; x < width; ++x )
+			{
+				total += camera.PixelDirection(x, y).x;
+			}
+		}
+
+		sink = sink + total;
+	});
+
+	ReportKernel("ShadePixel", 10, width * height, [&]()
+	{
+		float total = 0.0f;
+
+		for ( int y = 0; y < height; ++y )
+		{
+			for ( int x = 0; x < width; ++x )
+			{
+				total += ShadePixel(rayOrigin, camera.PixelDirection(x, y), hits.getHit(x, y), scene, bvh).x;
+			}
+		}
+
+		sink = sink + total;
+	});
+
+	int tileSize = settings.tileSize;
+	int tileX = (width / 2 / tileSize) * tileSize;   // The middle tile has spheres, the floor and sky in it
+	int tileY = (height / 2 / tileSize) * tileSize;
+
+	ReportKernel("Tile (trace and shade)", 200, tileSize * tileSize, [&]()
+	{
+		TraceHits(tileX, tileX + tileSize, tileY, tileY + tileSize, scene, bvh, settings, hits);
+		sink = sink + (float)ShadeHits(tileX, tileX + tileSize, tileY, tileY + tileSize, scene, bvh, hits, image, nullptr);
+	});
+
+	ShadeHits(0, width, 0, height, scene, bvh, hits, image, nullptr);
+
+	// Output, EncodePPM and WriteFile together are what the old OutputImage did
+
+	std::vector<unsigned char> file;
+
+	ReportKernel("EncodePPM", 10, width * height, [&]()
+	{
+		EncodePPM(image, &file);
+		sink = sink + file[file.size() - 1];
+	});
+
+	const char *benchmarkPath = "BenchmarkImage.ppm";
+
+	ReportKernel("WriteFile (one op per byte)", 10, (long long)file.size(), [&]()
+	{
+		sink = sink + (float)WriteFile(benchmarkPath, file);
+	});
+
+	std::remove(benchmarkPath);
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Spread is the standard deviation between repetitions as a percentage of the mean, compare the best column when it is high" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkThreadScaling()
+{
+	const int tileSizes[] = { 8, 16, 32, 64, 128 };
+	const int frameCount = 5;   // Timed frames per configuration, after one untimed warm up frame
+	const char *csvPath = "../ThreadScaling.csv";
+
+	int threadsAvailable = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+
+	for ( int threads = 1; threads < threadsAvailable; threads *= 2 )   // Doubling keeps the sweep short on big machines, the full count is always tried
+	{
+		threadCounts.push_back(threads);
+	}
+
+	threadCounts.push_back(threadsAvailable);
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	HitBuffer hits(settings.width, settings.height);
+	Framebuffer image(settings.width, settings.height);
+
+	std::ofstream csv(csvPath, std::ios::out);
+	std::string header = "threads,tile_size,median_frame_ms,speedup,efficiency,load_imbalance,idle_percent";
+
+	csv << header << "\n";
+	std::cout << header << std::endl;
+
+	std::vector<double> oneThreadSeconds(sizeof(tileSizes) / sizeof(tileSizes[0]), 0.0);   // Speedup is against one thread at the same tile size
+
+	for ( int threads : threadCounts )
+	{
+		ThreadPool pool(threads);
+
+		for ( size_t tile = 0; tile < oneThreadSeconds.size(); ++tile )
+		{
+			settings.tileSize = tileSizes[tile];
+
+			TileScheduler scheduler(pool, settings.tileSize);
+
+			RenderStats warmUp(threads, settings.width, settings.height, settings.tileSize);
+			RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, warmUp);
+
+			RenderStats stats(threads, settings.width, settings.height, settings.tileSize);
+			std::vector<double> frameSeconds;
+
+			for ( int frame = 0; frame < frameCount; ++frame )
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+				frameSeconds.push_back(SecondsSince(start));
+			}
+
+			std::sort(frameSeconds.begin(), frameSeconds.end());
+
+			double median = frameSeconds[frameCount / 2];   // Less thrown by one frame the OS got in the way of than the mean
+
+			if ( threads == 1 )
+			{
+				oneThreadSeconds[tile] = median;
+			}
+
+			double speedup = oneThreadSeconds[tile] / median;
+
+			std::ostringstream row;
+			row << std::fixed << std::setprecision(3) << threads << "," << settings.tileSize << "," << median * 1000.0 << "," << speedup << "," << speedup / threads
+				<< "," << stats.getLoadImbalance() << "," << 100.0 * stats.getIdleFraction();
+
+			csv << row.str() << "\n";
+			std::cout << row.str() << std::endl;
+		}
+	}
+
+	csv.close();
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Load imbalance is the busiest thread's time in tiles over the average, 1.000 is even. Idle is time in the passes spent outside tiles" << std::endl;
+	std::cout << "Written to " << csvPath << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkInstancing()
+{
+	const int instanceCounts[] = { 1000, 100000, 1000000 };
+	const int rayCount = 1 << 16;
+	const int parityRayCount = 1 << 12;
+	const glm::vec3 rayOrigin = glm::vec3(0, 0, 0);
+
+	std::mt19937 random(1234);   // Fixed seed so runs are comparable
+
+	std::shared_ptr<Sphere> sphere = std::make_shared<Sphere>(glm::vec3(0, 0, 0), 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+	std::shared_ptr<Mesh> mesh = CreateSphereMesh(32, 64);
+
+	// Parity, an instance has to hit where the same shape placed straight into world space does
+
+	int mismatches = 0;
+
+	for ( int trial = 0; trial < 16; ++trial )
+	{
+		glm::mat4 transform = CreateRandomTransform(glm::vec3(-5, -5, -20), glm::vec3(5, 5, -10), 0.5f, 2.0f, random);
+		glm::vec3 centre = glm::vec3(transform[3]);
+		float radius = glm::length(glm::vec3(transform[0]));
+
+		Instance sphereInstance(sphere, transform);
+		Instance meshInstance(mesh, transform);
+		Sphere worldSphere(centre, radius, sphere->getColour());
+
+		std::vector<glm::vec3> hitRays = CreateSphereRays(parityRayCount, centre, radius, 0.0f, 0.9f, random);
+		std::vector<glm::vec3> missRays = CreateSphereRays(parityRayCount, centre, radius, 1.5f, 3.0f, random);   // Seen at a slant the gap shrinks, so misses aim well clear
+
+		for ( int i = 0; i < parityRayCount * 2; ++i )
+		{
+			glm::vec3 direction = i < parityRayCount ? hitRays[i] : missRays[i - parityRayCount];
+
+			float instanceT = 0.0f;
+			float worldT = 0.0f;
+			bool instanceHit = sphereInstance.Intersection(rayOrigin, direction, &instanceT);
+			bool worldHit = worldSphere.Intersection(rayOrigin, direction, &worldT);
+
+			if ( instanceHit != worldHit || (instanceHit && std::fabs(instanceT - worldT) > 1e-3f * worldT) )
+			{
+				mismatches++;
+			}
+			else if ( instanceHit )
+			{
+				glm::vec3 p0 = rayOrigin + worldT * direction;
+
+				if ( glm::dot(glm::normalize(sphereInstance.Surface(p0).normal), glm::normalize(worldSphere.Surface(p0).normal)) < 0.999f )
+				{
+					mismatches++;
+				}
+			}
+
+			// The mesh is a faceted sphere just inside the real one, so it hits the same rays a little further along.
+			// Its facets sit up to about 0.6% of the radius inside, more than that along a ray that meets them at a slant
+
+			float meshT = 0.0f;
+			bool meshHit = meshInstance.Intersection(rayOrigin, direction, &meshT);
+
+			if ( meshHit != worldHit || (meshHit && (meshT < worldT * (1.0f - 1e-3f) || meshT > worldT * (1.0f + 1e-3f) + 0.05f * radius)) )
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	std::cout << "Shared mesh: " << mesh->getTriangleCount() << " triangles, " << mesh->getMemoryBytes() / 1024 << " KB stored once" << std::endl;
+	std::cout << "Instance record: " << sizeof(Instance) << " bytes" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::cout << std::setw(10) << "Instances" << std::setw(12) << "Build ms" << std::setw(16) << "Bytes/instance" << std::setw(12) << "Total MB" << std::setw(12) << "Mray/s" << std::endl;
+
+	std::vector<glm::vec3> directions = CreateRayDirections(rayCount, random);
+
+	for ( int instanceCount : instanceCounts )
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector;
+
+		for ( int i = 0; i < instanceCount; ++i )   // Half point at the mesh and half at the sphere, every one at its own place, angle and size
+		{
+			std::shared_ptr<Shape> geometry = i % 2 == 0 ? std::static_pointer_cast<Shape>(mesh) : std::static_pointer_cast<Shape>(sphere);
+			shapeVector.push_back(std::make_shared<Instance>(geometry, CreateRandomTransform(glm::vec3(-40, -40, -120), glm::vec3(40, 40, -10), 0.1f, 0.5f, random)));
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		Scene scene(shapeVector);
+		BVH bvh;
+		bvh.Build(scene);
+
+		double buildSeconds = SecondsSince(start);
+
+		// Each instance costs its record, the shared_ptr to it held by the scene and its share of the BVH, the geometry isn't copied
+
+		size_t perInstance = sizeof(Instance) + sizeof(std::shared_ptr<Shape>);
+		size_t bvhBytes = bvh.getNodeCount() * sizeof(BVHNode) + bvh.getPrimitives().size() * sizeof(int);
+		double totalBytes = (double)perInstance * instanceCount + bvhBytes + mesh->getMemoryBytes() + sizeof(Sphere);
+
+		volatile float sink = 0.0f;
+		float t = 0.0f;
+		int shapeHit = -1;
+
+		start = std::chrono::steady_clock::now();
+
+		for ( const glm::vec3 &direction : directions )
+		{
+			bvh.ClosestHit(rayOrigin, direction, &t, &shapeHit);
+			sink = sink + t;
+		}
+
+		double rayRate = rayCount / SecondsSince(start) / 1e6;
+
+		std::cout << std::fixed << std::setprecision(1) << std::setw(10) << instanceCount << std::setw(12) << buildSeconds * 1000.0 << std::setw(16) << (perInstance * instanceCount + bvhBytes) / (double)instanceCount
+			<< std::setw(12) << totalBytes / (1024.0 * 1024.0) << std::setw(12) << rayRate << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Bytes per instance counts the instance record, the scene's pointer to it and its share of the BVH" << std::endl;
+	std::cout << (mismatches == 0 ? "Parity check passed" : "Parity check FAILED") << " (" << mismatches << " mismatches)" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkDirtyTiles()
+{
+	const int repetitions = 3;   // Each render is timed this many times and the median kept
+
+	// Edits like the layout tool makes, one sphere at a time, each starting from where the last one left the scene
+
+	const int editShapes[] = { 0, 1, 2, 3, 0 };
+	const glm::vec3 editOffsets[] = { glm::vec3(0.5f, 0, 0), glm::vec3(0, 1.0f, 0), glm::vec3(0, 0, -2.0f), glm::vec3(-1.0f, 0, 0), glm::vec3(-0.5f, 0, 0) };
+	const char *editNames[] = { "Green right 0.5", "Yellow up 1", "Orange back 2", "Purple left 1", "Green back left" };
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+	TileScheduler scheduler(pool, settings.tileSize);
+	RenderStats stats(pool.getThreadCount(), settings.width, settings.height, settings.tileSize);   // Not reported, RenderTiles needs somewhere to put its timings
+
+	HitBuffer hits(settings.width, settings.height);   // Kept up to date one edit at a time
+	Framebuffer image(settings.width, settings.height);
+
+	HitBuffer fullHits(settings.width, settings.height);   // Rendered from nothing after every edit to check the other against
+	Framebuffer fullImage(settings.width, settings.height);
+
+	RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+
+	DirtyRegion region(settings.width, settings.height, settings.tileSize);
+
+	std::vector<unsigned char> row(settings.width * 3);
+	std::vector<unsigned char> fullRow(settings.width * 3);
+
+	std::cout << std::left << std::setw(18) << "Edit" << std::right << std::setw(12) << "Tiles" << std::setw(10) << "Pixels" << std::setw(16) << "Dirty tiles ms"
+		<< std::setw(16) << "Full frame ms" << std::setw(10) << "Speedup" << std::setw(16) << "Pixels differ" << std::endl;
+
+	for ( size_t edit = 0; edit < sizeof(editShapes) / sizeof(editShapes[0]); ++edit )
+	{
+		Sphere &sphere = scene.getSphere(editShapes[edit]);
+
+		region.Clear();
+		region.MarkShape(scene, editShapes[edit]);   // Where it was
+
+		sphere.setPosition(sphere.getPosition() + editOffsets[edit]);
+
+		region.MarkShape(scene, editShapes[edit]);   // Where it is now
+		bvh.Build(scene);   // A handful of spheres rebuild faster than a refit would be worth
+
+		std::vector<Tile> tiles = region.getTiles();
+		long long dirtyPixels = 0;
+
+		for ( size_t i = 0; i < tiles.size(); ++i )
+		{
+			dirtyPixels += (long long)(tiles[i].maxX - tiles[i].minX) * (tiles[i].maxY - tiles[i].minY);
+		}
+
+		std::vector<double> dirtySeconds;
+		std::vector<double> fullSeconds;
+
+		for ( int repetition = 0; repetition < repetitions; ++repetition )   // Rendering the same tiles again gives the same pixels, so repeating is safe
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			RenderTiles(tiles, scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+			dirtySeconds.push_back(SecondsSince(start));
+
+			start = std::chrono::steady_clock::now();
+			RenderFrame(scene, bvh, settings, fullHits, fullImage, nullptr, scheduler, stats);
+			fullSeconds.push_back(SecondsSince(start));
+		}
+
+		std::sort(dirtySeconds.begin(), dirtySeconds.end());
+		std::sort(fullSeconds.begin(), fullSeconds.end());
+
+		int differing = 0;   // Compared as saved, any pixel the region missed shows up here
+
+		for ( int y = 0; y < settings.height; ++y )
+		{
+			image.QuantizeRow(y, 0, settings.width, row.data());
+			fullImage.QuantizeRow(y, 0, settings.width, fullRow.data());
+
+			for ( int x = 0; x < settings.width; ++x )
+			{
+				differing += row[x * 3] != fullRow[x * 3] || row[x * 3 + 1] != fullRow[x * 3 + 1] || row[x * 3 + 2] != fullRow[x * 3 + 2];
+			}
+		}
+
+		double dirtyMedian = dirtySeconds[repetitions / 2];
+		double fullMedian = fullSeconds[repetitions / 2];
+
+		std::ostringstream tileCount;
+		tileCount << tiles.size() << "/" << region.getTileCount();
+
+		std::cout << std::left << std::setw(18) << editNames[edit] << std::right << std::setw(12) << tileCount.str() << std::fixed << std::setprecision(1)
+			<< std::setw(9) << 100.0 * dirtyPixels / ((double)settings.width * settings.height) << "%" << std::setprecision(2) << std::setw(16) << dirtyMedian * 1000.0
+			<< std::setw(16) << fullMedian * 1000.0 << std::setw(9) << fullMedian / dirtyMedian << "x" << std::setw(16) << differing << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Tiles are the ones the moved sphere's old and new boxes and their shadows on the floor reach, pixels differ should always be 0" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkAllocations()
+{
+	const int frameCount = 5;   // Counted after the first frame, which is setup
+
+	// The render paths that take different code, single rays, packets and the anti-aliasing passes
+
+	const int packetSizes[] = { 1, 8, 1 };
+	const int maxSamples[] = { 1, 1, 4 };
+	const char *pathNames[] = { "Single rays", "Packets of 8", "Anti-aliased x4" };
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+
+	HitBuffer hits(settings.width, settings.height);
+	Framebuffer image(settings.width, settings.height);
+
+	std::cout << std::left << std::setw(18) << "Path" << std::right << std::setw(20) << "First frame allocs" << std::setw(20) << "Allocs per frame" << std::setw(14) << "Frame ms" << std::endl;
+
+	int failures = 0;
+
+	for ( size_t path = 0; path < sizeof(packetSizes) / sizeof(packetSizes[0]); ++path )
+	{
+		settings.packetSize = packetSizes[path];
+		settings.maxSamples = maxSamples[path];
+
+		TileScheduler scheduler(pool, settings.tileSize);
+		RenderStats stats(pool.getThreadCount(), settings.width, settings.height, settings.tileSize);
+
+		long long before = AllocationCount();
+		RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+		long long firstFrame = AllocationCount() - before;
+
+		before = AllocationCount();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for ( int frame = 0; frame < frameCount; ++frame )
+		{
+			RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+		}
+
+		double frameSeconds = SecondsSince(start) / frameCount;
+		long long allocations = AllocationCount() - before;   // Nothing is printed until here, cout can allocate too
+
+		failures += allocations != 0;
+
+		std::cout << std::left << std::setw(18) << pathNames[path] << std::right << std::setw(20) << firstFrame << std::fixed << std::setprecision(1)
+			<< std::setw(20) << (double)allocations / frameCount << std::setprecision(2) << std::setw(14) << frameSeconds * 1000.0 << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "The first frame sizes the scheduler's and the stats' arrays, every frame after it should allocate nothing" << std::endl;
+	std::cout << (failures == 0 ? "Allocation check passed" : "Allocation check FAILED") << " (" << failures << " paths allocating)" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkNuma()
+{
+	const int frameCount = 9;   // Median of these, after one frame to warm up and place the pages
+
+	NumaTopology topology;
+	bool loaded = topology.Load();
+
+	std::cout << "NUMA nodes: " << topology.getNodeCount();
+
+	if ( !loaded )
+	{
+		std::cout << " (nothing under " << NUMA_NODE_PATH << "N, treated as one node)";
+	}
+
+	std::cout << std::endl;
+
+	for ( int node = 0; node < topology.getNodeCount() && loaded; ++node )
+	{
+		std::cout << "  node " << topology.getNodeId(node) << ": " << topology.getCpus(node).size() << " CPUs" << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+
+	if ( topology.getNodeCount() < 2 )
+	{
+		std::cout << "With one node the pinned pool doesn't pin anything, both runs below should take the same time" << std::endl;
+		std::cout << "\n" << std::endl;
+	}
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	std::cout << std::left << std::setw(34) << "Run" << std::right << std::setw(16) << "Median frame ms" << std::setw(10) << "Speedup" << std::setw(20) << "Node-local tiles" << std::endl;
+
+	double unpinnedMedian = 0.0;
+
+	for ( int pinned = 0; pinned < 2; ++pinned )
+	{
+		NumaTopology singleNode;
+		ThreadPool pool(threads, pinned ? topology : singleNode);
+		TileScheduler scheduler(pool, settings.tileSize);
+		RenderStats stats(pool.getThreadCount(), settings.width, settings.height, settings.tileSize);
+
+		HitBuffer hits(settings.width, settings.height, !pinned);   // Cleared here on this thread, or placed by the workers' first writes
+		Framebuffer image(settings.width, settings.height, !pinned);
+
+		RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+
+		std::vector<double> frameSeconds;
+		long long localTiles = 0;
+		long long tileCount = 0;
+
+		for ( int frame = 0; frame < frameCount; ++frame )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+			frameSeconds.push_back(SecondsSince(start));
+
+			// A tile is node-local when the worker that ran it is on the same node as the worker whose run it started in, the one that placed its pages
+
+			const std::vector<TileTiming> &timings = scheduler.getTileTimings();
+			int tiles = (int)timings.size();
+
+			for ( int i = 0; i < tiles; ++i )
+			{
+				localTiles += pool.getWorkerNode(timings[i].worker) == pool.getWorkerNode(timings[i].owner);
+				++tileCount;
+			}
+		}
+
+		std::sort(frameSeconds.begin(), frameSeconds.end());
+
+		double median = frameSeconds[frameCount / 2];
+
+		if ( !pinned )
+		{
+			unpinnedMedian = median;
+		}
+
+		std::cout << std::left << std::setw(34) << (pinned ? "Pinned, first touch placement" : "Unpinned, pages on the main thread") << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(16) << median * 1000.0 << std::setw(9) << unpinnedMedian / median << "x" << std::setw(19) << 100.0 * localTiles / tileCount << "%" << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Node-local tiles only means anything for the pinned run, unpinned workers move between nodes whenever the OS likes" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkTraversalOrder()
+{
+	const int sphereCount = 200000;   // Enough that the BVH is several times bigger than the caches
+	const int frameCount = 3;   // Each frame of this scene takes a couple of seconds on one core
+
+	const CurveOrder tileOrders[] = { ORDER_SCANLINE, ORDER_MORTON, ORDER_HILBERT, ORDER_SCANLINE, ORDER_MORTON, ORDER_HILBERT };
+	const CurveOrder pixelOrders[] = { ORDER_SCANLINE, ORDER_SCANLINE, ORDER_SCANLINE, ORDER_HILBERT, ORDER_MORTON, ORDER_HILBERT };
+
+	std::mt19937 random(11);
+
+	Scene scene(CreateRandomSpheres(sphereCount, random));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	settings.tileSize = 16;   // Small enough that the tile order shows up inside one worker's run too
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	long long pixels = (long long)settings.width * settings.height;
+	const std::vector<int> &primitives = bvh.getPrimitives();
+
+	std::cout << sphereCount << " spheres, " << bvh.getNodeCount() * sizeof(BVHNode) / 1024 << " KB of BVH nodes, " << threads << " threads, " << settings.tileSize << " pixel tiles" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::cout << std::left << std::setw(10) << "Tiles" << std::setw(10) << "Pixels" << std::right << std::setw(12) << "Frame ms" << std::setw(12) << "Mpixel/s" << std::setw(18) << "Cache misses/px"
+		<< std::setw(18) << "New leaves/ray" << std::endl;
+
+	for ( size_t order = 0; order < sizeof(tileOrders) / sizeof(tileOrders[0]); ++order )
+	{
+		settings.tileOrder = tileOrders[order];
+		settings.pixelOrder = pixelOrders[order];
+
+		CacheMissCounter counter;
+		bool counting = counter.Open();   // Before the pool so its threads inherit the counter
+
+		std::vector<double> frameSeconds;
+
+		{
+			ThreadPool pool(threads);
+			TileScheduler scheduler(pool, settings.tileSize);
+			RenderStats stats(pool.getThreadCount(), settings.width, settings.height, settings.tileSize);
+			HitBuffer hits(settings.width, settings.height);
+			Framebuffer image(settings.width, settings.height);
+
+			RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+
+			counter.Start();
+
+			for ( int frame = 0; frame < frameCount; ++frame )
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+				frameSeconds.push_back(SecondsSince(start));
+			}
+
+			counter.Stop();
+		}
+
+		long long misses = counting ? counter.Read() : -1;
+
+		// Doesn't need the counters: walk the primary rays in the order one worker traces them and count the BVH leaves each reaches that the ray before didn't.
+		// Fewer means more of what a ray reads is still in cache from the last one
+
+		std::vector<Tile> tiles = TileScheduler::MakeTiles(settings.width, settings.height, settings.tileSize, settings.tileOrder);
+		std::vector<int> lastLeaves;
+		std::vector<int> leaves;
+		long long newLeaves = 0;
+
+		for ( const Tile &tile : tiles )
+		{
+			unsigned int side = settings.pixelOrder == ORDER_SCANLINE ? settings.tileSize : CurveSide(tile.maxX - tile.minX, tile.maxY - tile.minY);
+
+			for ( unsigned int i = 0; i < side * side; ++i )
+			{
+				unsigned int offsetX = 0;
+				unsigned int offsetY = 0;
+
+				CurvePoint(settings.pixelOrder, side, i, &offsetX, &offsetY);
+
+				int x = tile.minX + offsetX;
+				int y = tile.minY + offsetY;
+
+				if ( x >= tile.maxX || y >= tile.maxY )
+				{
+					continue;
+				}
+
+				glm::vec3 origin = scene.getCamera().getPosition();
+				glm::vec3 direction = scene.getCamera().PixelDirection(x, y);
+				float maxT = INFINITY;
+
+				leaves.clear();
+
+				bvh.Traverse(origin, direction, &maxT, false, [&](int _first, int _count, float *_maxT)
+				{
+					bool hit = false;
+					float t = 0.0f;
+
+					leaves.push_back(_first);
+
+					for ( int entry = _first; entry < _first + _count; ++entry )
+					{
+						if ( scene.Intersection(primitives[entry], origin, direction, &t) && t < *_maxT )
+						{
+							*_maxT = t;
+							hit = true;
+						}
+					}
+
+					return hit;
+				});
+
+				for ( int leaf : leaves )
+				{
+					newLeaves += std::find(lastLeaves.begin(), lastLeaves.end(), leaf) == lastLeaves.end();
+				}
+
+				lastLeaves.swap(leaves);
+			}
+		}
+
+		std::sort(frameSeconds.begin(), frameSeconds.end());
+
+		double median = frameSeconds[frameCount / 2];
+
+		std::ostringstream missText;
+
+		if ( misses >= 0 )
+		{
+			missText << std::fixed << std::setprecision(3) << (double)misses / (pixels * frameCount);
+		}
+		else
+		{
+			missText << "n/a";
+		}
+
+		std::cout << std::left << std::setw(10) << CurveName(settings.tileOrder) << std::setw(10) << CurveName(settings.pixelOrder) << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << median * 1000.0 << std::setw(12) << pixels / median / 1e6 << std::setw(18) << missText.str() << std::setprecision(3) << std::setw(18) << (double)newLeaves / pixels << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+	std::cout << "Cache misses are the CPU's last level misses over the whole frame, shading and shadow rays included, n/a where the counters can't be read" << std::endl;
+	std::cout << "New leaves per ray counts BVH leaves a primary ray reaches that the one traced before it didn't, in one worker's order" << std::endl;
+	std::cout << "\n" << std::endl;
+}
+
+void BenchmarkCheckpoint()
+{
+	const int repetitions = 15;   // Each render is timed this many times, run to run noise is bigger than what checkpointing costs
+	const int intervalMs = 25;   // Far more often than CHECKPOINT_INTERVAL_MS, so even the 1 sample frame is written out in several goes before the first cut
+	const int sampleCounts[] = { 1, 16 };
+	const double costLimit = 3.0;   // Percent of the render threads' time the checkpoint can take, between queueing tiles and the writer thread
+	const double overheadLimit = 10.0;   // Percent slower than the same render without a checkpoint, looser as timing whole frames is a few percent noisy
+	const char *checkpointPath = "../RayTracingBenchmark.checkpoint";
+
+	Scene scene(CreateShapes(std::vector<std::shared_ptr<Shape>>()));
+	BVH bvh;
+	bvh.Build(scene);
+
+	RenderSettings settings;
+	settings.width = 1600;
+	settings.height = 1600;
+	scene.getCamera().setResolution(settings.width, settings.height);
+
+	ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+	TileScheduler scheduler(pool, settings.tileSize);
+	RenderStats stats(pool.getThreadCount(), settings.width, settings.height, settings.tileSize);   // Not reported, the passes need somewhere to put their timings
+
+	HitBuffer hits(settings.width, settings.height);
+	Framebuffer image(settings.width, settings.height);
+
+	std::vector<unsigned char> reference;
+	int failures = 0;
+
+	std::cout << "Rendering " << settings.width << " x " << settings.height << ", writing the checkpoint every " << intervalMs << " ms" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::cout << std::left << std::setw(10) << "Samples" << std::right << std::setw(12) << "Plain ms" << std::setw(12) << "Banded ms" << std::setw(18) << "Checkpointed ms" << std::setw(12) << "Overhead" << std::setw(14) << "KB written"
+		<< std::setw(12) << "Queue ms" << std::setw(12) << "Writer ms" << std::setw(10) << "Cost" << std::setw(12) << "Same image" << std::endl;
+
+	for ( size_t samples = 0; samples < sizeof(sampleCounts) / sizeof(sampleCounts[0]); ++samples )
+	{
+		settings.maxSamples = sampleCounts[samples];
+
+		std::vector<double> plainSeconds;
+		std::vector<double> bandedSeconds;
+		std::vector<double> checkpointedSeconds;
+		std::vector<double> queueSeconds;
+		std::vector<double> writeSeconds;
+		long long bytesWritten = 0;
+
+		bool same = true;
+		std::vector<unsigned char> rendered;
+
+		for ( int repetition = 0; repetition < repetitions; ++repetition )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			RenderFrame(scene, bvh, settings, hits, image, nullptr, scheduler, stats);
+			plainSeconds.push_back(SecondsSince(start));
+
+			EncodePPM(image, &reference);
+
+			// The two banded renders swap order every repetition, so neither always runs straight after the plain one
+
+			for ( int run = 0; run < 2; ++run )
+			{
+				if ( (run + repetition) % 2 == 0 )
+				{
+					start = std::chrono::steady_clock::now();
+					RenderFrameCheckpointed(scene, bvh, settings, hits, image, nullptr, scheduler, stats, nullptr);   // The checkpointed render's order of work, with nothing written
+					bandedSeconds.push_back(SecondsSince(start));
+				}
+				else
+				{
+					remove(checkpointPath);   // Nothing to resume, every tile is rendered and written
+
+					Checkpoint checkpoint;
+
+					start = std::chrono::steady_clock::now();
+
+					if ( !checkpoint.Open(checkpointPath, settings, scene, intervalMs) )
+					{
+						std::cout << "Couldn't open " << checkpointPath << std::endl;
+						return;
+					}
+
+					RenderFrameCheckpointed(scene, bvh, settings, hits, image, nullptr, scheduler, stats, &checkpoint);
+					checkpoint.Close();   // Counted, the last tiles are written here
+
+					checkpointedSeconds.push_back(SecondsSince(start));
+					queueSeconds.push_back(checkpoint.getQueueSeconds());
+					writeSeconds.push_back(checkpoint.getWriteSeconds());
+					bytesWritten = checkpoint.getBytesWritten();
+				}
+
+				EncodePPM(image, &rendered);
+				same = same && rendered == reference;
+			}
+		}
+
+		double plainFastest = *std::min_element(plainSeconds.begin(), plainSeconds.end());
+		double bandedFastest = *std::min_element(bandedSeconds.begin(), bandedSeconds.end());
+		double checkpointedFastest = *std::min_element(checkpointedSeconds.begin(), checkpointedSeconds.end());
+
+		// Each checkpointed render against the banded one timed next to it, then the median of those, so the machine getting slower
+		// or faster over the repetitions and the odd render the OS got in the way of don't move it
+
+		std::vector<double> overheads;
+		std::vector<double> costs;
+
+		for ( int repetition = 0; repetition < repetitions; ++repetition )
+		{
+			overheads.push_back(100.0 * (checkpointedSeconds[repetition] - bandedSeconds[repetition]) / bandedSeconds[repetition]);
+			costs.push_back(100.0 * (queueSeconds[repetition] + writeSeconds[repetition]) / (bandedSeconds[repetition] * pool.getThreadCount()));
+		}
+
+		std::sort(overheads.begin(), overheads.end());
+		std::sort(costs.begin(), costs.end());
+		std::sort(queueSeconds.begin(), queueSeconds.end());
+		std::sort(writeSeconds.begin(), writeSeconds.end());
+
+		double overhead = overheads[repetitions / 2];
+		double cost = costs[repetitions / 2];
+
+		failures += !same || overhead > overheadLimit || cost > costLimit;
+
+		std::cout << std::left << std::setw(10) << settings.maxSamples << std::right << std::fixed << std::setprecision(2) << std::setw(12) << plainFastest * 1000.0
+			<< std::setw(12) << bandedFastest * 1000.0 << std::setw(18) << checkpointedFastest * 1000.0 << std::setw(11) << overhead << (overhead > overheadLimit ? "!" : "%") << std::setprecision(1)
+			<< std::setw(14) << bytesWritten / 1024.0 << std::setprecision(2) << std::setw(12) << queueSeconds[repetitions / 2] * 1000.0 << std::setw(12) << writeSeconds[repetitions / 2] * 1000.0
+			<< std::setw(9) << cost << (cost > costLimit ? "!" : "%") << std::setw(12) << (same ? "yes" : "NO") << std::endl;
+
+		// A render killed part way through leaves whatever the writer had flushed by then. The file is copied at a few points through one more
+		// checkpointed render and each copy is resumed from. Tiles finish all through the render, so a cut has to read back at least half the share
+		// of the tiles its share of the render time would suggest, the rest is the last write interval and the tiles still going through the passes
+
+		const double cutFractions[] = { 0.0, 0.25, 0.5, 0.75, 1.0 };   // Of the banded render's time, 1 is the file once the render has finished
+		const int cutCount = sizeof(cutFractions) / sizeof(cutFractions[0]);
+		std::vector<std::vector<unsigned char>> cuts(cutCount);
+
+		remove(checkpointPath);
+
+		{
+			Checkpoint checkpoint;
+			checkpoint.Open(checkpointPath, settings, scene, intervalMs);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			std::thread cutter([&]()
+			{
+				for ( int cut = 0; cut < cutCount - 1; ++cut )
+				{
+					std::this_thread::sleep_until(start + std::chrono::microseconds((long long)(cutFractions[cut] * bandedFastest * 1e6)));
+					cuts[cut] = ReadWholeFile(checkpointPath);
+				}
+			});
+
+			RenderFrameCheckpointed(scene, bvh, settings, hits, image, nullptr, scheduler, stats, &checkpoint);
+
+			cutter.join();
+			checkpoint.Close();
+		}
+
+		cuts[cutCount - 1] = ReadWholeFile(checkpointPath);
+
+		for ( int cut = 0; cut < cutCount; ++cut )
+		{
+			std::ofstream ofs(checkpointPath, std::ios::out | std::ios::binary);
+			ofs.write((const char*)cuts[cut].data(), cuts[cut].size());
+			ofs.close();
+
+			image.Clear(glm::vec3(1, 0, 1));   // Anything the resume misses shows up as a difference
+
+			Checkpoint checkpoint;
+			checkpoint.Open(checkpointPath, settings, scene, intervalMs);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			RenderFrameCheckpointed(scene, bvh, settings, hits, image, nullptr, scheduler, stats, &checkpoint);
+			double resumeSeconds = SecondsSince(start);
+
+			checkpoint.Close();
+
+			std::vector<unsigned char> resumed;
+			EncodePPM(image, &resumed);
+
+			int differing = 0;
+
+			for ( size_t i = 0; i < resumed.size() && i < reference.size(); ++i )
+			{
+				differing += resumed[i] != reference[i];
+			}
+
+			double restoredShare = (double)checkpoint.getRestoredCount() / checkpoint.getTiles().size();
+			bool enoughRestored = cut == cutCount - 1 ? restoredShare == 1.0 : restoredShare >= cutFractions[cut] / 2.0;
+
+			failures += differing != 0 || resumed.size() != reference.size() || !enoughRestored;
+
+			std::cout << "  killed at " << std::setw(3) << (int)(100.0 * cutFractions[cut]) << "% of the render: " << std::setw(4) << checkpoint.getRestoredCount() << " of "
+				<< checkpoint.getTiles().size() << " tiles read back" << (enoughRestored ? ", " : " (too few), ") << std::setw(8) << resumeSeconds * 1000.0 << " ms, " << differing << " bytes differ" << std::endl;
+		}
+
+		std::cout << "\n" << std::endl;
+	}
+
+	remove(checkpointPath);
+
+	std::cout << "Banded is the checkpointed render's order of work with no checkpoint, the ms columns are the fastest of " << repetitions << " renders" << std::endl;
+	std::cout << "Overhead is the median of each checkpointed frame, the last write once the frame is done included, against the banded frame timed next to it" << std::endl;
+	std::cout << "Queue ms is the render threads' time in TileFinished added up, writer ms the writer thread's, both medians" << std::endl;
+	std::cout << "Cost is the two against the render threads' time, what checkpointing takes from the render when the frame uses every core" << std::endl;
+	std::cout << "Cost has to stay under " << costLimit << "% and overhead under " << overheadLimit << "%, which leaves room for the noise in timing whole frames (! when they didn't)" << std::endl;
+	std::cout << "Killed at is when the file was copied, as a share of the banded render's time, 100% is the file the finished render left" << std::endl;
+	std::cout << (failures == 0 ? "Checkpoint check passed" : "Checkpoint check FAILED") << " (" << failures << " renders over the cost or overhead limit, or resumes that differed from the uninterrupted render or read back too few tiles)" << std::endl;
+	std::cout << "\n" << std::endl;
+}
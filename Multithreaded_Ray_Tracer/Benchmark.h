@@ -0,0 +1,29 @@
+/// \file Benchmark.h
+/// \brief Functions for timing parts of the ray tracer on their own
+/// \author Thomas Hardy
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+void BenchmarkBVH();   // Times closest hit and shadow queries through the BVH and a linear scan over growing sphere counts
+
+void BenchmarkSphereKernel();   // Checks the SIMD sphere kernel gives the same hits as Sphere::Intersection, then times both
+
+void BenchmarkRayPackets();   // Checks packets of 4, 8 and 16 primary rays hit the same shapes as single rays, then compares their throughput
+
+void BenchmarkKernels();   // Times the intersection tests, ray generation, shading, a single tile and the image output on their own, with repetitions and spread
+
+void BenchmarkThreadScaling();   // Renders the scene over a grid of thread counts and tile sizes, writing speedup, efficiency and load imbalance as CSV
+
+void BenchmarkInstancing();   // Checks instances hit where the same shapes placed in world space do, then times and sizes scenes of up to a million instances
+
+void BenchmarkDirtyTiles();   // Moves spheres one at a time and re-renders only the tiles each move touched, checking the result against a full frame
+
+void BenchmarkAllocations();   // Counts the heap allocations a frame makes once the first one has set everything up, which should be none
+
+void BenchmarkNuma();   // Renders with an unpinned pool and with workers pinned to their NUMA nodes and the buffers placed by first touch
+
+void BenchmarkTraversalOrder();   // Renders a big sphere scene with tiles and pixels in scanline, Morton and Hilbert order, comparing cache misses and throughput
+
+void BenchmarkCheckpoint();   // Times a frame with and without tile checkpoints, then resumes from cut short checkpoint files and checks the image matches
+#endif
@@ -0,0 +1,98 @@
+/// \file BoundedQueue.h
+/// \brief Class for the 'BoundedQueue' which passes work between two threads and makes the producer wait once it is full
+/// \author Thomas Hardy
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename T>
+class BoundedQueue
+{
+public:
+
+	BoundedQueue(size_t _capacity);
+
+	bool Push(T _item);   // Blocks while the queue is full, false if it has been closed
+
+	bool Pop(T *_item);   // Blocks while the queue is empty, false once it has been closed and emptied
+
+	void Close();   // Wakes everything waiting, items already queued can still be popped
+
+private:
+
+	std::deque<T> m_items;
+	size_t m_capacity;
+	bool m_closed;
+
+	std::mutex m_lock;
+	std::condition_variable m_notFull;
+	std::condition_variable m_notEmpty;
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t _capacity)
+{
+	m_capacity = _capacity > 0 ? _capacity : 1;
+	m_closed = false;
+}
+
+template <typename T>
+bool BoundedQueue<T>::Push(T _item)
+{
+	{
+		std::unique_lock<std::mutex> guard(m_lock);
+
+		m_notFull.wait(guard, [this]() { return m_closed || m_items.size() < m_capacity; });
+
+		if ( m_closed )
+		{
+			return false;
+		}
+
+		m_items.push_back(std::move(_item));   // Moved so frames and file buffers aren't copied on their way through
+	}
+
+	m_notEmpty.notify_one();
+
+	return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::Pop(T *_item)
+{
+	{
+		std::unique_lock<std::mutex> guard(m_lock);
+
+		m_notEmpty.wait(guard, [this]() { return m_closed || !m_items.empty(); });
+
+		if ( m_items.empty() )
+		{
+			return false;
+		}
+
+		*_item = std::move(m_items.front());
+		m_items.pop_front();
+	}
+
+	m_notFull.notify_one();
+
+	return true;
+}
+
+template <typename T>
+void BoundedQueue<T>::Close()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_closed = true;
+	}
+
+	m_notFull.notify_all();
+	m_notEmpty.notify_all();
+}
+#endif
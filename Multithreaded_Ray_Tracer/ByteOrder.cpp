@@ -0,0 +1,23 @@
+/// @file ByteOrder.cpp
+/// @brief Contains functions for little endian integers
+
+#include "ByteOrder.h"
+
+void PutLittleEndian(unsigned char *_bytes, unsigned int _value)
+{
+	for ( int i = 0; i < 4; ++i )
+	{
+		_bytes[i] = (unsigned char)(_value >> (8 * i));
+	}
+}
+
+void PutLittleEndian(std::vector<unsigned char> *_bytes, unsigned int _value)
+{
+	_bytes->resize(_bytes->size() + 4);
+	PutLittleEndian(&(*_bytes)[_bytes->size() - 4], _value);
+}
+
+unsigned int GetLittleEndian(const unsigned char *_bytes)
+{
+	return (unsigned int)_bytes[0] | ((unsigned int)_bytes[1] << 8) | ((unsigned int)_bytes[2] << 16) | ((unsigned int)_bytes[3] << 24);
+}
@@ -0,0 +1,15 @@
+/// \file ByteOrder.h
+/// \brief Functions for reading and writing the little endian integers the checkpoint file and the farm's messages are made of
+/// \author Thomas Hardy
+
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <vector>
+
+void PutLittleEndian(unsigned char *_bytes, unsigned int _value);   // Four bytes, lowest first whatever the machine
+
+void PutLittleEndian(std::vector<unsigned char> *_bytes, unsigned int _value);   // Onto the end of _bytes
+
+unsigned int GetLittleEndian(const unsigned char *_bytes);
+#endif
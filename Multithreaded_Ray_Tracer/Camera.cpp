@@ -0,0 +1,88 @@
+/// @file Camera.cpp
+/// @brief Contains functions for the Camera class
+/// A ray through pixel (x, y) points at m_pixelOrigin + x * m_stepX + y * m_stepY, so per pixel it costs two multiply-adds and a normalise
+
+#include <math.h>
+
+#include "Camera.h"
+
+Camera::Camera()
+{
+	m_position = glm::vec3(0, 0, 0);
+	m_target = glm::vec3(0, 0, -1);
+	m_up = glm::vec3(0, 1, 0);
+	m_fieldOfView = CAMERA_DEFAULT_FOV;
+	m_aspect = 0.0f;
+	m_width = 800;
+	m_height = 800;
+
+	Update();
+}
+
+void Camera::LookAt(glm::vec3 _position, glm::vec3 _target, glm::vec3 _up)
+{
+	m_position = _position;
+	m_target = _target;
+	m_up = _up;
+
+	Update();
+}
+
+void Camera::setResolution(int _width, int _height)
+{
+	if ( _width == m_width && _height == m_height )
+	{
+		return;
+	}
+
+	m_width = _width;
+	m_height = _height;
+
+	Update();
+}
+
+bool Camera::Project(glm::vec3 _point, glm::vec2 *_pixel) const
+{
+	glm::vec3 offset = _point - m_position;
+	float depth = glm::dot(offset, m_forward);
+
+	if ( depth < 1e-4f )
+	{
+		return false;
+	}
+
+	// Scaled onto the image plane 1 unit in front of the camera, then from there to pixels
+
+	float planeX = glm::dot(offset, m_right) / depth;
+	float planeY = glm::dot(offset, m_trueUp) / depth;
+
+	_pixel->x = (planeX + m_halfWidth) / (2.0f * m_halfWidth) * m_width;
+	_pixel->y = (m_halfHeight - planeY) / (2.0f * m_halfHeight) * m_height;
+
+	return true;
+}
+
+void Camera::Update()
+{
+	m_forward = m_target - m_position;
+	m_forward = glm::length(m_forward) > 0.0f ? glm::normalize(m_forward) : glm::vec3(0, 0, -1);
+
+	m_right = glm::cross(m_forward, m_up);
+
+	if ( glm::length(m_right) < 1e-6f )   // Looking straight along up, any right angle will do
+	{
+		m_right = glm::cross(m_forward, fabs(m_forward.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 0, 1));
+	}
+
+	m_right = glm::normalize(m_right);
+	m_trueUp = glm::cross(m_right, m_forward);
+
+	float aspect = m_aspect > 0.0f ? m_aspect : (float)m_width / m_height;   // Widened for images that aren't square
+
+	m_halfHeight = tan(glm::radians(m_fieldOfView) / 2.0f);
+	m_halfWidth = m_halfHeight * aspect;
+
+	m_pixelOrigin = m_forward - m_halfWidth * m_right + m_halfHeight * m_trueUp;
+	m_stepX = m_right * (2.0f * m_halfWidth / m_width);
+	m_stepY = -m_trueUp * (2.0f * m_halfHeight / m_height);
+}
@@ -0,0 +1,64 @@
+/// \file Camera.h
+/// \brief Class for the 'Camera' which turns pixels into primary rays, with everything but the per pixel step worked out up front
+/// \author Thomas Hardy
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm.hpp>
+
+#define CAMERA_DEFAULT_FOV (90.0f)   // Macro for the vertical field of view in degrees the camera starts with (Standard for games)
+
+class Camera
+{
+public:
+
+	Camera();   // At the origin looking down -z, 800 x 800
+
+	void LookAt(glm::vec3 _position, glm::vec3 _target, glm::vec3 _up);
+
+	void setFieldOfView( float _degrees ) { m_fieldOfView = _degrees; Update(); }   // Vertical
+	float getFieldOfView() { return m_fieldOfView; }
+
+	void setAspect( float _aspect ) { m_aspect = _aspect; Update(); }   // Width over height of the view, 0 follows the resolution
+	float getAspect() { return m_aspect; }
+
+	void setResolution(int _width, int _height);   // Does nothing if it hasn't changed, so it can be called every frame
+
+	int getWidth() { return m_width; }
+
+	int getHeight() { return m_height; }
+
+	glm::vec3 getPosition() const { return m_position; }
+
+	glm::vec3 RayDirection( float _pixelX, float _pixelY ) const { return glm::normalize(m_pixelOrigin + _pixelX * m_stepX + _pixelY * m_stepY); }   // Through any point on the image, in pixels from the top left corner
+
+	glm::vec3 PixelDirection( int _x, int _y ) const { return RayDirection(_x + 0.5f, _y + 0.5f); }   // Through the centre of a pixel
+
+	bool Project(glm::vec3 _point, glm::vec2 *_pixel) const;   // Where a world space point lands on the image, false if it's level with or behind the camera
+
+private:
+
+	void Update();   // Works out the basis and the per pixel steps again after anything changes
+
+	glm::vec3 m_position;
+	glm::vec3 m_target;
+	glm::vec3 m_up;
+	float m_fieldOfView;
+	float m_aspect;
+	int m_width;
+	int m_height;
+
+	// Worked out by Update
+
+	glm::vec3 m_forward;
+	glm::vec3 m_right;
+	glm::vec3 m_trueUp;   // Up at right angles to forward, m_up only has to be roughly right
+	float m_halfWidth;   // Of the image plane 1 unit in front of the camera
+	float m_halfHeight;
+
+	glm::vec3 m_pixelOrigin;   // Top left corner of the image plane
+	glm::vec3 m_stepX;   // One pixel to the right across the image plane
+	glm::vec3 m_stepY;   // One pixel down
+};
+#endif
@@ -0,0 +1,402 @@
+/// @file Checkpoint.cpp
+/// @brief Contains functions for the Checkpoint class
+/// The render threads only copy a finished tile out as bytes onto the end of a queue, writing the queue out is left to one thread that wakes
+/// every few seconds and writes everything queued with one fwrite. The bytes go out as they are, compressing them cost more CPU time than a
+/// render can spare. Each write is one record with a checksum, so a record cut short by the process dying halfway through a write is found and
+/// dropped when the file is read back
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Checkpoint.h"
+#include "ByteOrder.h"
+#include "Deflate.h"
+#include "Instance.h"
+#include "Mesh.h"
+
+#define CHECKPOINT_HEADER_SIZE (28)   // Macro for the magic, the settings hash, then the width, height and tile size
+#define CHECKPOINT_RECORD_HEADER_SIZE (8)   // Macro for each record's tile count and size, the tile indices and each tile's 8 bit rows follow
+#define CHECKPOINT_RECORD_TRAILER_SIZE (4)   // Macro for the Adler-32 of the indices and rows, after them so the rows can go straight from the queue to the file
+
+namespace
+{
+	unsigned long long HashBytes(unsigned long long _hash, const void *_data, size_t _size)   // FNV-1a
+	{
+		const unsigned char *bytes = (const unsigned char*)_data;
+
+		for ( size_t i = 0; i < _size; ++i )
+		{
+			_hash = (_hash ^ bytes[i]) * 1099511628211ull;
+		}
+
+		return _hash;
+	}
+
+	unsigned long long HashVec3(unsigned long long _hash, glm::vec3 _value)
+	{
+		return HashBytes(_hash, &_value[0], sizeof(float) * 3);
+	}
+}
+
+Checkpoint::Checkpoint()
+{
+	m_file = nullptr;
+	m_restoredCount = 0;
+	m_queuedByteCount = 0;
+	m_closing = false;
+	m_intervalMs = CHECKPOINT_INTERVAL_MS;
+	m_bytesWritten = 0;
+	m_queueSeconds = 0.0;
+	m_writeSeconds = 0.0;
+}
+
+Checkpoint::~Checkpoint()
+{
+	Close();
+}
+
+bool Checkpoint::Open(const std::string &_path, const RenderSettings &_settings, Scene &_scene, int _intervalMs)
+{
+	Close();
+
+	m_path = _path;
+	m_intervalMs = _intervalMs;
+	m_tiles = TileScheduler::MakeTiles(_settings.width, _settings.height, _settings.tileSize);
+	m_restored.assign(m_tiles.size(), 0);
+	m_restoredTiles.clear();
+	m_restoredCount = 0;
+	m_bytesWritten = 0;
+	m_queueSeconds = 0.0;
+	m_writeSeconds = 0.0;
+
+	unsigned long long hash = Hash(_settings, _scene);
+
+	std::vector<unsigned char> kept(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + 8);   // The file is written back as this, the header then every record that read back whole
+	PutLittleEndian(&kept, (unsigned int)hash);
+	PutLittleEndian(&kept, (unsigned int)(hash >> 32));
+	PutLittleEndian(&kept, (unsigned int)_settings.width);
+	PutLittleEndian(&kept, (unsigned int)_settings.height);
+	PutLittleEndian(&kept, (unsigned int)_settings.tileSize);
+
+	std::ifstream ifs(_path, std::ios::in | std::ios::binary);
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	ifs.close();
+
+	bool headerMatched = file.size() >= CHECKPOINT_HEADER_SIZE && memcmp(file.data(), kept.data(), CHECKPOINT_HEADER_SIZE) == 0;
+
+	if ( headerMatched )
+	{
+		size_t position = CHECKPOINT_HEADER_SIZE;
+
+		while ( file.size() - position >= CHECKPOINT_RECORD_HEADER_SIZE + CHECKPOINT_RECORD_TRAILER_SIZE )
+		{
+			unsigned int tileCount = GetLittleEndian(&file[position]);
+			unsigned int size = GetLittleEndian(&file[position + 4]);
+			const unsigned char *body = &file[position + CHECKPOINT_RECORD_HEADER_SIZE];
+
+			if ( size > file.size() - position - CHECKPOINT_RECORD_HEADER_SIZE - CHECKPOINT_RECORD_TRAILER_SIZE || Adler32(body, size) != GetLittleEndian(body + size)
+				|| tileCount > m_tiles.size() || (size_t)tileCount * 4 > size )
+			{
+				break;   // The rest is what was being written when the last run stopped
+			}
+
+			std::vector<TileRecord> records(tileCount);
+			size_t pixelBytes = 0;
+			bool indicesGood = true;
+
+			for ( unsigned int i = 0; i < tileCount && indicesGood; ++i )
+			{
+				unsigned int index = GetLittleEndian(body + i * 4);
+				indicesGood = index < m_tiles.size();
+
+				if ( indicesGood )
+				{
+					const Tile &tile = m_tiles[index];
+
+					records[i].index = (int)index;
+					pixelBytes += (size_t)(tile.maxX - tile.minX) * 3 * (tile.maxY - tile.minY);
+				}
+			}
+
+			if ( !indicesGood || (size_t)tileCount * 4 + pixelBytes != size )
+			{
+				break;
+			}
+
+			const unsigned char *tilePixels = body + (size_t)tileCount * 4;
+
+			for ( unsigned int i = 0; i < tileCount; ++i )
+			{
+				TileRecord &record = records[i];
+				const Tile &tile = m_tiles[record.index];
+
+				record.pixels.assign(tilePixels, tilePixels + (size_t)(tile.maxX - tile.minX) * 3 * (tile.maxY - tile.minY));
+				tilePixels += record.pixels.size();
+
+				if ( !m_restored[record.index] )
+				{
+					m_restored[record.index] = 1;
+					m_restoredTiles.push_back(std::move(record));
+					m_restoredCount++;
+				}
+			}
+
+			size_t next = position + CHECKPOINT_RECORD_HEADER_SIZE + size + CHECKPOINT_RECORD_TRAILER_SIZE;
+			kept.insert(kept.end(), file.begin() + position, file.begin() + next);
+			position = next;
+		}
+	}
+
+	// Appended to when the header matched and every byte after it read back, otherwise written again from what did so new records don't land
+	// after a broken one. A header only file from another render is as long as this one's header, so the sizes alone can't tell
+
+	if ( headerMatched && kept.size() == file.size() )
+	{
+		m_file = fopen(_path.c_str(), "ab");
+	}
+	else
+	{
+		m_file = fopen(_path.c_str(), "wb");
+
+		if ( m_file != nullptr )
+		{
+			fwrite(kept.data(), 1, kept.size(), m_file);
+			fflush(m_file);
+		}
+	}
+
+	if ( m_file == nullptr )
+	{
+		return false;
+	}
+
+	size_t frameBytes = (size_t)_settings.width * _settings.height * 3;   // With the writer's interval longer than the render the whole frame is queued
+
+	m_queued.clear();
+	m_queued.reserve(m_tiles.size());
+	m_queuedBytes.reset(new unsigned char[frameBytes]);
+	m_queuedByteCount = 0;
+	m_writingBytes.reset(new unsigned char[frameBytes]);
+	m_closing = false;
+	m_writer = std::thread(&Checkpoint::WriterLoop, this);
+
+	return true;
+}
+
+void Checkpoint::TileFinished(const Tile &_tile, Framebuffer &_image)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int rowBytes = (_tile.maxX - _tile.minX) * 3;
+
+	// Quantized with the lock held, so the writer can't take the queue with a tile half in it. A tile takes far less time than it took to render,
+	// so the render threads rarely wait for each other
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	for ( int y = _tile.minY; y < _tile.maxY; ++y )
+	{
+		_image.QuantizeRow(y, _tile.minX, _tile.maxX, &m_queuedBytes[m_queuedByteCount]);
+		m_queuedByteCount += rowBytes;
+	}
+
+	m_queued.push_back(_tile.index);   // Open made room for every tile
+	m_queueSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Checkpoint::Restore(Framebuffer &_image, MappedPPM *_mappedFile)
+{
+	for ( size_t i = 0; i < m_restoredTiles.size(); ++i )
+	{
+		const TileRecord &record = m_restoredTiles[i];
+		const Tile &tile = m_tiles[record.index];
+		int rowBytes = (tile.maxX - tile.minX) * 3;
+
+		for ( int y = tile.minY; y < tile.maxY; ++y )
+		{
+			const unsigned char *row = &record.pixels[(size_t)(y - tile.minY) * rowBytes];
+
+			_image.DequantizeRow(y, tile.minX, tile.maxX, row);
+
+			if ( _mappedFile != nullptr )
+			{
+				memcpy(_mappedFile->getRow(y) + tile.minX * 3, row, rowBytes);
+			}
+		}
+	}
+}
+
+void Checkpoint::Close()
+{
+	if ( m_writer.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_closing = true;
+		}
+
+		m_wake.notify_one();
+		m_writer.join();
+	}
+
+	if ( m_file != nullptr )
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+void Checkpoint::Remove()
+{
+	Close();
+
+	if ( !m_path.empty() )
+	{
+		remove(m_path.c_str());
+	}
+}
+
+unsigned long long Checkpoint::Hash(const RenderSettings &_settings, Scene &_scene)
+{
+	unsigned long long hash = 14695981039346656037ull;
+
+	hash = HashBytes(hash, &_settings.width, sizeof(int));
+	hash = HashBytes(hash, &_settings.height, sizeof(int));
+	hash = HashBytes(hash, &_settings.tileSize, sizeof(int));
+	hash = HashBytes(hash, &_settings.maxSamples, sizeof(int));
+	hash = HashBytes(hash, &_settings.packetSize, sizeof(int));
+	hash = HashVec3(hash, _settings.cameraPosition);
+	hash = HashVec3(hash, _settings.cameraTarget);
+	hash = HashBytes(hash, &_settings.fieldOfView, sizeof(float));
+	hash = HashBytes(hash, _settings.meshPath.data(), _settings.meshPath.size());
+
+	for ( int i = 0; i < _scene.getShapeCount(); ++i )
+	{
+		ShapeType type = _scene.getShapeType(i);
+		hash = HashBytes(hash, &type, sizeof(type));
+
+		if ( type == SHAPE_SPHERE )
+		{
+			Sphere &sphere = _scene.getSphere(i);
+			float radius = sphere.getRadius();
+
+			hash = HashVec3(hash, sphere.getPosition());
+			hash = HashVec3(hash, sphere.getColour());
+			hash = HashBytes(hash, &radius, sizeof(radius));
+		}
+		else if ( type == SHAPE_PLANE )
+		{
+			Plane &plane = _scene.getPlane(i);
+
+			hash = HashVec3(hash, plane.getPosition());
+			hash = HashVec3(hash, plane.getColour());
+			hash = HashVec3(hash, plane.getPlaneNormal());
+		}
+		else
+		{
+			glm::vec3 boundsMin(0, 0, 0);
+			glm::vec3 boundsMax(0, 0, 0);
+
+			_scene.GetBounds(i, &boundsMin, &boundsMax);
+
+			hash = HashVec3(hash, boundsMin);
+			hash = HashVec3(hash, boundsMax);
+
+			// The bounds only give a loaded model's proportions, as LoadMesh fits every model into the same box, so an OBJ edited under
+			// the same path is told apart by its triangles
+
+			Shape *shape = &_scene.getOtherShape(i);
+
+			if ( Instance *instance = dynamic_cast<Instance*>(shape) )
+			{
+				shape = instance->getGeometry().get();
+			}
+
+			if ( Mesh *mesh = dynamic_cast<Mesh*>(shape) )
+			{
+				const std::vector<glm::vec3> &vertices = mesh->getVertices();
+				const std::vector<unsigned int> &indices = mesh->getIndices();
+
+				hash = HashVec3(hash, mesh->getColour());
+				hash = HashBytes(hash, vertices.data(), vertices.size() * sizeof(glm::vec3));
+				hash = HashBytes(hash, indices.data(), indices.size() * sizeof(unsigned int));
+			}
+		}
+	}
+
+	return hash;
+}
+
+void Checkpoint::WriterLoop()
+{
+	std::vector<int> indices;
+	indices.reserve(m_tiles.size());
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	for ( ;; )
+	{
+		m_wake.wait_for(lock, std::chrono::milliseconds(m_intervalMs), [this]() { return m_closing; });
+
+		bool closing = m_closing;
+		size_t byteCount = m_queuedByteCount;
+
+		indices.swap(m_queued);   // Both have room for every tile, so queueing never allocates
+		m_queuedBytes.swap(m_writingBytes);
+		m_queuedByteCount = 0;
+
+		lock.unlock();   // The render threads can queue more tiles while these are written
+
+		WriteTiles(indices, m_writingBytes.get(), byteCount);
+		indices.clear();
+
+		lock.lock();
+
+		if ( closing )
+		{
+			return;
+		}
+	}
+}
+
+void Checkpoint::WriteTiles(const std::vector<int> &_indices, const unsigned char *_bytes, size_t _byteCount)
+{
+	if ( _indices.empty() )
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Everything queued since the last write goes in one record, so only what was being written is lost if the process dies.
+	// The rows are already one after another in the order of the indices, so they go out as one fwrite straight from the queue
+
+	m_indices.resize(_indices.size() * 4);
+
+	for ( size_t i = 0; i < _indices.size(); ++i )
+	{
+		PutLittleEndian(&m_indices[i * 4], (unsigned int)_indices[i]);
+	}
+
+	size_t bodySize = m_indices.size() + _byteCount;
+
+	unsigned char header[CHECKPOINT_RECORD_HEADER_SIZE];
+	PutLittleEndian(header, (unsigned int)_indices.size());
+	PutLittleEndian(header + 4, (unsigned int)bodySize);
+
+	unsigned char trailer[CHECKPOINT_RECORD_TRAILER_SIZE];
+	PutLittleEndian(trailer, Adler32(_bytes, _byteCount, Adler32(m_indices.data(), m_indices.size())));
+
+	fwrite(header, 1, sizeof(header), m_file);
+	fwrite(m_indices.data(), 1, m_indices.size(), m_file);
+	fwrite(_bytes, 1, _byteCount, m_file);
+	fwrite(trailer, 1, sizeof(trailer), m_file);
+	fflush(m_file);   // Into the OS's hands, so the tiles survive the process dying
+
+	m_bytesWritten += (long long)(sizeof(header) + bodySize + sizeof(trailer));
+	m_writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
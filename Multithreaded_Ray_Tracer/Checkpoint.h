@@ -0,0 +1,103 @@
+/// \file Checkpoint.h
+/// \brief Class for the 'Checkpoint' which saves finished tiles to disk as a render goes, so a render that is killed can be started again without redoing them
+/// \author Thomas Hardy
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RenderSettings.h"
+#include "Scene.h"
+#include "Framebuffer.h"
+#include "MappedPPM.h"
+#include "TileScheduler.h"
+
+#define CHECKPOINT_INTERVAL_MS (10000)   // Macro for how often the finished tiles are written out, at most this much work is lost when the render dies
+#define CHECKPOINT_MAGIC ("RTCHKPT2")   // Macro for the 8 bytes the file starts with, the last one is the format version
+
+class Checkpoint
+{
+public:
+
+	Checkpoint();
+
+	~Checkpoint();
+
+	Checkpoint(const Checkpoint&) = delete;
+	Checkpoint& operator=(const Checkpoint&) = delete;
+
+	// Reads back the tiles an earlier run with the same scene and settings left in the file, a file from any other render is started again.
+	// Then starts the thread that writes tiles out every _intervalMs. False if the file couldn't be written
+
+	bool Open(const std::string &_path, const RenderSettings &_settings, Scene &_scene, int _intervalMs = CHECKPOINT_INTERVAL_MS);
+
+	// Call from the render threads once a tile's pixels are final, the tile's bounds have to be one of MakeTiles' in row order.
+	// The pixels are turned into bytes there and then while they're still in the cache, straight into the queue the writer thread takes them from
+
+	void TileFinished(const Tile &_tile, Framebuffer &_image);
+
+	void Restore(Framebuffer &_image, MappedPPM *_mappedFile);   // Puts the pixels of every tile read back by Open into the image, and the mapped file if there is one
+
+	void Close();   // Writes any tiles still waiting and stops the writer thread, the file is kept
+
+	void Remove();   // Close then delete the file, once the image it was for has been saved
+
+	bool hasTile( int _index ) { return m_restored[_index] != 0; }   // Read back by Open, by Tile::index
+
+	const std::vector<Tile>& getTiles() { return m_tiles; }   // Every tile of the frame in row order
+
+	int getRestoredCount() { return m_restoredCount; }
+
+	bool isOpen() { return m_file != nullptr; }
+
+	long long getBytesWritten() { return m_bytesWritten; }
+
+	double getQueueSeconds() { return m_queueSeconds; }   // Time the render threads spent in TileFinished, added up over them
+
+	double getWriteSeconds() { return m_writeSeconds; }   // Time the writer thread spent writing, off the render threads
+
+	static unsigned long long Hash(const RenderSettings &_settings, Scene &_scene);   // Of everything that changes the pixels, a mesh by its vertices and triangles
+
+private:
+
+	struct TileRecord
+	{
+		int index;
+		std::vector<unsigned char> pixels;   // 8 bit RGB rows, as the PPM and PNG writers would save them
+	};
+
+	void WriterLoop();
+
+	void WriteTiles(const std::vector<int> &_indices, const unsigned char *_bytes, size_t _byteCount);   // Appends them as one record, then flushes the file
+
+	std::string m_path;
+	FILE *m_file;
+
+	std::vector<Tile> m_tiles;
+	std::vector<unsigned char> m_restored;   // One per tile
+	std::vector<TileRecord> m_restoredTiles;
+	int m_restoredCount;
+
+	std::mutex m_lock;   // Guards the queue, m_closing and m_queueSeconds
+	std::condition_variable m_wake;
+	std::vector<int> m_queued;   // Tiles finished since the last write
+	std::unique_ptr<unsigned char[]> m_queuedBytes;   // Their 8 bit rows one tile after another, room for the whole frame. Not a vector, a vector would write every byte when made
+	size_t m_queuedByteCount;
+	std::unique_ptr<unsigned char[]> m_writingBytes;   // The writer thread's, swapped with m_queuedBytes each time it wakes
+	bool m_closing;
+	int m_intervalMs;
+	std::thread m_writer;
+	std::vector<unsigned char> m_indices;   // Of the tiles in the record being written, kept so the writer thread allocates once
+
+	long long m_bytesWritten;
+	double m_queueSeconds;
+	double m_writeSeconds;
+};
+#endif
@@ -0,0 +1,946 @@
+/// @file Deflate.cpp
+/// @brief Contains a deflate compressor (hash chain LZ77 with a dynamic Huffman code per block), a decompressor and the Adler-32 and CRC-32 checksums
+/// https://www.rfc-editor.org/rfc/rfc1951 and https://www.rfc-editor.org/rfc/rfc1950 used for help with the stream format
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "Deflate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEFLATE_SSE2 (1)   // Macro for whether the checksums can use SSE2, the same test SphereSoA.h makes
+#include <emmintrin.h>
+#else
+#define DEFLATE_SSE2 (0)
+#endif
+
+#define DEFLATE_WINDOW_SIZE (32768)   // Macro for how far back a match can reach, the most deflate allows
+#define DEFLATE_HASH_BITS (15)   // Macro for the size of the hash table the match finder looks up three byte strings in
+#define DEFLATE_MAX_CHAIN (32)   // Macro for how many earlier positions with the same hash are tried before taking the best so far
+#define DEFLATE_MIN_MATCH (3)
+#define DEFLATE_MAX_MATCH (258)
+#define DEFLATE_BLOCK_TOKENS (16384)   // Macro for how many literals and matches share one Huffman code before a new block starts
+
+namespace
+{
+	const unsigned short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const unsigned char lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const unsigned short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const unsigned char distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const unsigned char codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	struct Token
+	{
+		unsigned short length;   // 0 for a literal
+		unsigned short value;   // The literal byte, or how far back the match starts
+	};
+
+	class BitWriter   // Deflate packs bits from the lowest bit of each byte up
+	{
+	public:
+
+		BitWriter(std::vector<unsigned char> *_output)
+		{
+			m_output = _output;
+			m_bits = 0;
+			m_bitCount = 0;
+		}
+
+		void Write(unsigned int _bits, int _count)
+		{
+			m_bits |= (unsigned long long)_bits << m_bitCount;
+			m_bitCount += _count;
+
+			while ( m_bitCount >= 8 )
+			{
+				m_output->push_back((unsigned char)m_bits);
+				m_bits >>= 8;
+				m_bitCount -= 8;
+			}
+		}
+
+		void AlignToByte()
+		{
+			if ( m_bitCount > 0 )
+			{
+				Write(0, 8 - m_bitCount);
+			}
+		}
+
+	private:
+
+		std::vector<unsigned char> *m_output;
+		unsigned long long m_bits;
+		int m_bitCount;
+	};
+
+	int LengthCode(int _length)   // Index into lengthBase, the symbol is 257 more than this
+	{
+		return (int)(std::upper_bound(lengthBase, lengthBase + 29, _length) - lengthBase) - 1;
+	}
+
+	int DistanceCode(int _distance)
+	{
+		return (int)(std::upper_bound(distanceBase, distanceBase + 30, _distance) - distanceBase) - 1;
+	}
+
+	unsigned int Hash(const unsigned char *_data)
+	{
+		return ((_data[0] << 10) ^ (_data[1] << 5) ^ _data[2]) & ((1 << DEFLATE_HASH_BITS) - 1);
+	}
+
+	void FindTokens(const unsigned char *_data, size_t _size, std::vector<Token> *_tokens)
+	{
+		// head holds the latest position for each hash and previous links each position to the one before it with the same hash
+
+		std::vector<int> head(1 << DEFLATE_HASH_BITS, -1);
+		std::vector<int> previous(DEFLATE_WINDOW_SIZE, -1);
+
+		size_t position = 0;
+
+		auto insert = [&](size_t _position)
+		{
+			if ( _position + DEFLATE_MIN_MATCH <= _size )
+			{
+				unsigned int hash = Hash(&_data[_position]);
+				previous[_position & (DEFLATE_WINDOW_SIZE - 1)] = head[hash];
+				head[hash] = (int)_position;
+			}
+		};
+
+		while ( position < _size )
+		{
+			int bestLength = 0;
+			int bestDistance = 0;
+
+			if ( position + DEFLATE_MIN_MATCH <= _size )
+			{
+				int maxLength = (int)std::min((size_t)DEFLATE_MAX_MATCH, _size - position);
+				int candidate = head[Hash(&_data[position])];
+				int chain = DEFLATE_MAX_CHAIN;
+
+				while ( candidate >= 0 && position - candidate < DEFLATE_WINDOW_SIZE && chain-- > 0 )
+				{
+					if ( _data[candidate + bestLength] == _data[position + bestLength] )   // Can't beat the best so far unless this byte matches
+					{
+						int length = 0;
+
+						while ( length < maxLength && _data[candidate + length] == _data[position + length] )
+						{
+							length++;
+						}
+
+						if ( length > bestLength )
+						{
+							bestLength = length;
+							bestDistance = (int)(position - candidate);
+
+							if ( length == maxLength )
+							{
+								break;
+							}
+						}
+					}
+
+					candidate = previous[candidate & (DEFLATE_WINDOW_SIZE - 1)];
+				}
+			}
+
+			Token token;
+
+			if ( bestLength >= DEFLATE_MIN_MATCH )
+			{
+				token.length = (unsigned short)bestLength;
+				token.value = (unsigned short)bestDistance;
+
+				for ( int i = 0; i < bestLength; ++i )
+				{
+					insert(position + i);
+				}
+
+				position += bestLength;
+			}
+			else
+			{
+				token.length = 0;
+				token.value = _data[position];
+
+				insert(position);
+				position++;
+			}
+
+			_tokens->push_back(token);
+		}
+	}
+
+	void BuildCodeLengths(const unsigned int *_frequencies, int _symbolCount, int _maxBits, unsigned char *_lengths)
+	{
+		std::vector<unsigned int> frequencies(_frequencies, _frequencies + _symbolCount);
+
+		while ( true )
+		{
+			// Huffman's algorithm, nodes are only ever appended so a parent always comes after its children
+
+			std::vector<int> parent;
+			std::priority_queue<std::pair<unsigned int, int>, std::vector<std::pair<unsigned int, int>>, std::greater<std::pair<unsigned int, int>>> queue;
+			std::vector<int> leaves(_symbolCount, -1);
+
+			for ( int i = 0; i < _symbolCount; ++i )
+			{
+				if ( frequencies[i] > 0 )
+				{
+					leaves[i] = (int)parent.size();
+					queue.push(std::make_pair(frequencies[i], (int)parent.size()));
+					parent.push_back(-1);
+				}
+			}
+
+			while ( queue.size() > 1 )
+			{
+				std::pair<unsigned int, int> first = queue.top();
+				queue.pop();
+				std::pair<unsigned int, int> second = queue.top();
+				queue.pop();
+
+				parent[first.second] = (int)parent.size();
+				parent[second.second] = (int)parent.size();
+				queue.push(std::make_pair(first.first + second.first, (int)parent.size()));
+				parent.push_back(-1);
+			}
+
+			std::vector<int> depth(parent.size(), 0);
+			int maxDepth = 0;
+
+			for ( int i = (int)parent.size() - 2; i >= 0; --i )
+			{
+				depth[i] = depth[parent[i]] + 1;
+				maxDepth = std::max(maxDepth, depth[i]);
+			}
+
+			if ( maxDepth <= _maxBits )
+			{
+				for ( int i = 0; i < _symbolCount; ++i )
+				{
+					_lengths[i] = leaves[i] >= 0 ? (unsigned char)depth[leaves[i]] : 0;
+				}
+
+				return;
+			}
+
+			for ( int i = 0; i < _symbolCount; ++i )   // Too deep, flatten the frequencies and try again
+			{
+				frequencies[i] = (frequencies[i] + 1) / 2;
+			}
+		}
+	}
+
+	void BuildCodes(const unsigned char *_lengths, int _symbolCount, unsigned short *_codes)
+	{
+		int lengthCount[16] = { 0 };
+		int nextCode[16] = { 0 };
+
+		for ( int i = 0; i < _symbolCount; ++i )
+		{
+			lengthCount[_lengths[i]]++;
+		}
+
+		lengthCount[0] = 0;
+
+		for ( int bits = 1, code = 0; bits < 16; ++bits )
+		{
+			code = (code + lengthCount[bits - 1]) << 1;
+			nextCode[bits] = code;
+		}
+
+		for ( int i = 0; i < _symbolCount; ++i )
+		{
+			int code = _lengths[i] > 0 ? nextCode[_lengths[i]]++ : 0;
+			int reversed = 0;
+
+			for ( int bit = 0; bit < _lengths[i]; ++bit )   // Huffman codes go in most significant bit first
+			{
+				reversed = (reversed << 1) | ((code >> bit) & 1);
+			}
+
+			_codes[i] = (unsigned short)reversed;
+		}
+	}
+
+	void EnsureTwoSymbols(unsigned int *_frequencies, int _symbolCount)
+	{
+		// A code with one symbol can't be complete, zlib only accepts that for distances, so every alphabet gets at least two
+
+		int used = 0;
+
+		for ( int i = 0; i < _symbolCount; ++i )
+		{
+			used += _frequencies[i] > 0;
+		}
+
+		for ( int i = 0; i < _symbolCount && used < 2; ++i )
+		{
+			if ( _frequencies[i] == 0 )
+			{
+				_frequencies[i] = 1;
+				used++;
+			}
+		}
+	}
+
+	void WriteBlock(BitWriter &_writer, const std::vector<Token> &_tokens, size_t _first, size_t _count, bool _final)
+	{
+		unsigned int literalFrequencies[286] = { 0 };
+		unsigned int distanceFrequencies[30] = { 0 };
+
+		for ( size_t i = _first; i < _first + _count; ++i )
+		{
+			if ( _tokens[i].length == 0 )
+			{
+				literalFrequencies[_tokens[i].value]++;
+			}
+			else
+			{
+				literalFrequencies[257 + LengthCode(_tokens[i].length)]++;
+				distanceFrequencies[DistanceCode(_tokens[i].value)]++;
+			}
+		}
+
+		literalFrequencies[256] = 1;   // End of block
+
+		EnsureTwoSymbols(literalFrequencies, 286);
+		EnsureTwoSymbols(distanceFrequencies, 30);
+
+		unsigned char literalLengths[286];
+		unsigned char distanceLengths[30];
+		unsigned short literalCodes[286];
+		unsigned short distanceCodes[30];
+
+		BuildCodeLengths(literalFrequencies, 286, 15, literalLengths);
+		BuildCodeLengths(distanceFrequencies, 30, 15, distanceLengths);
+		BuildCodes(literalLengths, 286, literalCodes);
+		BuildCodes(distanceLengths, 30, distanceCodes);
+
+		int literalCount = 286;
+		int distanceCount = 30;
+
+		while ( literalCount > 257 && literalLengths[literalCount - 1] == 0 )
+		{
+			literalCount--;
+		}
+
+		while ( distanceCount > 1 && distanceLengths[distanceCount - 1] == 0 )
+		{
+			distanceCount--;
+		}
+
+		// The two sets of code lengths are sent as one run length coded list, which has its own small Huffman code
+
+		std::vector<unsigned char> lengths(literalLengths, literalLengths + literalCount);
+		lengths.insert(lengths.end(), distanceLengths, distanceLengths + distanceCount);
+
+		std::vector<std::pair<int, int>> runs;   // Code length symbol and the value of its extra bits
+		unsigned int codeLengthFrequencies[19] = { 0 };
+
+		for ( size_t i = 0; i < lengths.size(); )
+		{
+			int length = lengths[i];
+			int run = 1;
+
+			while ( i + run < lengths.size() && lengths[i + run] == length )
+			{
+				run++;
+			}
+
+			i += run;
+
+			if ( length == 0 )
+			{
+				while ( run >= 11 )
+				{
+					int count = std::min(run, 138);
+					runs.push_back(std::make_pair(18, count - 11));
+					run -= count;
+				}
+
+				if ( run >= 3 )
+				{
+					runs.push_back(std::make_pair(17, run - 3));
+					run = 0;
+				}
+			}
+			else
+			{
+				runs.push_back(std::make_pair(length, 0));
+				run--;
+
+				while ( run >= 3 )
+				{
+					int count = std::min(run, 6);
+					runs.push_back(std::make_pair(16, count - 3));
+					run -= count;
+				}
+			}
+
+			for ( ; run > 0; --run )
+			{
+				runs.push_back(std::make_pair(length, 0));
+			}
+		}
+
+		for ( size_t i = 0; i < runs.size(); ++i )
+		{
+			codeLengthFrequencies[runs[i].first]++;
+		}
+
+		EnsureTwoSymbols(codeLengthFrequencies, 19);
+
+		unsigned char codeLengthLengths[19];
+		unsigned short codeLengthCodes[19];
+
+		BuildCodeLengths(codeLengthFrequencies, 19, 7, codeLengthLengths);
+		BuildCodes(codeLengthLengths, 19, codeLengthCodes);
+
+		int codeLengthCount = 19;
+
+		while ( codeLengthCount > 4 && codeLengthLengths[codeLengthOrder[codeLengthCount - 1]] == 0 )
+		{
+			codeLengthCount--;
+		}
+
+		_writer.Write(_final ? 1 : 0, 1);
+		_writer.Write(2, 2);   // Dynamic Huffman block
+		_writer.Write(literalCount - 257, 5);
+		_writer.Write(distanceCount - 1, 5);
+		_writer.Write(codeLengthCount - 4, 4);
+
+		for ( int i = 0; i < codeLengthCount; ++i )
+		{
+			_writer.Write(codeLengthLengths[codeLengthOrder[i]], 3);
+		}
+
+		for ( size_t i = 0; i < runs.size(); ++i )
+		{
+			int symbol = runs[i].first;
+			_writer.Write(codeLengthCodes[symbol], codeLengthLengths[symbol]);
+
+			if ( symbol >= 16 )
+			{
+				const int extraBits[3] = { 2, 3, 7 };
+				_writer.Write(runs[i].second, extraBits[symbol - 16]);
+			}
+		}
+
+		for ( size_t i = _first; i < _first + _count; ++i )
+		{
+			const Token &token = _tokens[i];
+
+			if ( token.length == 0 )
+			{
+				_writer.Write(literalCodes[token.value], literalLengths[token.value]);
+				continue;
+			}
+
+			int lengthCode = LengthCode(token.length);
+			int distanceCode = DistanceCode(token.value);
+
+			_writer.Write(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+			_writer.Write(token.length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+			_writer.Write(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+			_writer.Write(token.value - distanceBase[distanceCode], distanceExtra[distanceCode]);
+		}
+
+		_writer.Write(literalCodes[256], literalLengths[256]);
+	}
+
+	std::vector<unsigned int> MakeCrcTable()
+	{
+		std::vector<unsigned int> table(256);
+
+		for ( unsigned int i = 0; i < 256; ++i )
+		{
+			unsigned int crc = i;
+
+			for ( int bit = 0; bit < 8; ++bit )
+			{
+				crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+			}
+
+			table[i] = crc;
+		}
+
+		return table;
+	}
+
+#if DEFLATE_SSE2
+	unsigned int SumLanes(__m128i _values)
+	{
+		alignas(16) unsigned int lanes[4];
+		_mm_store_si128((__m128i*)lanes, _values);
+
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+#endif
+
+	class BitReader   // The other way round from BitWriter, for reading a stream back
+	{
+	public:
+
+		BitReader(const unsigned char *_data, size_t _size)
+		{
+			m_data = _data;
+			m_size = _size;
+			m_position = 0;
+			m_bits = 0;
+			m_bitCount = 0;
+			m_overrun = false;
+		}
+
+		unsigned int Read(int _count)
+		{
+			while ( m_bitCount < _count )
+			{
+				if ( m_position >= m_size )
+				{
+					m_overrun = true;
+					return 0;
+				}
+
+				m_bits |= (unsigned int)m_data[m_position++] << m_bitCount;
+				m_bitCount += 8;
+			}
+
+			unsigned int bits = m_bits & ((1u << _count) - 1);
+			m_bits >>= _count;
+			m_bitCount -= _count;
+
+			return bits;
+		}
+
+		void AlignToByte()   // Whatever is left of the current byte, bytes are only loaded as they're needed so that's all m_bits holds
+		{
+			m_bits = 0;
+			m_bitCount = 0;
+		}
+
+		bool CopyBytes(size_t _count, std::vector<unsigned char> *_output)
+		{
+			if ( _count > m_size - m_position )
+			{
+				m_overrun = true;
+				return false;
+			}
+
+			_output->insert(_output->end(), m_data + m_position, m_data + m_position + _count);
+			m_position += _count;
+
+			return true;
+		}
+
+		bool hasOverrun() { return m_overrun; }
+
+	private:
+
+		const unsigned char *m_data;
+		size_t m_size;
+		size_t m_position;
+		unsigned int m_bits;
+		int m_bitCount;
+		bool m_overrun;
+	};
+
+	struct HuffmanDecoder   // Canonical codes only need the count of each length and the symbols in code order
+	{
+		unsigned short counts[16];
+		unsigned short symbols[288];
+	};
+
+	bool BuildDecoder(const unsigned char *_lengths, int _symbolCount, HuffmanDecoder *_decoder)
+	{
+		for ( int i = 0; i < 16; ++i )
+		{
+			_decoder->counts[i] = 0;
+		}
+
+		for ( int i = 0; i < _symbolCount; ++i )
+		{
+			_decoder->counts[_lengths[i]]++;
+		}
+
+		_decoder->counts[0] = 0;
+
+		int left = 1;
+
+		for ( int length = 1; length < 16; ++length )   // More codes of a length than fit means the lengths are corrupt, fewer is allowed
+		{
+			left = (left << 1) - _decoder->counts[length];
+
+			if ( left < 0 )
+			{
+				return false;
+			}
+		}
+
+		unsigned short offsets[16];
+		offsets[1] = 0;
+
+		for ( int length = 1; length < 15; ++length )
+		{
+			offsets[length + 1] = offsets[length] + _decoder->counts[length];
+		}
+
+		for ( int i = 0; i < _symbolCount; ++i )
+		{
+			if ( _lengths[i] != 0 )
+			{
+				_decoder->symbols[offsets[_lengths[i]]++] = (unsigned short)i;
+			}
+		}
+
+		return true;
+	}
+
+	int DecodeSymbol(BitReader &_reader, const HuffmanDecoder &_decoder)   // A bit at a time, -1 if no code matches
+	{
+		int code = 0;
+		int first = 0;
+		int index = 0;
+
+		for ( int length = 1; length < 16; ++length )
+		{
+			code |= (int)_reader.Read(1);
+
+			int count = _decoder.counts[length];
+
+			if ( code - first < count )
+			{
+				return _decoder.symbols[index + code - first];
+			}
+
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+
+		return -1;
+	}
+
+	bool InflateBlock(BitReader &_reader, const HuffmanDecoder &_literals, const HuffmanDecoder &_distances, size_t _streamStart, size_t _maxSize, std::vector<unsigned char> *_output)
+	{
+		for ( ;; )
+		{
+			int symbol = DecodeSymbol(_reader, _literals);
+
+			if ( symbol < 0 || _reader.hasOverrun() )
+			{
+				return false;
+			}
+
+			if ( symbol < 256 )
+			{
+				if ( _output->size() - _streamStart >= _maxSize )
+				{
+					return false;
+				}
+
+				_output->push_back((unsigned char)symbol);
+				continue;
+			}
+
+			if ( symbol == 256 )
+			{
+				return true;
+			}
+
+			symbol -= 257;
+
+			if ( symbol >= 29 )
+			{
+				return false;
+			}
+
+			size_t length = lengthBase[symbol] + _reader.Read(lengthExtra[symbol]);
+			int distanceCode = DecodeSymbol(_reader, _distances);
+
+			if ( distanceCode < 0 || distanceCode >= 30 )
+			{
+				return false;
+			}
+
+			size_t distance = distanceBase[distanceCode] + _reader.Read(distanceExtra[distanceCode]);
+
+			if ( _reader.hasOverrun() || distance > _output->size() - _streamStart || length > _maxSize - (_output->size() - _streamStart) )
+			{
+				return false;
+			}
+
+			size_t from = _output->size() - distance;
+
+			for ( size_t i = 0; i < length; ++i )   // Byte by byte, a match can overlap the bytes it's copying out
+			{
+				_output->push_back((*_output)[from + i]);
+			}
+		}
+	}
+
+	bool ReadDynamicCodes(BitReader &_reader, HuffmanDecoder *_literals, HuffmanDecoder *_distances)
+	{
+		int literalCount = (int)_reader.Read(5) + 257;
+		int distanceCount = (int)_reader.Read(5) + 1;
+		int codeLengthCount = (int)_reader.Read(4) + 4;
+
+		if ( literalCount > 286 || distanceCount > 30 )
+		{
+			return false;
+		}
+
+		unsigned char codeLengthLengths[19] = {};
+
+		for ( int i = 0; i < codeLengthCount; ++i )
+		{
+			codeLengthLengths[codeLengthOrder[i]] = (unsigned char)_reader.Read(3);
+		}
+
+		HuffmanDecoder codeLengthDecoder;
+
+		if ( !BuildDecoder(codeLengthLengths, 19, &codeLengthDecoder) )
+		{
+			return false;
+		}
+
+		unsigned char lengths[286 + 30];
+		int count = 0;
+
+		while ( count < literalCount + distanceCount )
+		{
+			int symbol = DecodeSymbol(_reader, codeLengthDecoder);
+
+			if ( symbol < 0 || _reader.hasOverrun() )
+			{
+				return false;
+			}
+
+			if ( symbol < 16 )
+			{
+				lengths[count++] = (unsigned char)symbol;
+				continue;
+			}
+
+			unsigned char repeated = 0;
+			int repeats = 0;
+
+			if ( symbol == 16 )
+			{
+				if ( count == 0 )
+				{
+					return false;
+				}
+
+				repeated = lengths[count - 1];
+				repeats = 3 + (int)_reader.Read(2);
+			}
+			else if ( symbol == 17 )
+			{
+				repeats = 3 + (int)_reader.Read(3);
+			}
+			else
+			{
+				repeats = 11 + (int)_reader.Read(7);
+			}
+
+			if ( count + repeats > literalCount + distanceCount )
+			{
+				return false;
+			}
+
+			while ( repeats-- > 0 )
+			{
+				lengths[count++] = repeated;
+			}
+		}
+
+		return BuildDecoder(lengths, literalCount, _literals) && BuildDecoder(lengths + literalCount, distanceCount, _distances);
+	}
+}
+
+void DeflateCompress(const unsigned char *_data, size_t _size, bool _lastPiece, std::vector<unsigned char> *_output)
+{
+	std::vector<Token> tokens;
+	tokens.reserve(_size / 4);
+
+	FindTokens(_data, _size, &tokens);
+
+	BitWriter writer(_output);
+	size_t blockCount = std::max((size_t)1, (tokens.size() + DEFLATE_BLOCK_TOKENS - 1) / DEFLATE_BLOCK_TOKENS);
+
+	for ( size_t block = 0; block < blockCount; ++block )
+	{
+		size_t first = block * DEFLATE_BLOCK_TOKENS;
+		size_t count = std::min((size_t)DEFLATE_BLOCK_TOKENS, tokens.size() - first);
+
+		WriteBlock(writer, tokens, first, count, _lastPiece && block == blockCount - 1);
+	}
+
+	if ( !_lastPiece )   // An empty stored block brings the stream back to a byte boundary so the next piece can be appended as it is
+	{
+		writer.Write(0, 1);
+		writer.Write(0, 2);
+		writer.AlignToByte();
+		writer.Write(0x0000, 16);
+		writer.Write(0xFFFF, 16);
+	}
+
+	writer.AlignToByte();
+}
+
+bool DeflateDecompress(const unsigned char *_data, size_t _size, size_t _maxSize, std::vector<unsigned char> *_output)
+{
+	BitReader reader(_data, _size);
+	size_t streamStart = _output->size();   // Matches can't reach back past where this stream's output starts
+	bool lastBlock = false;
+
+	while ( !lastBlock )
+	{
+		lastBlock = reader.Read(1) == 1;
+		unsigned int type = reader.Read(2);
+
+		if ( type == 0 )   // Stored
+		{
+			reader.AlignToByte();
+
+			unsigned int length = reader.Read(16);
+			unsigned int inverse = reader.Read(16);
+
+			if ( reader.hasOverrun() || (length ^ 0xFFFF) != inverse || length > _maxSize - (_output->size() - streamStart) || !reader.CopyBytes(length, _output) )
+			{
+				return false;
+			}
+		}
+		else if ( type == 1 )   // Fixed Huffman, the code lengths are set by the RFC
+		{
+			unsigned char lengths[288 + 30];
+
+			for ( int i = 0; i < 288; ++i )
+			{
+				lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+			}
+
+			for ( int i = 0; i < 30; ++i )
+			{
+				lengths[288 + i] = 5;
+			}
+
+			HuffmanDecoder literals;
+			HuffmanDecoder distances;
+
+			BuildDecoder(lengths, 288, &literals);
+			BuildDecoder(lengths + 288, 30, &distances);
+
+			if ( !InflateBlock(reader, literals, distances, streamStart, _maxSize, _output) )
+			{
+				return false;
+			}
+		}
+		else if ( type == 2 )
+		{
+			HuffmanDecoder literals;
+			HuffmanDecoder distances;
+
+			if ( !ReadDynamicCodes(reader, &literals, &distances) || !InflateBlock(reader, literals, distances, streamStart, _maxSize, _output) )
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return !reader.hasOverrun();
+}
+
+unsigned int Adler32(const unsigned char *_data, size_t _size, unsigned int _adler)
+{
+	const unsigned int modulus = 65521;
+
+	unsigned int a = _adler & 0xFFFF;
+	unsigned int b = _adler >> 16;
+
+	while ( _size > 0 )
+	{
+		size_t run = std::min(_size, (size_t)5552);   // The longest run that can't overflow 32 bits before the modulo
+		size_t i = 0;
+
+#if DEFLATE_SSE2
+		// Sixteen bytes at a time. Over a block a grows by the bytes' sum, and b by 16 a plus each byte times how many of the block's 16 sums it is in
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i firstWeights = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+		const __m128i secondWeights = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+
+		__m128i sums = zero;   // Of every byte of the run so far
+		__m128i earlierSums = zero;   // Of sums as it stood at the start of each block
+		__m128i weighted = zero;
+
+		for ( ; i + 16 <= run; i += 16 )
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(_data + i));
+
+			earlierSums = _mm_add_epi32(earlierSums, sums);
+			sums = _mm_add_epi32(sums, _mm_sad_epu8(bytes, zero));
+			weighted = _mm_add_epi32(weighted, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), firstWeights));
+			weighted = _mm_add_epi32(weighted, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), secondWeights));
+		}
+
+		// 16 times earlierSums can pass 32 bits on a full run
+
+		b = (unsigned int)((b + (unsigned long long)i * a + 16 * (unsigned long long)SumLanes(earlierSums) + SumLanes(weighted)) % modulus);
+		a += SumLanes(sums);
+#endif
+
+		for ( ; i < run; ++i )
+		{
+			a += _data[i];
+			b += a;
+		}
+
+		a %= modulus;
+		b %= modulus;
+		_data += run;
+		_size -= run;
+	}
+
+	return (b << 16) | a;
+}
+
+unsigned int Adler32Combine(unsigned int _adlerFirst, unsigned int _adlerSecond, size_t _secondSize)
+{
+	const unsigned int modulus = 65521;
+
+	unsigned int remainder = (unsigned int)(_secondSize % modulus);
+	unsigned int a = _adlerFirst & 0xFFFF;
+	unsigned int b = (unsigned int)(((unsigned long long)remainder * a) % modulus);
+
+	a += (_adlerSecond & 0xFFFF) + modulus - 1;
+	b += (_adlerFirst >> 16) + (_adlerSecond >> 16) + modulus - remainder;
+
+	a %= modulus;
+	b %= modulus;
+
+	return (b << 16) | a;
+}
+
+unsigned int Crc32(const unsigned char *_data, size_t _size, unsigned int _crc)
+{
+	static const std::vector<unsigned int> table = MakeCrcTable();
+
+	unsigned int crc = _crc ^ 0xFFFFFFFFu;
+
+	for ( size_t i = 0; i < _size; ++i )
+	{
+		crc = table[(crc ^ _data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xFFFFFFFFu;
+}
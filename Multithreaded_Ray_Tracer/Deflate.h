@@ -0,0 +1,26 @@
+/// \file Deflate.h
+/// \brief Functions for deflate compression, decompression and the checksums PNG and zlib need, so no compression library is needed
+/// \author Thomas Hardy
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <cstddef>
+#include <vector>
+
+// Compresses _data as raw deflate blocks (RFC 1951) and appends them to _output. The output always ends on a byte boundary,
+// if _lastPiece is false the final block isn't marked as the last so another call's output can follow straight on
+
+void DeflateCompress(const unsigned char *_data, size_t _size, bool _lastPiece, std::vector<unsigned char> *_output);
+
+// Appends what a raw deflate stream holds to _output, false if the stream is cut short or corrupt or would add more than _maxSize bytes.
+// The limit stops a stream from the network that repeats one match over and over from taking all the memory before its size can be checked
+
+bool DeflateDecompress(const unsigned char *_data, size_t _size, size_t _maxSize, std::vector<unsigned char> *_output);
+
+unsigned int Adler32(const unsigned char *_data, size_t _size, unsigned int _adler = 1);
+
+unsigned int Adler32Combine(unsigned int _adlerFirst, unsigned int _adlerSecond, size_t _secondSize);   // Adler-32 of two pieces joined together, from the checksum of each
+
+unsigned int Crc32(const unsigned char *_data, size_t _size, unsigned int _crc = 0);
+#endif
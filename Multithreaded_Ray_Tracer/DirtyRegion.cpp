@@ -0,0 +1,168 @@
+/// @file DirtyRegion.cpp
+/// @brief Contains functions for the DirtyRegion class
+/// A shape only changes the pixels whose primary ray reaches it or whose shadow ray passes it. Both lie inside the box swept from the light down to
+/// the floor, and since the camera projection keeps straight lines straight, the screen rectangle around that box's corners covers all of them
+
+#include <algorithm>
+#include <math.h>
+
+#include "DirtyRegion.h"
+#include "Renderer.h"
+
+DirtyRegion::DirtyRegion(int _width, int _height, int _tileSize)
+{
+	m_width = _width;
+	m_height = _height;
+	m_tileSize = std::max(1, _tileSize);
+	m_tilesX = (_width + m_tileSize - 1) / m_tileSize;
+	m_tilesY = (_height + m_tileSize - 1) / m_tileSize;
+	m_dirty.assign((size_t)m_tilesX * m_tilesY, 0);
+}
+
+void DirtyRegion::Clear()
+{
+	std::fill(m_dirty.begin(), m_dirty.end(), 0);
+}
+
+void DirtyRegion::MarkAll()
+{
+	std::fill(m_dirty.begin(), m_dirty.end(), 1);
+}
+
+void DirtyRegion::MarkShape(Scene &_scene, int _shapeIndex)
+{
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
+	if ( !_scene.GetBounds(_shapeIndex, &boundsMin, &boundsMax) )
+	{
+		MarkAll();   // A plane can be seen or shadowed anywhere
+
+		return;
+	}
+
+	MarkBox(_scene, boundsMin, boundsMax);
+}
+
+void DirtyRegion::MarkBox(Scene &_scene, glm::vec3 _boundsMin, glm::vec3 _boundsMax)
+{
+	glm::vec3 lightPosition = LIGHT_POSITION;
+	std::vector<glm::vec3> points;
+	bool shadowStops = false;   // Something catches the shadow, without a plane it could land on anything behind the box
+
+	for ( int corner = 0; corner < 8; ++corner )
+	{
+		points.push_back(glm::vec3(corner & 1 ? _boundsMax.x : _boundsMin.x, corner & 2 ? _boundsMax.y : _boundsMin.y, corner & 4 ? _boundsMax.z : _boundsMin.z));
+	}
+
+	for ( int shape = 0; shape < _scene.getShapeCount(); ++shape )
+	{
+		if ( _scene.getShapeType(shape) != SHAPE_PLANE )
+		{
+			continue;
+		}
+
+		Plane &plane = _scene.getPlane(shape);
+		glm::vec3 normal = plane.getPlaneNormal();
+
+		for ( int corner = 0; corner < 8; ++corner )   // Where the light's ray through each corner meets the plane
+		{
+			glm::vec3 direction = points[corner] - lightPosition;
+			float denominator = glm::dot(normal, direction);
+
+			if ( fabs(denominator) < 1e-6f )
+			{
+				MarkAll();   // The shadow runs along the plane and never lands
+
+				return;
+			}
+
+			float t = glm::dot(normal, plane.getPosition() - lightPosition) / denominator;
+
+			if ( t <= 0.0f )
+			{
+				MarkAll();   // The plane is behind the light
+
+				return;
+			}
+
+			points.push_back(lightPosition + t * direction);
+		}
+
+		shadowStops = true;
+	}
+
+	if ( !shadowStops )
+	{
+		MarkAll();
+
+		return;
+	}
+
+	glm::vec2 pixelMin = glm::vec2(INFINITY, INFINITY);
+	glm::vec2 pixelMax = glm::vec2(-INFINITY, -INFINITY);
+
+	for ( size_t i = 0; i < points.size(); ++i )
+	{
+		glm::vec2 pixel;
+
+		if ( !_scene.getCamera().Project(points[i], &pixel) )
+		{
+			MarkAll();   // Part of it is behind the camera, where the projection no longer keeps lines straight
+
+			return;
+		}
+
+		pixelMin = glm::min(pixelMin, pixel);
+		pixelMax = glm::max(pixelMax, pixel);
+	}
+
+	MarkPixels(pixelMin, pixelMax);
+}
+
+std::vector<Tile> DirtyRegion::getTiles()
+{
+	std::vector<Tile> allTiles = TileScheduler::MakeTiles(m_width, m_height, m_tileSize);
+	std::vector<Tile> tiles;
+
+	for ( size_t i = 0; i < allTiles.size(); ++i )
+	{
+		if ( m_dirty[i] )
+		{
+			tiles.push_back(allTiles[i]);
+		}
+	}
+
+	return tiles;
+}
+
+int DirtyRegion::getDirtyTileCount()
+{
+	return (int)std::count(m_dirty.begin(), m_dirty.end(), 1);
+}
+
+void DirtyRegion::MarkPixels(glm::vec2 _pixelMin, glm::vec2 _pixelMax)
+{
+	// One pixel of margin for rounding, and so the pixels next to the change get their anti-aliasing edges checked again
+
+	_pixelMin = glm::max(_pixelMin, glm::vec2(-2.0f, -2.0f));   // Clamped before turning to ints, a shadow far off along the floor can project well outside the image
+	_pixelMax = glm::min(_pixelMax, glm::vec2(m_width + 2.0f, m_height + 2.0f));
+
+	int minX = std::max(0, (int)floor(_pixelMin.x) - 1);
+	int minY = std::max(0, (int)floor(_pixelMin.y) - 1);
+	int maxX = std::min(m_width - 1, (int)ceil(_pixelMax.x) + 1);
+	int maxY = std::min(m_height - 1, (int)ceil(_pixelMax.y) + 1);
+
+	if ( minX > maxX || minY > maxY )
+	{
+		return;   // Entirely off screen
+	}
+
+	for ( int tileY = minY / m_tileSize; tileY <= maxY / m_tileSize; ++tileY )
+	{
+		for ( int tileX = minX / m_tileSize; tileX <= maxX / m_tileSize; ++tileX )
+		{
+			m_dirty[tileY * m_tilesX + tileX] = 1;
+		}
+	}
+}
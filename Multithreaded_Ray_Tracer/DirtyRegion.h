@@ -0,0 +1,46 @@
+/// \file DirtyRegion.h
+/// \brief Class for the 'DirtyRegion' which works out which tiles a change to the scene can have touched
+/// \author Thomas Hardy
+
+#ifndef DIRTYREGION_H
+#define DIRTYREGION_H
+
+#include <vector>
+#include <glm.hpp>
+
+#include "Scene.h"
+#include "TileScheduler.h"
+
+class DirtyRegion
+{
+public:
+
+	DirtyRegion(int _width, int _height, int _tileSize);
+
+	void Clear();   // Call once the dirty tiles have been rendered
+
+	void MarkAll();
+
+	void MarkShape(Scene &_scene, int _shapeIndex);   // Call before and after changing a shape, so both where it was and where it is now get redrawn
+
+	void MarkBox(Scene &_scene, glm::vec3 _boundsMin, glm::vec3 _boundsMax);   // The box on screen plus the shadow it casts down to the scene's planes, the camera's resolution has to match the region's
+
+	std::vector<Tile> getTiles();   // The dirty tiles in row order, with the same bounds and indices TileScheduler::MakeTiles gives them
+
+	int getDirtyTileCount();
+
+	int getTileCount() { return m_tilesX * m_tilesY; }
+
+private:
+
+	void MarkPixels(glm::vec2 _pixelMin, glm::vec2 _pixelMax);
+
+	int m_width;
+	int m_height;
+	int m_tileSize;
+	int m_tilesX;
+	int m_tilesY;
+
+	std::vector<unsigned char> m_dirty;   // One per tile, row by row
+};
+#endif
@@ -0,0 +1,99 @@
+/// @file Framebuffer.cpp
+/// @brief Contains functions for the Framebuffer class
+/// Every row starts on a cache line, so with tile widths that are a multiple of 16 pixels two threads never write to the same line
+
+#include <memory>
+#include <algorithm>
+
+#include "Framebuffer.h"
+#include "SphereSoA.h"   // For SPHERE_SIMD_WIDTH, what vector unit the build can use
+
+#if SPHERE_SIMD_WIDTH > 1
+#include <immintrin.h>
+#endif
+
+Framebuffer::Framebuffer()
+{
+	m_pixels = nullptr;
+	m_width = 0;
+	m_height = 0;
+	m_stride = 0;
+}
+
+Framebuffer::Framebuffer(int _width, int _height, bool _clear)
+{
+	m_pixels = nullptr;
+	Resize(_width, _height, _clear);
+}
+
+void Framebuffer::Resize(int _width, int _height, bool _clear)
+{
+	// A vec3 is 12 bytes, so a row has to be a multiple of 16 pixels (192 bytes, three lines) to end on a cache line
+
+	const int pixelsPerAlignedRun = 16;
+
+	m_width = _width;
+	m_height = _height;
+	m_stride = (_width + pixelsPerAlignedRun - 1) / pixelsPerAlignedRun * pixelsPerAlignedRun;
+
+	size_t pixelCount = (size_t)m_stride * _height;
+	size_t size = pixelCount * sizeof(glm::vec3);
+
+	size_t space = size + FRAMEBUFFER_ALIGNMENT;
+
+	m_memory.reset(new unsigned char[space]);
+
+	void *start = m_memory.get();
+
+	m_pixels = static_cast<glm::vec3*>(std::align(FRAMEBUFFER_ALIGNMENT, size, start, space));
+
+	if ( _clear )
+	{
+		std::uninitialized_fill_n(m_pixels, pixelCount, glm::vec3(0, 0, 0));
+	}
+}
+
+void Framebuffer::Clear(glm::vec3 _colour)
+{
+	std::fill_n(m_pixels, (size_t)m_stride * m_height, _colour);
+}
+
+void Framebuffer::QuantizeRow(int _y, int _minX, int _maxX, unsigned char *_bytes)
+{
+	const float *channels = &getRow(_y)[_minX].x;   // RGBRGB.. one after another, the same order as the bytes
+	int count = (_maxX - _minX) * 3;
+	int i = 0;
+
+#if SPHERE_SIMD_WIDTH > 1
+	// Sixteen channels at a time, with the same clamp, multiply and truncation as the loop below so the bytes come out the same
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+
+	for ( ; i + 16 <= count; i += 16 )
+	{
+		__m128i first = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(channels + i), one), scale));
+		__m128i second = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(channels + i + 4), one), scale));
+		__m128i third = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(channels + i + 8), one), scale));
+		__m128i fourth = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(channels + i + 12), one), scale));
+
+		_mm_storeu_si128((__m128i*)(_bytes + i), _mm_packus_epi16(_mm_packs_epi32(first, second), _mm_packs_epi32(third, fourth)));
+	}
+#endif
+
+	for ( ; i < count; ++i )
+	{
+		_bytes[i] = (unsigned char)(std::min((float)1, channels[i]) * 255);
+	}
+}
+
+void Framebuffer::DequantizeRow(int _y, int _minX, int _maxX, const unsigned char *_bytes)
+{
+	float *channels = &getRow(_y)[_minX].x;
+	int count = (_maxX - _minX) * 3;
+
+	for ( int i = 0; i < count; ++i )   // The middle of each byte's range, so quantizing again gives back the same byte
+	{
+		channels[i] = (_bytes[i] + 0.5f) / 255.0f;
+	}
+}
@@ -0,0 +1,51 @@
+/// \file Framebuffer.h
+/// \brief Class for the 'Framebuffer' which holds the rendered image in one block of memory, row by row
+/// \author Thomas Hardy
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <memory>
+#include <glm.hpp>
+
+#define FRAMEBUFFER_ALIGNMENT (64)   // Macro for the cache line size rows are lined up to
+
+class Framebuffer
+{
+public:
+
+	Framebuffer();
+
+	Framebuffer(int _width, int _height, bool _clear = true);
+
+	Framebuffer(const Framebuffer&) = delete;   // m_pixels points into m_memory, so a copy would point into the wrong buffer
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	void Resize(int _width, int _height, bool _clear = true);   // _clear false leaves the pages unwritten, so on a NUMA machine each lands on the node of the render thread that first writes it
+
+	void Clear(glm::vec3 _colour);
+
+	void QuantizeRow(int _y, int _minX, int _maxX, unsigned char *_bytes);   // Pixels [_minX, _maxX) of row _y as 8 bit RGB, clamped at 1 like the PPM has always been
+
+	void DequantizeRow(int _y, int _minX, int _maxX, const unsigned char *_bytes);   // QuantizeRow the other way, for pixels that were saved as bytes
+
+	glm::vec3& getPixel( int _x, int _y ) { return m_pixels[(size_t)_y * m_stride + _x]; }
+
+	glm::vec3* getRow( int _y ) { return &m_pixels[(size_t)_y * m_stride]; }
+
+	int getWidth() { return m_width; }
+
+	int getHeight() { return m_height; }
+
+	int getStride() { return m_stride; }   // Pixels from the start of one row to the start of the next
+
+private:
+
+	std::unique_ptr<unsigned char[]> m_memory;   // Not a vector, a vector would write every byte on the thread that made it
+	glm::vec3 *m_pixels;   // First cache line aligned byte of m_memory
+
+	int m_width;
+	int m_height;
+	int m_stride;
+};
+#endif
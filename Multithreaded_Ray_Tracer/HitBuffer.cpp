@@ -0,0 +1,39 @@
+/// @file HitBuffer.cpp
+/// @brief Contains functions for the HitBuffer class
+
+#include <algorithm>
+#include <memory>
+
+#include "HitBuffer.h"
+
+HitBuffer::HitBuffer()
+{
+	m_hits = nullptr;
+	m_width = 0;
+	m_height = 0;
+}
+
+HitBuffer::HitBuffer(int _width, int _height, bool _clear)
+{
+	m_hits = nullptr;
+	Resize(_width, _height, _clear);
+}
+
+void HitBuffer::Resize(int _width, int _height, bool _clear)
+{
+	size_t pixelCount = (size_t)_width * _height;
+
+	m_width = _width;
+	m_height = _height;
+	m_memory.reset(new unsigned char[pixelCount * sizeof(HitRecord)]);   // new already aligns for anything as large as a float
+	m_hits = reinterpret_cast<HitRecord*>(m_memory.get());
+	m_edges.reset(new unsigned char[pixelCount]);
+
+	if ( _clear )
+	{
+		HitRecord miss = { 0.0f, 0, glm::vec3(0, 0, 0) };
+
+		std::uninitialized_fill_n(m_hits, pixelCount, miss);
+		std::fill_n(m_edges.get(), pixelCount, 0);
+	}
+}
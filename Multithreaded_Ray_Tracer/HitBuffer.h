@@ -0,0 +1,45 @@
+/// \file HitBuffer.h
+/// \brief Class for the 'HitBuffer' which holds what each pixel's primary ray hit, between the intersection and shading passes, and which pixels are on an edge
+/// \author Thomas Hardy
+
+#ifndef HITBUFFER_H
+#define HITBUFFER_H
+
+#include <memory>
+#include <glm.hpp>
+
+struct HitRecord   // 20 bytes per pixel
+{
+	float t;   // Distance along the primary ray, INFINITY on a miss
+	int shapeHit;   // Scene shape index, -1 on a miss
+	glm::vec3 normal;   // Normalised surface normal at the hit
+};
+
+class HitBuffer
+{
+public:
+
+	HitBuffer();
+
+	HitBuffer(int _width, int _height, bool _clear = true);
+
+	void Resize(int _width, int _height, bool _clear = true);   // _clear false leaves the pages for the render threads to place, like Framebuffer
+
+	HitRecord& getHit( int _x, int _y ) { return m_hits[_y * m_width + _x]; }
+
+	unsigned char& getEdge( int _x, int _y ) { return m_edges[_y * m_width + _x]; }   // Set by the edge pass for pixels that get more samples
+
+	int getWidth() { return m_width; }
+
+	int getHeight() { return m_height; }
+
+private:
+
+	std::unique_ptr<unsigned char[]> m_memory;   // Raw bytes, glm::vec3's constructor would write every record on the thread that made them
+	HitRecord *m_hits;   // Row by row, at the start of m_memory
+	std::unique_ptr<unsigned char[]> m_edges;   // Kept apart from the hits so the edge pass doesn't write into lines the shading pass reads
+
+	int m_width;
+	int m_height;
+};
+#endif
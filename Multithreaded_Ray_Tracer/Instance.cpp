@@ -0,0 +1,80 @@
+/// @file Instance.cpp
+/// @brief Contains functions for the instance object/class
+
+#include <glm.hpp>
+
+#include "Instance.h"
+
+Instance::Instance(std::shared_ptr<Shape> _geometry, const glm::mat4 &_objectToWorld) : m_geometry(_geometry)
+{
+	setPosition(glm::vec3(_objectToWorld[3]));
+	setColour(m_geometry->getColour());
+
+	m_worldToObject = glm::mat4x3(glm::inverse(_objectToWorld));
+
+	glm::vec3 geometryMin;
+	glm::vec3 geometryMax;
+
+	m_bounded = m_geometry->GetBounds(&geometryMin, &geometryMax);
+	m_boundsMin = glm::vec3(INFINITY);
+	m_boundsMax = glm::vec3(-INFINITY);
+
+	for ( int corner = 0; corner < 8 && m_bounded; ++corner )   // Worked out once here, the scene's BVH asks for them when it is built
+	{
+		glm::vec3 point = glm::vec3(corner & 1 ? geometryMax.x : geometryMin.x, corner & 2 ? geometryMax.y : geometryMin.y, corner & 4 ? geometryMax.z : geometryMin.z);
+		glm::vec3 world = glm::vec3(_objectToWorld * glm::vec4(point, 1.0f));
+
+		m_boundsMin = glm::min(m_boundsMin, world);
+		m_boundsMax = glm::max(m_boundsMax, world);
+	}
+}
+
+bool Instance::Intersection(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *t)
+{
+	glm::vec3 origin = m_worldToObject * glm::vec4(_rayOrigin, 1.0f);
+	glm::vec3 direction = m_worldToObject * glm::vec4(_rayDirection, 0.0f);
+
+	// The shapes expect a unit direction, so a scaled instance hands over the normalised one and converts t back after
+
+	float scale = glm::length(direction);
+	float t0 = 0.0f;
+
+	if ( scale == 0.0f || !m_geometry->Intersection(origin, direction / scale, &t0) )
+	{
+		return false;
+	}
+
+	*t = t0 / scale;
+
+	return true;
+}
+
+glm::vec3 Instance::CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour)
+{
+	SurfacePoint surface = Surface(_p0);
+	*shininess = surface.shininess;
+	*diffuseColour = surface.diffuseColour;
+	*specularColour = surface.specularColour;
+	return surface.normal;
+}
+
+SurfacePoint Instance::Surface(glm::vec3 _p0)
+{
+	SurfacePoint surface = m_geometry->Surface(m_worldToObject * glm::vec4(_p0, 1.0f));
+
+	surface.normal = glm::transpose(glm::mat3(m_worldToObject)) * surface.normal;   // Normals go back by the inverse transpose so non uniform scales keep them at right angles
+
+	return surface;
+}
+
+SurfacePoint Instance::Material(glm::vec3 _p0)
+{
+	return m_geometry->Material(m_worldToObject * glm::vec4(_p0, 1.0f));
+}
+
+bool Instance::GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax)
+{
+	*_boundsMin = m_boundsMin;
+	*_boundsMax = m_boundsMax;
+	return m_bounded;
+}
@@ -0,0 +1,41 @@
+/// \file Instance.h
+/// \brief Class for the 'Instance' object, a placed copy of shared geometry that only stores its own transform
+/// \author Thomas Hardy
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <memory>
+#include <glm.hpp>
+
+#include "Shape.h"
+
+class Instance final : public Shape   // Final so calls on an Instance the compiler can see skip the vtable
+{
+public:
+
+	Instance(std::shared_ptr<Shape> _geometry, const glm::mat4 &_objectToWorld);   // The geometry is shared, any number of instances can point at one mesh or sphere
+
+	bool Intersection(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *t);   // Moves the ray into object space rather than the geometry into world space
+
+	glm::vec3 CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour);
+
+	SurfacePoint Surface(glm::vec3 _p0);
+
+	SurfacePoint Material(glm::vec3 _p0);
+
+	bool GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax);   // The geometry's box with its corners moved into world space
+
+	const std::shared_ptr<Shape>& getGeometry() { return m_geometry; }
+
+private:
+
+	std::shared_ptr<Shape> m_geometry;
+
+	glm::mat4x3 m_worldToObject;   // The bottom row of an affine transform is always 0 0 0 1 so it isn't stored
+
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+	bool m_bounded;
+};
+#endif
@@ -0,0 +1,129 @@
+/// @file MappedPPM.cpp
+/// @brief Contains functions for the MappedPPM class
+/// The file is sized before anything is rendered, so each tile knows where its bytes go and no write is left for the end
+
+#include <string>
+
+#include "MappedPPM.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX   // Stops windows.h defining min and max macros
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedPPM::MappedPPM()
+{
+	m_data = nullptr;
+	m_pixels = nullptr;
+	m_size = 0;
+	m_width = 0;
+	m_height = 0;
+
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	m_fileDescriptor = -1;
+#endif
+}
+
+MappedPPM::~MappedPPM()
+{
+	Close();
+}
+
+bool MappedPPM::Open(const std::string &_path, int _width, int _height)
+{
+	Close();
+
+	std::string header = "P6\n" + std::to_string(_width) + " " + std::to_string(_height) + "\n255\n";   // Same header EncodePPM writes
+
+	m_width = _width;
+	m_height = _height;
+	m_size = header.size() + (size_t)_width * _height * 3;
+
+#ifdef _WIN32
+	m_file = CreateFileA(_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if ( m_file == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)m_size >> 32), (DWORD)(m_size & 0xFFFFFFFF), nullptr);   // Also grows the file to m_size
+
+	if ( m_mapping != nullptr )
+	{
+		m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, m_size));
+	}
+#else
+	m_fileDescriptor = open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if ( m_fileDescriptor < 0 )
+	{
+		return false;
+	}
+
+	if ( ftruncate(m_fileDescriptor, (off_t)m_size) == 0 )
+	{
+		void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fileDescriptor, 0);
+		m_data = data != MAP_FAILED ? static_cast<unsigned char*>(data) : nullptr;
+	}
+#endif
+
+	if ( m_data == nullptr )
+	{
+		Close();
+		return false;
+	}
+
+	header.copy((char*)m_data, header.size());
+	m_pixels = m_data + header.size();
+
+	return true;
+}
+
+void MappedPPM::Close()
+{
+#ifdef _WIN32
+	if ( m_data != nullptr )
+	{
+		UnmapViewOfFile(m_data);
+	}
+
+	if ( m_mapping != nullptr )
+	{
+		CloseHandle(m_mapping);
+	}
+
+	if ( m_file != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle(m_file);
+	}
+
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	if ( m_data != nullptr )
+	{
+		munmap(m_data, m_size);
+	}
+
+	if ( m_fileDescriptor >= 0 )
+	{
+		close(m_fileDescriptor);
+	}
+
+	m_fileDescriptor = -1;
+#endif
+
+	m_data = nullptr;
+	m_pixels = nullptr;
+	m_size = 0;
+}
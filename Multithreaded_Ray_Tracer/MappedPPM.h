@@ -0,0 +1,45 @@
+/// \file MappedPPM.h
+/// \brief Class for the 'MappedPPM' which creates a PPM file at its final size and maps it so threads can write pixels straight into it
+/// \author Thomas Hardy
+
+#ifndef MAPPEDPPM_H
+#define MAPPEDPPM_H
+
+#include <string>
+
+class MappedPPM
+{
+public:
+
+	MappedPPM();
+
+	~MappedPPM();
+
+	MappedPPM(const MappedPPM&) = delete;
+	MappedPPM& operator=(const MappedPPM&) = delete;
+
+	bool Open(const std::string &_path, int _width, int _height);   // Writes the header and maps the file, false if the file couldn't be made or mapped
+
+	void Close();   // Unmaps the file, the OS writes back whatever it hasn't already
+
+	unsigned char* getRow( int _y ) { return m_pixels + (size_t)_y * m_width * 3; }   // Three bytes per pixel, rows don't overlap so threads can fill them at the same time
+
+	bool isOpen() { return m_data != nullptr; }
+
+private:
+
+	unsigned char *m_data;   // Start of the mapping, the header comes first
+	unsigned char *m_pixels;   // First byte after the header
+	size_t m_size;
+
+	int m_width;
+	int m_height;
+
+#ifdef _WIN32
+	void *m_file;   // HANDLE, kept as void* so windows.h stays out of the header
+	void *m_mapping;
+#else
+	int m_fileDescriptor;
+#endif
+};
+#endif
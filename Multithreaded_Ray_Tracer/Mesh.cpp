@@ -0,0 +1,459 @@
+/// @file Mesh.cpp
+/// @brief Contains functions for the triangle mesh object/class
+/// http://jcgt.org/published/0002/01/05/ (Woop, Benthin and Wald, Watertight Ray/Triangle Intersection) used for help with the triangle test
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <glm.hpp>
+
+#include "Mesh.h"
+
+#define MESH_OBJ_CHUNK (1 << 20)   // Macro for how many bytes of the OBJ file are read at a time
+
+namespace
+{
+	struct RayShear   // Works once per ray so each triangle test only has to shear its three vertices
+	{
+		int kx;
+		int ky;
+		int kz;   // The axis the ray travels furthest along
+		float shearX;
+		float shearY;
+		float shearZ;
+	};
+
+	RayShear CreateRayShear(glm::vec3 _rayDirection)
+	{
+		RayShear shear;
+		glm::vec3 absolute = glm::abs(_rayDirection);
+
+		shear.kz = absolute.x > absolute.y ? (absolute.x > absolute.z ? 0 : 2) : (absolute.y > absolute.z ? 1 : 2);
+		shear.kx = (shear.kz + 1) % 3;
+		shear.ky = (shear.kx + 1) % 3;
+
+		if ( _rayDirection[shear.kz] < 0.0f )   // Keeps the triangle's winding the same after the axes are swapped round
+		{
+			std::swap(shear.kx, shear.ky);
+		}
+
+		shear.shearX = _rayDirection[shear.kx] / _rayDirection[shear.kz];
+		shear.shearY = _rayDirection[shear.ky] / _rayDirection[shear.kz];
+		shear.shearZ = 1.0f / _rayDirection[shear.kz];
+
+		return shear;
+	}
+
+	// Moves the triangle so the ray starts at the origin and runs down +z, then tests the origin against the 2D edge functions.
+	// Two triangles sharing an edge work out that edge's function from the same numbers, so a ray can't slip between them
+
+	bool IntersectTriangle(const RayShear &_shear, glm::vec3 _rayOrigin, glm::vec3 _a, glm::vec3 _b, glm::vec3 _c, float _maxT, float *_t)
+	{
+		glm::vec3 a = _a - _rayOrigin;
+		glm::vec3 b = _b - _rayOrigin;
+		glm::vec3 c = _c - _rayOrigin;
+
+		float ax = a[_shear.kx] - _shear.shearX * a[_shear.kz];
+		float ay = a[_shear.ky] - _shear.shearY * a[_shear.kz];
+		float bx = b[_shear.kx] - _shear.shearX * b[_shear.kz];
+		float by = b[_shear.ky] - _shear.shearY * b[_shear.kz];
+		float cx = c[_shear.kx] - _shear.shearX * c[_shear.kz];
+		float cy = c[_shear.ky] - _shear.shearY * c[_shear.kz];
+
+		float u = cx * by - cy * bx;
+		float v = ax * cy - ay * cx;
+		float w = bx * ay - by * ax;
+
+		if ( u == 0.0f || v == 0.0f || w == 0.0f )   // The ray is on an edge, work it out again in double so neighbours agree who owns it
+		{
+			u = (float)((double)cx * by - (double)cy * bx);
+			v = (float)((double)ax * cy - (double)ay * cx);
+			w = (float)((double)bx * ay - (double)by * ax);
+		}
+
+		if ( (u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f) )   // Mixed signs, the ray misses. Either winding counts as a hit
+		{
+			return false;
+		}
+
+		float determinant = u + v + w;
+
+		if ( determinant == 0.0f )
+		{
+			return false;
+		}
+
+		float scaledT = _shear.shearZ * (u * a[_shear.kz] + v * b[_shear.kz] + w * c[_shear.kz]);
+
+		if ( determinant < 0.0f )   // Back facing, flip both so the range checks below don't need a divide
+		{
+			scaledT = -scaledT;
+			determinant = -determinant;
+		}
+
+		if ( scaledT <= 0.0f || scaledT > _maxT * determinant )
+		{
+			return false;
+		}
+
+		*_t = scaledT / determinant;
+
+		return true;
+	}
+
+	void ParseOBJLine(char *_line, Mesh *_mesh, std::vector<long> *_face)
+	{
+		while ( *_line == ' ' || *_line == '\t' )
+		{
+			_line++;
+		}
+
+		bool isVertex = _line[0] == 'v' && (_line[1] == ' ' || _line[1] == '\t');
+		bool isFace = _line[0] == 'f' && (_line[1] == ' ' || _line[1] == '\t');
+
+		if ( isVertex )
+		{
+			char *end = _line + 2;
+			float x = std::strtof(end, &end);
+			float y = std::strtof(end, &end);
+			float z = std::strtof(end, &end);
+
+			_mesh->AddVertex(glm::vec3(x, y, z));
+		}
+		else if ( isFace )   // Normals, texture coordinates, groups and materials aren't used
+		{
+			char *cursor = _line + 2;
+			long vertexCount = _mesh->getVertexCount();
+
+			_face->clear();
+
+			while ( true )
+			{
+				char *end = cursor;
+				long index = std::strtol(cursor, &end, 10);
+
+				if ( end == cursor )
+				{
+					break;
+				}
+
+				index = index > 0 ? index - 1 : vertexCount + index;   // OBJ counts from 1, negative indices count back from the last vertex
+
+				if ( index < 0 || index >= vertexCount )
+				{
+					return;   // Skip faces that point at vertices that don't exist
+				}
+
+				_face->push_back(index);
+
+				cursor = end;
+
+				while ( *cursor != '\0' && *cursor != ' ' && *cursor != '\t' )   // Skip over /texture/normal
+				{
+					cursor++;
+				}
+			}
+
+			for ( size_t i = 2; i < _face->size(); ++i )
+			{
+				_mesh->AddTriangle((unsigned int)(*_face)[0], (unsigned int)(*_face)[i - 1], (unsigned int)(*_face)[i]);
+			}
+		}
+	}
+}
+
+Mesh::Mesh()
+{
+	setPosition(glm::vec3(0, 0, 0));
+	setColour(glm::vec3(0, 0, 0));
+	m_boundsMin = glm::vec3(0, 0, 0);
+	m_boundsMax = glm::vec3(0, 0, 0);
+	m_loadSeconds = 0.0;
+	m_buildSeconds = 0.0;
+}
+
+Mesh::Mesh(glm::vec3 _colour)
+{
+	setPosition(glm::vec3(0, 0, 0));
+	setColour(_colour);
+	m_boundsMin = glm::vec3(0, 0, 0);
+	m_boundsMax = glm::vec3(0, 0, 0);
+	m_loadSeconds = 0.0;
+	m_buildSeconds = 0.0;
+}
+
+bool Mesh::LoadOBJ(const std::string &_path)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::FILE *file = std::fopen(_path.c_str(), "rb");
+
+	if ( file == nullptr )
+	{
+		return false;
+	}
+
+	// The file is read a chunk at a time and parsed in place, so a file of millions of triangles never has to fit in memory as text
+
+	std::vector<char> buffer(MESH_OBJ_CHUNK + 1);
+	std::vector<long> face;
+	size_t carried = 0;   // Bytes of an unfinished line kept from the last chunk
+
+	while ( true )
+	{
+		size_t read = std::fread(buffer.data() + carried, 1, buffer.size() - 1 - carried, file);
+		size_t filled = carried + read;
+		size_t lineStart = 0;
+
+		while ( char *newline = (char*)std::memchr(buffer.data() + lineStart, '\n', filled - lineStart) )
+		{
+			*newline = '\0';
+			ParseOBJLine(buffer.data() + lineStart, this, &face);
+			lineStart = newline - buffer.data() + 1;
+		}
+
+		if ( read == 0 )   // End of the file, the last line may not have a newline
+		{
+			if ( lineStart < filled )
+			{
+				buffer[filled] = '\0';
+				ParseOBJLine(buffer.data() + lineStart, this, &face);
+			}
+
+			break;
+		}
+
+		carried = filled - lineStart;
+		std::memmove(buffer.data(), buffer.data() + lineStart, carried);
+
+		if ( carried == buffer.size() - 1 )   // One line is longer than the whole buffer
+		{
+			buffer.resize(buffer.size() * 2);
+		}
+	}
+
+	std::fclose(file);
+
+	m_loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+int Mesh::AddVertex(glm::vec3 _position)
+{
+	m_vertices.push_back(_position);
+
+	return (int)m_vertices.size() - 1;
+}
+
+void Mesh::AddTriangle(unsigned int _a, unsigned int _b, unsigned int _c)
+{
+	m_indices.push_back(_a);
+	m_indices.push_back(_b);
+	m_indices.push_back(_c);
+}
+
+void Mesh::Fit(glm::vec3 _centre, float _size)
+{
+	if ( m_vertices.empty() )
+	{
+		return;
+	}
+
+	glm::vec3 boundsMin = m_vertices[0];
+	glm::vec3 boundsMax = m_vertices[0];
+
+	for ( size_t i = 1; i < m_vertices.size(); ++i )
+	{
+		boundsMin = glm::min(boundsMin, m_vertices[i]);
+		boundsMax = glm::max(boundsMax, m_vertices[i]);
+	}
+
+	glm::vec3 extent = boundsMax - boundsMin;
+	float longestSide = std::max(extent.x, std::max(extent.y, extent.z));
+	float scale = longestSide > 0.0f ? _size / longestSide : 1.0f;
+	glm::vec3 middle = (boundsMin + boundsMax) * 0.5f;
+
+	for ( size_t i = 0; i < m_vertices.size(); ++i )
+	{
+		m_vertices[i] = _centre + (m_vertices[i] - middle) * scale;
+	}
+}
+
+void Mesh::Build()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int triangleCount = getTriangleCount();
+
+	std::vector<glm::vec3> boundsMin(triangleCount);
+	std::vector<glm::vec3> boundsMax(triangleCount);
+
+	m_boundsMin = glm::vec3(INFINITY);
+	m_boundsMax = glm::vec3(-INFINITY);
+
+	for ( int i = 0; i < triangleCount; ++i )
+	{
+		glm::vec3 a = m_vertices[m_indices[i * 3]];
+		glm::vec3 b = m_vertices[m_indices[i * 3 + 1]];
+		glm::vec3 c = m_vertices[m_indices[i * 3 + 2]];
+
+		boundsMin[i] = glm::min(a, glm::min(b, c));
+		boundsMax[i] = glm::max(a, glm::max(b, c));
+		m_boundsMin = glm::min(m_boundsMin, boundsMin[i]);
+		m_boundsMax = glm::max(m_boundsMax, boundsMax[i]);
+	}
+
+	m_bvh.setLeafWidth(MESH_LEAF_WIDTH);
+	m_bvh.BuildFromBounds(boundsMin, boundsMax);
+
+	// Put the triangles in leaf order so a leaf's entries are its triangle numbers and its indices sit next to each other
+
+	const std::vector<int> &order = m_bvh.getPrimitives();
+	std::vector<unsigned int> ordered(m_indices.size());
+
+	for ( int i = 0; i < triangleCount; ++i )
+	{
+		ordered[i * 3] = m_indices[order[i] * 3];
+		ordered[i * 3 + 1] = m_indices[order[i] * 3 + 1];
+		ordered[i * 3 + 2] = m_indices[order[i] * 3 + 2];
+	}
+
+	m_indices.swap(ordered);
+
+	m_buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Mesh::Intersection(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *t)
+{
+	RayShear shear = CreateRayShear(_rayDirection);
+	float maxT = INFINITY;
+	bool hit = false;
+
+	m_bvh.Traverse(_rayOrigin, _rayDirection, &maxT, false, [&](int _firstEntry, int _entryCount, float *_maxT)
+	{
+		bool found = false;
+		float t0 = 0.0f;
+
+		for ( int triangle = _firstEntry; triangle < _firstEntry + _entryCount; ++triangle )
+		{
+			const unsigned int *index = &m_indices[triangle * 3];
+
+			if ( IntersectTriangle(shear, _rayOrigin, m_vertices[index[0]], m_vertices[index[1]], m_vertices[index[2]], *_maxT, &t0) )
+			{
+				*_maxT = t0;
+				found = true;
+			}
+		}
+
+		hit = hit || found;
+
+		return found;
+	});
+
+	if ( hit )
+	{
+		*t = maxT;
+	}
+
+	return hit;
+}
+
+glm::vec3 Mesh::CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour)
+{
+	SurfacePoint surface = Surface(_p0);
+	*shininess = surface.shininess;
+	*diffuseColour = surface.diffuseColour;
+	*specularColour = surface.specularColour;
+	return surface.normal;
+}
+
+SurfacePoint Mesh::Surface(glm::vec3 _p0)
+{
+	SurfacePoint surface = Material(_p0);
+
+	int triangle = FindTriangle(_p0);
+
+	if ( triangle != -1 )
+	{
+		glm::vec3 a = m_vertices[m_indices[triangle * 3]];
+		glm::vec3 b = m_vertices[m_indices[triangle * 3 + 1]];
+		glm::vec3 c = m_vertices[m_indices[triangle * 3 + 2]];
+
+		surface.normal = glm::cross(b - a, c - a);   // Counter clockwise winding faces out, as OBJ files are written
+	}
+
+	return surface;
+}
+
+SurfacePoint Mesh::Material(glm::vec3 _p0)
+{
+	SurfacePoint surface;
+	surface.shininess = 64;
+	surface.diffuseColour = getColour();
+	surface.specularColour = glm::vec3(0.7, 0.7, 0.7);
+	surface.normal = glm::vec3(0, 1, 0);   // Points up if _p0 isn't on any triangle
+	return surface;
+}
+
+bool Mesh::GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax)
+{
+	*_boundsMin = m_boundsMin;
+	*_boundsMax = m_boundsMax;
+	return !m_indices.empty();
+}
+
+size_t Mesh::getMemoryBytes()
+{
+	return m_vertices.size() * sizeof(glm::vec3) + m_indices.size() * sizeof(unsigned int) + m_bvh.getNodeCount() * sizeof(BVHNode) + m_bvh.getPrimitives().size() * sizeof(int);
+}
+
+int Mesh::FindTriangle(glm::vec3 _p0)
+{
+	// The hit point is only known to float precision, so look a little past each box and keep the triangle _p0 sits closest to
+
+	glm::vec3 largest = glm::max(glm::abs(m_boundsMin), glm::abs(m_boundsMax));
+	float margin = 1e-4f * std::max(1.0f, std::max(largest.x, std::max(largest.y, largest.z)));
+
+	int bestTriangle = -1;
+	float bestDistance = INFINITY;
+
+	m_bvh.TraversePoint(_p0, margin, [&](int _firstEntry, int _entryCount)
+	{
+		for ( int triangle = _firstEntry; triangle < _firstEntry + _entryCount; ++triangle )
+		{
+			glm::vec3 a = m_vertices[m_indices[triangle * 3]];
+			glm::vec3 b = m_vertices[m_indices[triangle * 3 + 1]];
+			glm::vec3 c = m_vertices[m_indices[triangle * 3 + 2]];
+
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float areaSquared = glm::dot(normal, normal);
+
+			if ( areaSquared == 0.0f )
+			{
+				continue;
+			}
+
+			// Distance off the triangle's plane, plus how far outside its edges the point is (barycentric, scaled to a length)
+
+			float length = std::sqrt(areaSquared);
+			float planeDistance = std::fabs(glm::dot(_p0 - a, normal)) / length;
+			float u = glm::dot(glm::cross(b - _p0, c - _p0), normal) / areaSquared;
+			float v = glm::dot(glm::cross(c - _p0, a - _p0), normal) / areaSquared;
+			float w = 1.0f - u - v;
+			float outside = std::max(0.0f, -std::min(u, std::min(v, w))) * std::sqrt(length);
+			float distance = planeDistance + outside;
+
+			if ( distance < bestDistance )
+			{
+				bestDistance = distance;
+				bestTriangle = triangle;
+			}
+		}
+	});
+
+	return bestTriangle;
+}
@@ -0,0 +1,74 @@
+/// \file Mesh.h
+/// \brief Class for the 'Mesh' object, a triangle mesh held as one shared vertex buffer and one index buffer
+/// \author Thomas Hardy
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+#include "Shape.h"
+#include "BVH.h"
+
+#define MESH_LEAF_WIDTH (4)   // Macro for how many triangles the mesh's own BVH puts in a leaf
+
+class Mesh final : public Shape   // Final so calls on a Mesh the compiler can see skip the vtable
+{
+public:
+
+	Mesh();
+
+	Mesh(glm::vec3 _colour);
+
+	bool LoadOBJ(const std::string &_path);   // Streams the vertices and faces in, polygons are split into fans. False if the file couldn't be opened
+
+	int AddVertex(glm::vec3 _position);
+
+	void AddTriangle(unsigned int _a, unsigned int _b, unsigned int _c);
+
+	void Fit(glm::vec3 _centre, float _size);   // Moves and scales the vertices so the longest side of the mesh is _size, centred on _centre
+
+	void Build();   // Builds the triangle BVH and puts the index buffer in leaf order, call once every triangle is in
+
+	bool Intersection(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *t);
+
+	glm::vec3 CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour);
+
+	SurfacePoint Surface(glm::vec3 _p0);   // Face normal of the triangle under _p0
+
+	SurfacePoint Material(glm::vec3 _p0);   // One material for every triangle, so no triangle search
+
+	bool GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax);
+
+	int getVertexCount() { return (int)m_vertices.size(); }
+
+	int getTriangleCount() { return (int)(m_indices.size() / 3); }
+
+	const std::vector<glm::vec3>& getVertices() { return m_vertices; }
+
+	const std::vector<unsigned int>& getIndices() { return m_indices; }   // In the BVH's leaf order once Build has run
+
+	size_t getMemoryBytes();   // Vertex, index and BVH buffers
+
+	double getLoadSeconds() { return m_loadSeconds; }
+
+	double getBuildSeconds() { return m_buildSeconds; }
+
+private:
+
+	int FindTriangle(glm::vec3 _p0);   // The triangle _p0 lies on, found through the BVH rather than stored per hit so Surface stays thread safe
+
+	std::vector<glm::vec3> m_vertices;   // Shared by every triangle that uses them, 12 bytes each
+	std::vector<unsigned int> m_indices;   // Three per triangle, 12 bytes each
+
+	BVH m_bvh;   // Built over the triangles alone, the scene's BVH sees the whole mesh as one box
+
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+
+	double m_loadSeconds;
+	double m_buildSeconds;
+};
+#endif
@@ -0,0 +1,112 @@
+/// @file NumaTopology.cpp
+/// @brief Contains functions for reading the NUMA topology and pinning threads to it
+/// Only Linux is read, anywhere else Load leaves a single node and nothing is pinned, so the render runs as it always has
+
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "NumaTopology.h"
+
+NumaTopology::NumaTopology()
+{
+	m_nodeCpus.push_back(std::vector<int>());
+	m_nodeIds.push_back(0);
+}
+
+bool NumaTopology::Load(const std::string &_nodePath)
+{
+	std::vector<std::vector<int>> nodeCpus;
+	std::vector<int> nodeIds;
+
+	for ( int node = 0; node < NUMA_MAX_NODES; ++node )
+	{
+		std::ifstream file(_nodePath + std::to_string(node) + "/cpulist");
+		std::string list;
+
+		if ( !file.is_open() || !std::getline(file, list) )
+		{
+			continue;
+		}
+
+		std::vector<int> cpus = ParseCpuList(list);
+
+		if ( !cpus.empty() )   // Memory only nodes have no CPUs to run workers on
+		{
+			nodeCpus.push_back(cpus);
+			nodeIds.push_back(node);
+		}
+	}
+
+	if ( nodeCpus.empty() )
+	{
+		return false;
+	}
+
+	m_nodeCpus = nodeCpus;
+	m_nodeIds = nodeIds;
+
+	return true;
+}
+
+std::vector<int> NumaTopology::ParseCpuList(const std::string &_list)
+{
+	std::vector<int> cpus;
+	std::stringstream stream(_list);
+	std::string range;
+
+	while ( std::getline(stream, range, ',') )
+	{
+		int first = 0;
+		int last = 0;
+		char dash = 0;
+
+		std::stringstream rangeStream(range);
+
+		if ( !(rangeStream >> first) )
+		{
+			continue;
+		}
+
+		if ( !(rangeStream >> dash >> last) || dash != '-' )   // A single CPU
+		{
+			last = first;
+		}
+
+		for ( int cpu = first; cpu <= last; ++cpu )
+		{
+			cpus.push_back(cpu);
+		}
+	}
+
+	return cpus;
+}
+
+bool NumaTopology::PinCurrentThread(const std::vector<int> &_cpus)
+{
+#if defined(__linux__)
+	if ( _cpus.empty() )
+	{
+		return false;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for ( size_t i = 0; i < _cpus.size(); ++i )
+	{
+		if ( _cpus[i] >= 0 && _cpus[i] < CPU_SETSIZE )
+		{
+			CPU_SET(_cpus[i], &set);
+		}
+	}
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;   // The whole node rather than one core, the OS still balances within it
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,37 @@
+/// \file NumaTopology.h
+/// \brief Class for the 'NumaTopology' which finds out which CPUs belong to which memory node, read from Linux sysfs
+/// \author Thomas Hardy
+
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+#define NUMA_NODE_PATH ("/sys/devices/system/node/node")   // Macro for where Linux lists each node, the node number and "/cpulist" go on the end
+#define NUMA_MAX_NODES (64)   // Macro for how many node numbers are looked for, node numbers can have gaps
+
+class NumaTopology
+{
+public:
+
+	NumaTopology();   // One node holding every CPU, which is what any machine Load can't read looks like
+
+	bool Load(const std::string &_nodePath = NUMA_NODE_PATH);   // False if no node could be read, the topology is left as one node
+
+	int getNodeCount() { return (int)m_nodeCpus.size(); }
+
+	const std::vector<int>& getCpus( int _node ) { return m_nodeCpus[_node]; }   // Empty for the single node made without Load
+
+	int getNodeId( int _node ) { return m_nodeIds[_node]; }   // The number the OS gives the node
+
+	static std::vector<int> ParseCpuList(const std::string &_list);   // The kernel's "0-3,8-11" format
+
+	static bool PinCurrentThread(const std::vector<int> &_cpus);   // Lets the calling thread run only on these CPUs, false if that isn't supported here
+
+private:
+
+	std::vector<std::vector<int>> m_nodeCpus;
+	std::vector<int> m_nodeIds;
+};
+#endif
@@ -0,0 +1,186 @@
+/// @file PNGWriter.cpp
+/// @brief Contains the PNG writer
+/// Each piece of rows is filtered, deflated and wrapped in its own IDAT chunk on a pool thread. The pieces end on byte boundaries,
+/// so joined in order they form one zlib stream, and the stream's Adler-32 is put together from each piece's checksum
+/// https://www.w3.org/TR/png/ used for help with the file format
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "PNGWriter.h"
+#include "Deflate.h"
+
+namespace
+{
+	void PutBigEndian(unsigned char *_bytes, unsigned int _value)
+	{
+		_bytes[0] = (unsigned char)(_value >> 24);
+		_bytes[1] = (unsigned char)(_value >> 16);
+		_bytes[2] = (unsigned char)(_value >> 8);
+		_bytes[3] = (unsigned char)_value;
+	}
+
+	std::vector<unsigned char> StartChunk(const char *_type)   // Space for the length, then the type, the data goes on the end
+	{
+		std::vector<unsigned char> chunk(8, 0);
+		std::copy(_type, _type + 4, chunk.begin() + 4);
+		return chunk;
+	}
+
+	void FinishChunk(std::vector<unsigned char> *_chunk)   // Fills in the length and adds the CRC, which covers the type and data
+	{
+		PutBigEndian(&(*_chunk)[0], (unsigned int)(_chunk->size() - 8));
+
+		unsigned char crc[4];
+		PutBigEndian(crc, Crc32(&(*_chunk)[4], _chunk->size() - 4));
+		_chunk->insert(_chunk->end(), crc, crc + 4);
+	}
+
+	int Paeth(int _left, int _up, int _upLeft)
+	{
+		int estimate = _left + _up - _upLeft;
+		int toLeft = std::abs(estimate - _left);
+		int toUp = std::abs(estimate - _up);
+		int toUpLeft = std::abs(estimate - _upLeft);
+
+		if ( toLeft <= toUp && toLeft <= toUpLeft )
+		{
+			return _left;
+		}
+
+		return toUp <= toUpLeft ? _up : _upLeft;
+	}
+
+	void FilterRow(const unsigned char *_row, const unsigned char *_previous, int _rowBytes, unsigned char *_output)
+	{
+		// Every filter type is tried and the one whose bytes are closest to zero (as signed values) is kept, the usual PNG heuristic
+
+		const int pixelBytes = 3;
+
+		std::vector<unsigned char> candidate(_rowBytes);
+		long bestScore = -1;
+
+		for ( int filter = 0; filter < 5; ++filter )
+		{
+			long score = 0;
+
+			for ( int i = 0; i < _rowBytes; ++i )
+			{
+				int left = i >= pixelBytes ? _row[i - pixelBytes] : 0;
+				int up = _previous[i];
+				int upLeft = i >= pixelBytes ? _previous[i - pixelBytes] : 0;
+				int predicted = 0;
+
+				switch (filter)
+				{
+				case 1:
+					predicted = left;
+					break;
+				case 2:
+					predicted = up;
+					break;
+				case 3:
+					predicted = (left + up) / 2;
+					break;
+				case 4:
+					predicted = Paeth(left, up, upLeft);
+					break;
+				}
+
+				candidate[i] = (unsigned char)(_row[i] - predicted);
+				score += std::abs((int)(signed char)candidate[i]);
+			}
+
+			if ( bestScore < 0 || score < bestScore )
+			{
+				bestScore = score;
+				_output[0] = (unsigned char)filter;
+				std::copy(candidate.begin(), candidate.end(), _output + 1);
+			}
+		}
+	}
+}
+
+void EncodePNG(Framebuffer &_image, ThreadPool &_pool, std::vector<unsigned char> *_file)
+{
+	int width = _image.getWidth();
+	int height = _image.getHeight();
+	int rowBytes = width * 3;
+	int pieceCount = (height + PNG_ROWS_PER_PIECE - 1) / PNG_ROWS_PER_PIECE;
+
+	std::vector<std::vector<unsigned char>> pieces(pieceCount);   // Finished IDAT chunks
+	std::vector<unsigned int> pieceAdlers(pieceCount);
+	std::vector<size_t> pieceSizes(pieceCount);
+
+	_pool.ParallelRun(pieceCount, [&](int _piece)
+	{
+		int firstRow = _piece * PNG_ROWS_PER_PIECE;
+		int endRow = std::min(height, firstRow + PNG_ROWS_PER_PIECE);
+
+		std::vector<unsigned char> previous(rowBytes, 0);   // The row above the image counts as zeros
+		std::vector<unsigned char> current(rowBytes);
+		std::vector<unsigned char> filtered((size_t)(endRow - firstRow) * (rowBytes + 1));
+
+		if ( firstRow > 0 )   // Up, Average and Paeth look at the last row of the piece before
+		{
+			_image.QuantizeRow(firstRow - 1, 0, width, previous.data());
+		}
+
+		for ( int y = firstRow; y < endRow; ++y )
+		{
+			_image.QuantizeRow(y, 0, width, current.data());
+			FilterRow(current.data(), previous.data(), rowBytes, &filtered[(size_t)(y - firstRow) * (rowBytes + 1)]);
+			std::swap(previous, current);
+		}
+
+		pieceAdlers[_piece] = Adler32(filtered.data(), filtered.size());
+		pieceSizes[_piece] = filtered.size();
+
+		pieces[_piece] = StartChunk("IDAT");
+		DeflateCompress(filtered.data(), filtered.size(), _piece == pieceCount - 1, &pieces[_piece]);
+		FinishChunk(&pieces[_piece]);
+	});
+
+	unsigned int adler = Adler32(nullptr, 0);
+
+	for ( int i = 0; i < pieceCount; ++i )
+	{
+		adler = Adler32Combine(adler, pieceAdlers[i], pieceSizes[i]);
+	}
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	std::vector<unsigned char> header = StartChunk("IHDR");
+	header.resize(8 + 13, 0);
+	PutBigEndian(&header[8], (unsigned int)width);
+	PutBigEndian(&header[12], (unsigned int)height);
+	header[16] = 8;   // Bits per channel
+	header[17] = 2;   // RGB
+	FinishChunk(&header);
+
+	std::vector<unsigned char> streamStart = StartChunk("IDAT");   // zlib header, deflate with a 32K window
+	streamStart.push_back(0x78);
+	streamStart.push_back(0x01);
+	FinishChunk(&streamStart);
+
+	std::vector<unsigned char> streamEnd = StartChunk("IDAT");
+	streamEnd.resize(8 + 4);
+	PutBigEndian(&streamEnd[8], adler);
+	FinishChunk(&streamEnd);
+
+	std::vector<unsigned char> end = StartChunk("IEND");
+	FinishChunk(&end);
+
+	_file->assign(signature, signature + sizeof(signature));
+	_file->insert(_file->end(), header.begin(), header.end());
+	_file->insert(_file->end(), streamStart.begin(), streamStart.end());
+
+	for ( int i = 0; i < pieceCount; ++i )
+	{
+		_file->insert(_file->end(), pieces[i].begin(), pieces[i].end());
+	}
+
+	_file->insert(_file->end(), streamEnd.begin(), streamEnd.end());
+	_file->insert(_file->end(), end.begin(), end.end());
+}
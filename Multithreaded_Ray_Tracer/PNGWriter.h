@@ -0,0 +1,16 @@
+/// \file PNGWriter.h
+/// \brief Function for encoding the framebuffer as a PNG, compressed in pieces across the thread pool
+/// \author Thomas Hardy
+
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <vector>
+
+#include "Framebuffer.h"
+#include "ThreadPool.h"
+
+#define PNG_ROWS_PER_PIECE (32)   // Macro for how many rows each job filters and compresses, fixed so the file doesn't depend on the thread count
+
+void EncodePNG(Framebuffer &_image, ThreadPool &_pool, std::vector<unsigned char> *_file);   // 8 bit RGB, _file is filled with the whole file so writing it can be timed on its own
+#endif
@@ -37,8 +37,19 @@ bool Plane::Intersection(glm::vec3 rayOrigin, glm::vec3 rayDirection, float *t)
 
 glm::vec3 Plane::CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour)
 {
-	*shininess = 10;
-	*diffuseColour = glm::vec3(0.3, 0.3, 0.3);
-	*specularColour = getColour();
-	return m_planeNormal;
+	SurfacePoint surface = Surface(_p0);
+	*shininess = surface.shininess;
+	*diffuseColour = surface.diffuseColour;
+	*specularColour = surface.specularColour;
+	return surface.normal;
+}
+
+SurfacePoint Plane::Surface(glm::vec3 _p0)
+{
+	SurfacePoint surface;
+	surface.shininess = 10;
+	surface.diffuseColour = glm::vec3(0.3, 0.3, 0.3);
+	surface.specularColour = getColour();
+	surface.normal = m_planeNormal;
+	return surface;
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 
 #include "Shape.h"
 
-class Plane : public Shape
+class Plane final : public Shape   // Final so calls on a Plane the compiler can see skip the vtable
 {
 public:
 
@@ -21,6 +21,8 @@ public:
 
 	glm::vec3 CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour);
 
+	SurfacePoint Surface(glm::vec3 _p0);
+
 	glm::vec3 getPlaneNormal() { return m_planeNormal; }
 	void setPlaneNormal( glm::vec3 _planeNormal ) { m_planeNormal = _planeNormal; }
 
@@ -0,0 +1,192 @@
+/// @file Preview.cpp
+/// @brief Contains functions for the Preview class
+/// Tiles are copied from the back buffer to the front buffer under the lock, then the front buffer is uploaded and drawn without it
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <SDL.h>
+
+#include "Preview.h"
+
+Preview::Preview(int _width, int _height)
+{
+	m_window = nullptr;
+	m_renderer = nullptr;
+	m_texture = nullptr;
+	m_width = _width;
+	m_height = _height;
+	m_started = false;
+	m_headless = false;
+	m_closed = false;
+	m_presentCount = 0;
+}
+
+Preview::~Preview()
+{
+	Close();
+}
+
+bool Preview::Open(bool _headless)
+{
+	m_headless = _headless;
+
+	if ( _headless )
+	{
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);   // Has to be set before SDL starts the video subsystem
+	}
+
+	if ( SDL_Init(SDL_INIT_VIDEO) != 0 )
+	{
+		return false;
+	}
+
+	m_started = true;
+
+	float scale = std::min(1.0f, (float)PREVIEW_MAX_WINDOW_SIZE / std::max(m_width, m_height));
+
+	m_window = SDL_CreateWindow("Ray Tracer Preview", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, std::max(1, (int)(m_width * scale)), std::max(1, (int)(m_height * scale)), _headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
+
+	if ( m_window != nullptr )
+	{
+		m_renderer = SDL_CreateRenderer(m_window, -1, 0);   // Falls back to the software renderer, which is the only one the dummy driver has
+	}
+
+	if ( m_renderer != nullptr )
+	{
+		m_texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, m_width, m_height);   // Same layout as the PPM rows so tiles are copied straight in
+	}
+
+	if ( m_texture == nullptr )
+	{
+		Close();
+
+		return false;
+	}
+
+	m_backBuffer.assign((size_t)m_width * m_height * 3, 0);
+	m_frontBuffer.assign((size_t)m_width * m_height * 3, 0);
+	m_closed = false;
+	m_presentCount = 0;
+
+	return true;
+}
+
+void Preview::Close()
+{
+	if ( m_texture != nullptr )
+	{
+		SDL_DestroyTexture(m_texture);
+		m_texture = nullptr;
+	}
+
+	if ( m_renderer != nullptr )
+	{
+		SDL_DestroyRenderer(m_renderer);
+		m_renderer = nullptr;
+	}
+
+	if ( m_window != nullptr )
+	{
+		SDL_DestroyWindow(m_window);
+		m_window = nullptr;
+	}
+
+	if ( m_started )
+	{
+		SDL_Quit();
+		m_started = false;
+	}
+}
+
+void Preview::TileFinished(const Tile &_tile, Framebuffer &_image)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+
+	for ( int y = _tile.minY; y < _tile.maxY; ++y )
+	{
+		_image.QuantizeRow(y, _tile.minX, _tile.maxX, &m_backBuffer[((size_t)y * m_width + _tile.minX) * 3]);
+	}
+
+	m_finishedTiles.push_back(_tile);
+}
+
+bool Preview::Present()
+{
+	if ( !PollEvents() )
+	{
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		m_presentTiles.swap(m_finishedTiles);
+
+		for ( size_t i = 0; i < m_presentTiles.size(); ++i )
+		{
+			const Tile &tile = m_presentTiles[i];
+
+			for ( int y = tile.minY; y < tile.maxY; ++y )
+			{
+				size_t offset = ((size_t)y * m_width + tile.minX) * 3;
+
+				std::memcpy(&m_frontBuffer[offset], &m_backBuffer[offset], (size_t)(tile.maxX - tile.minX) * 3);
+			}
+		}
+	}
+
+	if ( m_presentTiles.empty() )
+	{
+		return true;   // Nothing new, the window already shows the front buffer
+	}
+
+	m_presentTiles.clear();
+
+	SDL_UpdateTexture(m_texture, nullptr, m_frontBuffer.data(), m_width * 3);
+	Draw();
+
+	if ( m_presentCount == 0 )
+	{
+		m_firstPresentTime = std::chrono::steady_clock::now();
+	}
+
+	++m_presentCount;
+
+	return true;
+}
+
+void Preview::WaitForClose()
+{
+	while ( !m_headless && PollEvents() )
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(PREVIEW_INTERVAL_MS));
+	}
+}
+
+bool Preview::PollEvents()
+{
+	SDL_Event event;
+
+	while ( SDL_PollEvent(&event) )
+	{
+		if ( event.type == SDL_QUIT || (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE) )
+		{
+			m_closed = true;
+		}
+		else if ( event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED )
+		{
+			Draw();   // Redrawn so the window isn't left blank after being covered
+		}
+	}
+
+	return !m_closed;
+}
+
+void Preview::Draw()
+{
+	SDL_RenderClear(m_renderer);
+	SDL_RenderCopy(m_renderer, m_texture, nullptr, nullptr);
+	SDL_RenderPresent(m_renderer);
+}
@@ -0,0 +1,77 @@
+/// \file Preview.h
+/// \brief Class for the 'Preview' which shows tiles in an SDL window as the render threads finish them
+/// \author Thomas Hardy
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "Framebuffer.h"
+#include "TileScheduler.h"
+
+#define PREVIEW_INTERVAL_MS (16)   // Macro for how long the presenting thread sleeps between presents, about 60 a second
+#define PREVIEW_MAX_WINDOW_SIZE (1024)   // Macro for the longest side of the window, bigger images are scaled down to fit
+
+struct SDL_Window;   // Declared here so SDL.h stays out of the header
+struct SDL_Renderer;
+struct SDL_Texture;
+
+class Preview
+{
+public:
+
+	Preview(int _width, int _height);
+
+	~Preview();
+
+	Preview(const Preview&) = delete;
+	Preview& operator=(const Preview&) = delete;
+
+	bool Open(bool _headless);   // Opens the window, or with _headless uses SDL's dummy video driver so every present still happens with nothing on screen. False if SDL couldn't start
+
+	void Close();
+
+	void TileFinished(const Tile &_tile, Framebuffer &_image);   // Called by the render threads, copies the finished tile into the back buffer and queues it
+
+	bool Present();   // Called by the thread that opened the preview, shows the tiles queued since the last present. False once the window has been closed
+
+	void WaitForClose();   // Keeps the last image up until the window is closed, returns straight away when headless
+
+	bool isOpen() { return m_window != nullptr; }
+
+	int getPresentCount() { return m_presentCount; }   // Presents that had new tiles in them
+
+	std::chrono::steady_clock::time_point getFirstPresentTime() { return m_firstPresentTime; }   // Only set once getPresentCount is above 0
+
+private:
+
+	bool PollEvents();   // False once the window has been closed
+
+	void Draw();   // Puts the texture on screen
+
+	SDL_Window *m_window;
+	SDL_Renderer *m_renderer;
+	SDL_Texture *m_texture;
+
+	int m_width;
+	int m_height;
+	bool m_started;   // SDL_Init succeeded, so SDL_Quit is owed
+	bool m_headless;
+	bool m_closed;
+
+	// The render threads only touch the back buffer and the queue, and only for as long as one tile's copy takes, so a slow present never holds them up
+
+	std::mutex m_lock;
+	std::vector<unsigned char> m_backBuffer;   // 8 bit RGB, row by row
+	std::vector<Tile> m_finishedTiles;   // Queued since the last present
+
+	std::vector<unsigned char> m_frontBuffer;   // Only used by the presenting thread
+	std::vector<Tile> m_presentTiles;   // Swapped with m_finishedTiles so the queue's memory is reused
+
+	int m_presentCount;
+	std::chrono::steady_clock::time_point m_firstPresentTime;
+};
+#endif
@@ -12,6 +12,9 @@ class Ray
 public:
 
 	Ray();
+
+	Ray(glm::vec3 _origin, glm::vec3 _direction);   // A plain value, made on the stack for every pixel
+
 	~Ray();
 
 	glm::vec3 getDirection() { return m_direction; }
@@ -0,0 +1,24 @@
+/// \file RayPacket.h
+/// \brief Struct for the 'RayPacket', a group of neighbouring primary rays traced together
+/// \author Thomas Hardy
+
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include <glm.hpp>
+
+#define RAY_PACKET_MAX (16)   // Macro for the most rays a packet holds, the lane arrays are always this long so loops over them have a fixed trip count
+
+struct RayPacket
+{
+	glm::vec3 origin;   // Primary rays all leave the camera so the origin is shared
+
+	// One array per component so each lane loop reads the same component of neighbouring rays
+
+	alignas(64) float directionX[RAY_PACKET_MAX];
+	alignas(64) float directionY[RAY_PACKET_MAX];
+	alignas(64) float directionZ[RAY_PACKET_MAX];
+
+	int size;   // How many lanes hold a ray, 4, 8 or 16
+};
+#endif
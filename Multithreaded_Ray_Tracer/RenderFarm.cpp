@@ -0,0 +1,887 @@
+/// @file RenderFarm.cpp
+/// @brief Contains the coordinator and worker sides of the render farm
+/// Workers pull tiles and send each back as 8 bit rows, Sub filtered like a PNG and deflated. The coordinator gives every connection
+/// its own thread, and a tile that is out too long, or was out on a worker that dropped, goes back in the queue for anyone to take
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RenderFarm.h"
+#include "ByteOrder.h"
+#include "Socket.h"
+#include "Deflate.h"
+#include "Renderer.h"
+#include "RenderStats.h"
+
+namespace
+{
+	enum FarmMessage
+	{
+		MESSAGE_SCENE = 1,   // Coordinator to worker, once: the settings and every shape
+		MESSAGE_REQUEST,   // Worker to coordinator: send one more tile
+		MESSAGE_TILE,   // Coordinator to worker: the tile's index and bounds
+		MESSAGE_RESULT,   // Worker to coordinator: the tile's index and bounds then its compressed pixels
+		MESSAGE_DONE   // Coordinator to worker: every tile is in
+	};
+
+	enum FarmShape
+	{
+		FARM_SPHERE,
+		FARM_PLANE,
+		FARM_MESH
+	};
+
+	void PutFloat(std::vector<unsigned char> *_message, float _value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &_value, sizeof(bits));
+		PutLittleEndian(_message, bits);
+	}
+
+	void PutVec3(std::vector<unsigned char> *_message, glm::vec3 _value)
+	{
+		PutFloat(_message, _value.x);
+		PutFloat(_message, _value.y);
+		PutFloat(_message, _value.z);
+	}
+
+	void PutTile(std::vector<unsigned char> *_message, const Tile &_tile)
+	{
+		PutLittleEndian(_message, _tile.index);
+		PutLittleEndian(_message, _tile.minX);
+		PutLittleEndian(_message, _tile.maxX);
+		PutLittleEndian(_message, _tile.minY);
+		PutLittleEndian(_message, _tile.maxY);
+	}
+
+	class MessageReader   // Reads past the end return 0 and leave isGood false rather than running off the buffer
+	{
+	public:
+
+		MessageReader(const std::vector<unsigned char> &_message) : m_message(_message)
+		{
+			m_position = 0;
+			m_good = true;
+		}
+
+		int GetInt()
+		{
+			if ( m_message.size() - m_position < 4 )
+			{
+				m_good = false;
+				m_position = m_message.size();
+				return 0;
+			}
+
+			unsigned int value = GetLittleEndian(&m_message[m_position]);
+			m_position += 4;
+
+			return (int)value;
+		}
+
+		float GetFloat()
+		{
+			int bits = GetInt();
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+
+			return value;
+		}
+
+		glm::vec3 GetVec3()
+		{
+			glm::vec3 value;
+			value.x = GetFloat();
+			value.y = GetFloat();
+			value.z = GetFloat();
+
+			return value;
+		}
+
+		Tile GetTile()
+		{
+			Tile tile;
+			tile.index = GetInt();
+			tile.minX = GetInt();
+			tile.maxX = GetInt();
+			tile.minY = GetInt();
+			tile.maxY = GetInt();
+
+			return tile;
+		}
+
+		const unsigned char* getRest() { return m_message.data() + m_position; }
+
+		size_t getRestSize() { return m_message.size() - m_position; }
+
+		bool isGood() { return m_good; }
+
+	private:
+
+		const std::vector<unsigned char> &m_message;
+		size_t m_position;
+		bool m_good;
+	};
+
+	std::vector<std::shared_ptr<Shape>> LoadShapes(const RenderSettings &_settings)
+	{
+		std::vector<std::shared_ptr<Shape>> shapeVector = CreateShapes(std::vector<std::shared_ptr<Shape>>());
+
+		if ( !_settings.meshPath.empty() )
+		{
+			std::shared_ptr<Mesh> mesh = LoadMesh(_settings.meshPath);
+
+			if ( mesh != nullptr )
+			{
+				shapeVector.push_back(mesh);
+			}
+		}
+
+		return shapeVector;
+	}
+
+	void WriteScene(const RenderSettings &_settings, const std::vector<std::shared_ptr<Shape>> &_shapeVector, std::vector<unsigned char> *_message)
+	{
+		PutLittleEndian(_message, _settings.width);
+		PutLittleEndian(_message, _settings.height);
+		PutLittleEndian(_message, _settings.tileSize);
+		PutLittleEndian(_message, _settings.maxSamples);
+		PutLittleEndian(_message, _settings.packetSize);
+		PutLittleEndian(_message, (unsigned int)_settings.pixelOrder);
+		PutVec3(_message, _settings.cameraPosition);
+		PutVec3(_message, _settings.cameraTarget);
+		PutFloat(_message, _settings.fieldOfView);
+
+		int sentCount = 0;
+		int countPosition = (int)_message->size();
+		PutLittleEndian(_message, 0);   // Filled in once the shapes the farm can send are known
+
+		for ( size_t i = 0; i < _shapeVector.size(); ++i )
+		{
+			Shape *shape = _shapeVector[i].get();
+
+			if ( Sphere *sphere = dynamic_cast<Sphere*>(shape) )
+			{
+				PutLittleEndian(_message, FARM_SPHERE);
+				PutVec3(_message, sphere->getPosition());
+				PutVec3(_message, sphere->getColour());
+				PutFloat(_message, sphere->getRadius());
+			}
+			else if ( Plane *plane = dynamic_cast<Plane*>(shape) )
+			{
+				PutLittleEndian(_message, FARM_PLANE);
+				PutVec3(_message, plane->getPosition());
+				PutVec3(_message, plane->getColour());
+				PutVec3(_message, plane->getPlaneNormal());
+			}
+			else if ( Mesh *mesh = dynamic_cast<Mesh*>(shape) )
+			{
+				const std::vector<glm::vec3> &vertices = mesh->getVertices();
+				const std::vector<unsigned int> &indices = mesh->getIndices();
+
+				PutLittleEndian(_message, FARM_MESH);
+				PutVec3(_message, mesh->getPosition());
+				PutVec3(_message, mesh->getColour());
+				PutLittleEndian(_message, (unsigned int)vertices.size());
+				PutLittleEndian(_message, (unsigned int)indices.size());
+
+				for ( size_t v = 0; v < vertices.size(); ++v )
+				{
+					PutVec3(_message, vertices[v]);
+				}
+
+				for ( size_t t = 0; t < indices.size(); ++t )
+				{
+					PutLittleEndian(_message, (unsigned int)indices[t]);
+				}
+			}
+			else
+			{
+				std::cout << "Shape " << i << " isn't a sphere, plane or mesh, the workers will render without it" << std::endl;
+				continue;
+			}
+
+			sentCount++;
+		}
+
+		PutLittleEndian(&(*_message)[countPosition], sentCount);
+	}
+
+	bool ReadScene(const std::vector<unsigned char> &_message, RenderSettings *_settings, std::vector<std::shared_ptr<Shape>> *_shapeVector)
+	{
+		MessageReader reader(_message);
+
+		_settings->width = reader.GetInt();
+		_settings->height = reader.GetInt();
+		_settings->tileSize = reader.GetInt();
+		_settings->maxSamples = reader.GetInt();
+		_settings->packetSize = reader.GetInt();
+		_settings->pixelOrder = (CurveOrder)reader.GetInt();
+		_settings->cameraPosition = reader.GetVec3();
+		_settings->cameraTarget = reader.GetVec3();
+		_settings->fieldOfView = reader.GetFloat();
+
+		// The same limits the coordinator's prompts keep to, anything else didn't come from a coordinator. Packets past RAY_PACKET_MAX
+		// would overrun TraceHits' lane arrays, and a huge size or sample count would hang the worker or run it out of memory
+
+		bool packetSizeGood = _settings->packetSize == 1 || _settings->packetSize == 4 || _settings->packetSize == 8 || _settings->packetSize == 16;
+
+		if ( !reader.isGood() || _settings->width <= 0 || _settings->width > RENDER_MAX_SIZE || _settings->height <= 0 || _settings->height > RENDER_MAX_SIZE
+			|| _settings->tileSize <= 0 || _settings->tileSize > RENDER_MAX_SIZE || _settings->maxSamples < 1 || _settings->maxSamples > RENDER_MAX_SAMPLES
+			|| !packetSizeGood || _settings->pixelOrder < ORDER_SCANLINE || _settings->pixelOrder > ORDER_HILBERT )
+		{
+			return false;
+		}
+
+		int shapeCount = reader.GetInt();
+
+		for ( int i = 0; i < shapeCount && reader.isGood(); ++i )
+		{
+			int type = reader.GetInt();
+			glm::vec3 position = reader.GetVec3();
+			glm::vec3 colour = reader.GetVec3();
+
+			if ( type == FARM_SPHERE )
+			{
+				float radius = reader.GetFloat();
+				_shapeVector->push_back(std::make_shared<Sphere>(position, radius, colour));
+			}
+			else if ( type == FARM_PLANE )
+			{
+				glm::vec3 normal = reader.GetVec3();
+				_shapeVector->push_back(std::make_shared<Plane>(position, normal, colour));
+			}
+			else if ( type == FARM_MESH )
+			{
+				int vertexCount = reader.GetInt();
+				int indexCount = reader.GetInt();
+
+				if ( vertexCount < 0 || indexCount < 0 || (size_t)vertexCount * 12 + (size_t)indexCount * 4 > reader.getRestSize() )
+				{
+					return false;
+				}
+
+				std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(colour);
+				mesh->setPosition(position);
+
+				for ( int v = 0; v < vertexCount; ++v )
+				{
+					mesh->AddVertex(reader.GetVec3());
+				}
+
+				for ( int t = 0; t + 2 < indexCount; t += 3 )
+				{
+					unsigned int a = (unsigned int)reader.GetInt();
+					unsigned int b = (unsigned int)reader.GetInt();
+					unsigned int c = (unsigned int)reader.GetInt();
+
+					if ( a >= (unsigned int)vertexCount || b >= (unsigned int)vertexCount || c >= (unsigned int)vertexCount )
+					{
+						return false;
+					}
+
+					mesh->AddTriangle(a, b, c);
+				}
+
+				mesh->Build();
+				_shapeVector->push_back(mesh);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return reader.isGood();
+	}
+
+	std::vector<Tile> SplitTile(const Tile &_tile, int _tileSize)   // Cut into thread sized tiles for the worker's own scheduler
+	{
+		std::vector<Tile> tiles = TileScheduler::MakeTiles(_tile.maxX - _tile.minX, _tile.maxY - _tile.minY, _tileSize);
+
+		for ( size_t i = 0; i < tiles.size(); ++i )
+		{
+			tiles[i].minX += _tile.minX;
+			tiles[i].maxX += _tile.minX;
+			tiles[i].minY += _tile.minY;
+			tiles[i].maxY += _tile.minY;
+		}
+
+		return tiles;
+	}
+
+	void RenderFarmTile(const Tile &_tile, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, TileScheduler &_scheduler)
+	{
+		// The same passes as RenderTiles. With anti-aliasing the edge test reads each pixel's four neighbours, so a one pixel border
+		// round the tile is traced and shaded too, and the tile comes out the same as it would in a render of the whole frame
+
+		bool antiAliased = _settings.maxSamples > 1;
+		Tile shaded = _tile;
+
+		if ( antiAliased )
+		{
+			shaded.minX = std::max(0, _tile.minX - 1);
+			shaded.maxX = std::min(_image.getWidth(), _tile.maxX + 1);
+			shaded.minY = std::max(0, _tile.minY - 1);
+			shaded.maxY = std::min(_image.getHeight(), _tile.maxY + 1);
+		}
+
+		std::vector<Tile> shadedTiles = SplitTile(shaded, _settings.tileSize);
+
+		auto tracePass = [&](const Tile &_subTile)
+		{
+			TraceHits(_subTile.minX, _subTile.maxX, _subTile.minY, _subTile.maxY, _scene, _bvh, _settings, _hits);
+		};
+
+		_scheduler.Run(shadedTiles, std::ref(tracePass));
+
+		auto shadePass = [&](const Tile &_subTile)
+		{
+			ShadeHits(_subTile.minX, _subTile.maxX, _subTile.minY, _subTile.maxY, _scene, _bvh, _hits, _image, nullptr);
+		};
+
+		_scheduler.Run(shadedTiles, std::ref(shadePass));
+
+		if ( antiAliased )
+		{
+			std::vector<Tile> tiles = SplitTile(_tile, _settings.tileSize);
+
+			auto edgesPass = [&](const Tile &_subTile)
+			{
+				FindEdges(_subTile.minX, _subTile.maxX, _subTile.minY, _subTile.maxY, _hits, _image);
+			};
+
+			_scheduler.Run(tiles, std::ref(edgesPass));
+
+			auto resamplePass = [&](const Tile &_subTile)
+			{
+				int shadowRays = 0;
+				ResampleEdges(_subTile.minX, _subTile.maxX, _subTile.minY, _subTile.maxY, _scene, _bvh, _settings, _hits, _image, &shadowRays);
+			};
+
+			_scheduler.Run(tiles, std::ref(resamplePass));
+		}
+	}
+
+	void CompressTile(Framebuffer &_image, const Tile &_tile, std::vector<unsigned char> *_message)
+	{
+		int rowBytes = (_tile.maxX - _tile.minX) * 3;
+		std::vector<unsigned char> pixels((size_t)rowBytes * (_tile.maxY - _tile.minY));
+
+		for ( int y = _tile.minY; y < _tile.maxY; ++y )
+		{
+			unsigned char *row = &pixels[(size_t)(y - _tile.minY) * rowBytes];
+
+			_image.QuantizeRow(y, _tile.minX, _tile.maxX, row);   // Rounded the same way the PPM and PNG writers round, so the farm's file matches a local render's
+
+			for ( int i = rowBytes - 1; i >= 3; --i )   // PNG's Sub filter, neighbouring pixels are close so the differences compress far better
+			{
+				row[i] = (unsigned char)(row[i] - row[i - 3]);
+			}
+		}
+
+		DeflateCompress(pixels.data(), pixels.size(), true, _message);
+	}
+
+	bool DecompressTile(const unsigned char *_data, size_t _size, const Tile &_tile, Framebuffer &_image)
+	{
+		int rowBytes = (_tile.maxX - _tile.minX) * 3;
+		size_t tileBytes = (size_t)rowBytes * (_tile.maxY - _tile.minY);
+		std::vector<unsigned char> pixels;
+
+		if ( !DeflateDecompress(_data, _size, tileBytes, &pixels) || pixels.size() != tileBytes )
+		{
+			return false;
+		}
+
+		for ( int y = _tile.minY; y < _tile.maxY; ++y )
+		{
+			unsigned char *row = &pixels[(size_t)(y - _tile.minY) * rowBytes];
+
+			for ( int i = 3; i < rowBytes; ++i )
+			{
+				row[i] = (unsigned char)(row[i] + row[i - 3]);
+			}
+
+			_image.DequantizeRow(y, _tile.minX, _tile.maxX, row);
+		}
+
+		return true;
+	}
+
+	struct IssuedTile
+	{
+		int tile;   // Position in the farm's tile list
+		std::chrono::steady_clock::time_point issued;
+		bool timedOut;   // Already put back in the queue, so it isn't put back twice
+	};
+
+	struct FarmConnection
+	{
+		Socket socket;
+		int id;
+		std::vector<IssuedTile> issued;   // Sent and not yet returned
+		int pendingRequests;   // Asked for when there was nothing to send
+		int tilesReturned;
+		long long bytesReceived;
+		bool dropped;
+		bool finished;
+	};
+
+	struct FarmState
+	{
+		std::mutex lock;   // Guards everything below, and the console
+		std::vector<Tile> tiles;
+		std::vector<unsigned char> claimed;   // One per tile, set by the first result in, later copies are thrown away
+		int nextTile;   // Tiles before this have been handed out at least once
+		std::deque<int> requeued;   // Timed out or dropped tiles waiting to be handed out again
+		int finishedTiles;
+		int requeuedTiles;
+		int duplicateResults;
+	};
+
+	bool TakeTile(FarmState &_state, FarmConnection &_connection, int *_tile)   // Call with the lock held
+	{
+		for ( std::deque<int>::iterator it = _state.requeued.begin(); it != _state.requeued.end(); )
+		{
+			int tile = *it;
+
+			if ( _state.claimed[tile] )
+			{
+				it = _state.requeued.erase(it);
+				continue;
+			}
+
+			bool ownTile = false;   // A worker that timed out on a tile isn't sent it again
+
+			for ( size_t i = 0; i < _connection.issued.size(); ++i )
+			{
+				ownTile = ownTile || _connection.issued[i].tile == tile;
+			}
+
+			if ( !ownTile )
+			{
+				_state.requeued.erase(it);
+				*_tile = tile;
+
+				return true;
+			}
+
+			++it;
+		}
+
+		if ( _state.nextTile < (int)_state.tiles.size() )
+		{
+			*_tile = _state.nextTile++;
+			return true;
+		}
+
+		return false;
+	}
+
+	void ServeWorker(FarmState &_state, FarmConnection &_connection, const std::vector<unsigned char> &_sceneMessage, Framebuffer &_image, int _tileTimeoutMs)
+	{
+		unsigned int type = 0;
+		std::vector<unsigned char> message;
+		std::vector<unsigned char> reply;
+
+		_connection.socket.setTimeout(FARM_CONNECT_TIMEOUT_MS);   // A worker that stops reading or stalls halfway through a result is dropped rather than holding up this thread
+
+		bool connected = _connection.socket.Send(MESSAGE_SCENE, _sceneMessage);   // Sent from here so a slow worker only holds up its own thread
+
+		while ( connected )
+		{
+			int ready = _connection.socket.WaitForData(FARM_POLL_MS);
+
+			if ( ready != 0 )
+			{
+				if ( ready < 0 || !_connection.socket.Receive(&type, &message) )
+				{
+					break;
+				}
+
+				_connection.bytesReceived += 8 + (long long)message.size();
+
+				if ( type == MESSAGE_REQUEST )
+				{
+					std::lock_guard<std::mutex> guard(_state.lock);
+					_connection.pendingRequests++;
+				}
+				else if ( type == MESSAGE_RESULT )
+				{
+					MessageReader reader(message);
+					Tile tile = reader.GetTile();
+					int position = -1;
+					bool claimed = false;
+
+					{
+						std::lock_guard<std::mutex> guard(_state.lock);
+
+						for ( size_t i = 0; i < _connection.issued.size(); ++i )
+						{
+							if ( _state.tiles[_connection.issued[i].tile].index == tile.index )
+							{
+								position = _connection.issued[i].tile;
+								_connection.issued.erase(_connection.issued.begin() + i);
+								break;
+							}
+						}
+
+						if ( !reader.isGood() || position < 0 )
+						{
+							std::cout << "Worker " << _connection.id << " sent a tile it wasn't given" << std::endl;
+							break;
+						}
+
+						tile = _state.tiles[position];   // The bounds are the coordinator's own, not whatever the worker sent
+
+						if ( _state.claimed[position] )
+						{
+							_state.duplicateResults++;
+						}
+						else
+						{
+							_state.claimed[position] = 1;
+							claimed = true;
+						}
+					}
+
+					// Only the thread that claimed the tile writes its pixels, so they're decoded outside the lock
+
+					bool decoded = !claimed || DecompressTile(reader.getRest(), reader.getRestSize(), tile, _image);
+
+					std::lock_guard<std::mutex> guard(_state.lock);
+
+					if ( !decoded )
+					{
+						std::cout << "Worker " << _connection.id << " sent a tile that wouldn't decompress" << std::endl;
+
+						_state.claimed[position] = 0;
+						_state.requeued.push_back(position);
+						_state.requeuedTiles++;
+						break;
+					}
+
+					_connection.tilesReturned++;
+					_state.finishedTiles += claimed ? 1 : 0;
+				}
+			}
+
+			std::lock_guard<std::mutex> guard(_state.lock);
+
+			if ( _state.finishedTiles == (int)_state.tiles.size() )
+			{
+				_connection.finished = _connection.socket.Send(MESSAGE_DONE, std::vector<unsigned char>());
+				return;
+			}
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			for ( size_t i = 0; i < _connection.issued.size(); ++i )
+			{
+				IssuedTile &issued = _connection.issued[i];
+
+				if ( !issued.timedOut && !_state.claimed[issued.tile] && now - issued.issued > std::chrono::milliseconds(_tileTimeoutMs) )
+				{
+					issued.timedOut = true;   // Left on this worker too, whichever copy comes back first is kept
+					_state.requeued.push_back(issued.tile);
+					_state.requeuedTiles++;
+				}
+			}
+
+			int tile = 0;
+
+			while ( _connection.pendingRequests > 0 && TakeTile(_state, _connection, &tile) )
+			{
+				reply.clear();
+				PutTile(&reply, _state.tiles[tile]);
+
+				IssuedTile issued;
+				issued.tile = tile;
+				issued.issued = now;
+				issued.timedOut = false;
+
+				_connection.issued.push_back(issued);
+				_connection.pendingRequests--;
+
+				if ( !_connection.socket.Send(MESSAGE_TILE, reply) )
+				{
+					break;   // Picked up as a dropped connection on the next read
+				}
+			}
+		}
+
+		// The connection dropped or sent something it shouldn't have, what it still had out goes to the other workers
+
+		std::lock_guard<std::mutex> guard(_state.lock);
+
+		for ( size_t i = 0; i < _connection.issued.size(); ++i )
+		{
+			if ( !_state.claimed[_connection.issued[i].tile] && !_connection.issued[i].timedOut )
+			{
+				_state.requeued.push_back(_connection.issued[i].tile);
+				_state.requeuedTiles++;
+			}
+		}
+
+		_connection.issued.clear();
+		_connection.dropped = true;
+		_connection.socket.Close();
+
+		std::cout << "Worker " << _connection.id << " dropped out, its tiles have gone back in the queue" << std::endl;
+	}
+
+	void PrintFarmStats(FarmState &_state, const std::vector<std::unique_ptr<FarmConnection>> &_connections, int _width, int _height, double _seconds)
+	{
+		std::ios::fmtflags flags = std::cout.flags();
+		std::streamsize precision = std::cout.precision();
+
+		std::cout << std::fixed << std::setprecision(1);
+
+		std::cout << std::left << std::setw(10) << "Worker" << std::right << std::setw(10) << "Tiles" << std::setw(16) << "KB received" << std::setw(12) << "Status" << std::endl;
+
+		long long bytesReceived = 0;
+
+		for ( size_t i = 0; i < _connections.size(); ++i )
+		{
+			const FarmConnection &connection = *_connections[i];
+
+			std::cout << std::left << std::setw(10) << connection.id << std::right << std::setw(10) << connection.tilesReturned << std::setw(16) << connection.bytesReceived / 1024.0
+				<< std::setw(12) << (connection.dropped ? "dropped" : "finished") << std::endl;
+
+			bytesReceived += connection.bytesReceived;
+		}
+
+		double rawBytes = (double)_width * _height * 3;
+
+		std::cout << "\n" << std::endl;
+		std::cout << "Time taken: " << _seconds << " seconds" << std::endl;
+		std::cout << "Tiles: " << _state.tiles.size() << ", " << _state.requeuedTiles << " handed out again after a timeout or a dropped worker, " << _state.duplicateResults << " late copies thrown away" << std::endl;
+		std::cout << "Received " << bytesReceived / 1024.0 << " KB, " << (bytesReceived > 0 ? rawBytes / bytesReceived : 0.0) << "x smaller than the 8 bit pixels and "
+			<< (bytesReceived > 0 ? rawBytes * 4 / bytesReceived : 0.0) << "x smaller than the framebuffer's floats" << std::endl;
+		std::cout << "\n" << std::endl;
+
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+}
+
+bool RenderFarmFrame(const RenderSettings &_settings, int _port, int _tileTimeoutMs, Framebuffer &_image)
+{
+	Socket::Startup();
+
+	Socket listener;
+
+	if ( !listener.Listen(_port) )
+	{
+		std::cout << "Couldn't listen on port " << _port << std::endl;
+		std::cout << "\n" << std::endl;
+
+		return false;
+	}
+
+	std::vector<unsigned char> sceneMessage;
+	WriteScene(_settings, LoadShapes(_settings), &sceneMessage);   // Made once, every worker gets the same bytes
+
+	FarmState state;
+	state.tiles = TileScheduler::MakeTiles(_settings.width, _settings.height, FARM_TILE_SIZE, _settings.tileOrder);
+	state.claimed.assign(state.tiles.size(), 0);
+	state.nextTile = 0;
+	state.finishedTiles = 0;
+	state.requeuedTiles = 0;
+	state.duplicateResults = 0;
+
+	std::vector<std::unique_ptr<FarmConnection>> connections;
+	std::vector<std::thread> threads;
+
+	std::cout << "Waiting for workers on port " << listener.getPort() << ", " << state.tiles.size() << " tiles to hand out.." << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point lastWorker = start;   // The last time any worker was connected
+	bool finished = false;
+
+	while ( !finished )
+	{
+		if ( listener.WaitForData(FARM_POLL_MS) == 1 )   // Workers can join at any point, not just at the start
+		{
+			std::unique_ptr<FarmConnection> connection(new FarmConnection());
+			connection->id = (int)connections.size();
+			connection->pendingRequests = 0;
+			connection->tilesReturned = 0;
+			connection->bytesReceived = 0;
+			connection->dropped = false;
+			connection->finished = false;
+
+			if ( listener.Accept(&connection->socket) )
+			{
+				{
+					std::lock_guard<std::mutex> guard(state.lock);
+					std::cout << "Worker " << connection->id << " joined" << std::endl;
+				}
+
+				FarmConnection *worker = connection.get();
+				connections.push_back(std::move(connection));
+				threads.push_back(std::thread([&state, worker, &sceneMessage, &_image, _tileTimeoutMs]() { ServeWorker(state, *worker, sceneMessage, _image, _tileTimeoutMs); }));
+			}
+		}
+
+		std::lock_guard<std::mutex> guard(state.lock);
+
+		finished = state.finishedTiles == (int)state.tiles.size();
+
+		for ( size_t i = 0; i < connections.size(); ++i )
+		{
+			if ( !connections[i]->dropped )
+			{
+				lastWorker = std::chrono::steady_clock::now();
+			}
+		}
+
+		if ( !finished && std::chrono::steady_clock::now() - lastWorker > std::chrono::milliseconds(FARM_CONNECT_TIMEOUT_MS) )
+		{
+			std::cout << "No workers for " << FARM_CONNECT_TIMEOUT_MS / 1000 << " seconds, giving up with " << state.finishedTiles << " of " << state.tiles.size() << " tiles done" << std::endl;
+			std::cout << "\n" << std::endl;
+
+			break;
+		}
+	}
+
+	for ( size_t i = 0; i < threads.size(); ++i )
+	{
+		threads[i].join();   // Every connection thread returns once the frame is done or its worker drops
+	}
+
+	std::cout << "\n" << std::endl;
+
+	PrintFarmStats(state, connections, _settings.width, _settings.height, RenderStats::SecondsSince(start));
+
+	return finished;
+}
+
+bool RunFarmWorker(const std::string &_host, int _port, int _threadCount)
+{
+	Socket::Startup();
+
+	Socket connection;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	while ( !connection.Connect(_host, _port) )   // The coordinator may not be listening yet
+	{
+		if ( std::chrono::steady_clock::now() - start > std::chrono::milliseconds(FARM_CONNECT_TIMEOUT_MS) )
+		{
+			std::cout << "Couldn't connect to " << _host << ":" << _port << std::endl;
+			return false;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(FARM_POLL_MS * 4));
+	}
+
+	unsigned int type = 0;
+	std::vector<unsigned char> message;
+
+	RenderSettings settings;
+	std::vector<std::shared_ptr<Shape>> shapeVector;
+
+	if ( !connection.Receive(&type, &message) || type != MESSAGE_SCENE || !ReadScene(message, &settings, &shapeVector) )
+	{
+		std::cout << "Didn't get a scene from the coordinator" << std::endl;
+		return false;
+	}
+
+	Scene scene(shapeVector);
+
+	scene.getCamera().LookAt(settings.cameraPosition, settings.cameraTarget, glm::vec3(0, 1, 0));
+	scene.getCamera().setFieldOfView(settings.fieldOfView);
+	scene.getCamera().setResolution(settings.width, settings.height);   // Rays are worked out for the whole frame, so a tile's rays match a local render's
+
+	BVH bvh;
+	bvh.Build(scene);
+
+	// Whole frame buffers left unwritten, the OS only gives them memory for the pages of the tiles this worker is sent
+
+	HitBuffer hits(settings.width, settings.height, false);
+	Framebuffer image(settings.width, settings.height, false);
+
+	ThreadPool pool(std::max(1, _threadCount));
+	TileScheduler scheduler(pool, settings.tileSize);
+
+	const std::vector<unsigned char> request;   // Requests carry nothing
+	std::vector<unsigned char> result;
+
+	for ( int i = 0; i < FARM_TILES_IN_FLIGHT; ++i )
+	{
+		if ( !connection.Send(MESSAGE_REQUEST, request) )
+		{
+			return false;
+		}
+	}
+
+	int tilesRendered = 0;
+
+	for ( ;; )
+	{
+		if ( !connection.Receive(&type, &message) )
+		{
+			std::cout << "Lost the coordinator after " << tilesRendered << " tiles" << std::endl;
+			return false;
+		}
+
+		if ( type == MESSAGE_DONE )
+		{
+			break;
+		}
+
+		if ( type != MESSAGE_TILE )
+		{
+			continue;
+		}
+
+		MessageReader reader(message);
+		Tile tile = reader.GetTile();
+
+		if ( !reader.isGood() || tile.minX < 0 || tile.minY < 0 || tile.maxX > settings.width || tile.maxY > settings.height || tile.minX >= tile.maxX || tile.minY >= tile.maxY )
+		{
+			std::cout << "The coordinator sent a tile outside the frame" << std::endl;
+			return false;
+		}
+
+		RenderFarmTile(tile, scene, bvh, settings, hits, image, scheduler);
+
+		result.clear();
+		PutTile(&result, tile);
+		CompressTile(image, tile, &result);
+
+		if ( !connection.Send(MESSAGE_RESULT, result) || !connection.Send(MESSAGE_REQUEST, request) )
+		{
+			std::cout << "Lost the coordinator after " << tilesRendered << " tiles" << std::endl;
+			return false;
+		}
+
+		tilesRendered++;
+	}
+
+	std::cout << "Rendered " << tilesRendered << " tiles in " << RenderStats::SecondsSince(start) << " seconds" << std::endl;
+
+	return true;
+}
+
+std::string FarmWorkerCommand(const std::string &_program, int _port, int _threadCount)
+{
+	std::string arguments = " --farm-worker 127.0.0.1 " + std::to_string(_port) + " " + std::to_string(_threadCount);
+
+#ifdef _WIN32
+	return "start \"\" /B \"" + _program + "\"" + arguments + " > NUL";
+#else
+	return "\"" + _program + "\"" + arguments + " > /dev/null &";
+#endif
+}
@@ -0,0 +1,29 @@
+/// \file RenderFarm.h
+/// \brief Functions for rendering one frame across worker processes over TCP, the coordinator hands out tiles and puts the image together
+/// \author Thomas Hardy
+
+#ifndef RENDERFARM_H
+#define RENDERFARM_H
+
+#include <string>
+
+#include "RenderSettings.h"
+#include "Framebuffer.h"
+
+#define FARM_DEFAULT_PORT (5150)   // Macro for the port the coordinator listens on unless another is chosen
+#define FARM_TILE_SIZE (128)   // Macro for the width and height of the tiles sent to workers, bigger than a thread's tile so the per tile network cost stays small
+#define FARM_TILES_IN_FLIGHT (2)   // Macro for how many tiles a worker asks for ahead, so the next one is already waiting when it sends a result
+#define FARM_TILE_TIMEOUT_MS (60000)   // Macro for how long a tile can be out before a copy is handed to another worker
+#define FARM_CONNECT_TIMEOUT_MS (30000)   // Macro for how long either side waits for the other before giving up
+#define FARM_POLL_MS (50)   // Macro for how often the coordinator's connection threads check for timed out tiles when nothing arrives
+
+// The coordinator builds the demo scene and loads the settings' mesh, then sends every sphere, plane and mesh (as vertices and indices) with the settings.
+// Workers build their scene from that message alone, so they need neither the mesh file nor the same demo scene.
+// _image is filled with the finished frame, false if every worker dropped out before it was done
+
+bool RenderFarmFrame(const RenderSettings &_settings, int _port, int _tileTimeoutMs, Framebuffer &_image);
+
+bool RunFarmWorker(const std::string &_host, int _port, int _threadCount);   // Renders tiles for a coordinator until it says the frame is done, false if it couldn't connect or the connection dropped
+
+std::string FarmWorkerCommand(const std::string &_program, int _port, int _threadCount);   // A shell command that starts a worker for this machine's coordinator without waiting for it
+#endif
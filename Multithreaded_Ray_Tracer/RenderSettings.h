@@ -0,0 +1,47 @@
+/// \file RenderSettings.h
+/// \brief Struct for the 'RenderSettings' chosen at the start of a render
+/// \author Thomas Hardy
+
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+#include <string>
+#include <glm.hpp>
+
+#include "SpaceFillingCurve.h"
+
+#define RENDER_MAX_SIZE (16384)   // Macro for the widest and tallest image, a frame this size already needs a few GB for its buffers
+#define RENDER_MAX_SAMPLES (64)   // Macro for the most rays an edge pixel can be given
+
+enum OutputFormat
+{
+	OUTPUT_PPM,   // Encoded by EncodePPM and written after the last frame
+	OUTPUT_MAPPED_PPM,   // Written tile by tile into a memory mapped file during the last frame
+	OUTPUT_PNG   // Compressed across the thread pool after the last frame
+};
+
+enum PreviewMode
+{
+	PREVIEW_OFF,
+	PREVIEW_WINDOW,   // Tiles are shown in an SDL window as they finish
+	PREVIEW_HEADLESS   // The same presents through SDL's dummy video driver, for timing without a display
+};
+
+struct RenderSettings
+{
+	int width = 800;   // Image size in pixels, any size works
+	int height = 800;
+	int tileSize = 32;   // Width and height of each tile handed to a thread, kept the same whatever the thread count
+	int maxSamples = 1;   // 1 is one ray per pixel, otherwise edge pixels get this many stratified rays in all, the one through the centre included
+	int packetSize = 1;   // 1 traces primary rays one at a time, 4, 8 or 16 traces them together as a RayPacket
+	CurveOrder tileOrder = ORDER_SCANLINE;   // The order the frame's tiles are shared out and run in
+	CurveOrder pixelOrder = ORDER_SCANLINE;   // The order primary rays are traced within a tile, packets keep their own blocks
+	OutputFormat outputFormat = OUTPUT_PPM;
+	glm::vec3 cameraPosition = glm::vec3(0, 0, 0);
+	glm::vec3 cameraTarget = glm::vec3(0, 0, -1);   // The point the camera looks at
+	float fieldOfView = 90.0f;   // Vertical, in degrees
+	PreviewMode preview = PREVIEW_OFF;
+	bool checkpoint = false;   // The last frame's finished tiles are saved as it renders, and a render started again with the same scene and settings skips them
+	std::string meshPath;   // OBJ file added to the scene, empty for none
+};
+#endif
@@ -0,0 +1,340 @@
+/// @file RenderStats.cpp
+/// @brief Contains functions for the RenderStats class
+/// Idle time is a pass's wall time less the time the worker spent inside tiles, so it covers stealing, waiting for the last tile and waking up
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "RenderStats.h"
+
+RenderStats::RenderStats(int _threadCount, int _width, int _height, int _tileSize)
+{
+	m_threadCount = _threadCount;
+	m_width = _width;
+	m_height = _height;
+	m_tileSize = _tileSize;
+	m_frameCount = 0;
+	m_totalSeconds = 0.0;
+	m_firstImageSeconds = -1.0;
+	m_primaryRays = 0;
+	m_shadowRays = 0;
+	m_pixels = 0;
+	m_samples = 0;
+}
+
+double RenderStats::SecondsSince(std::chrono::steady_clock::time_point _start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void RenderStats::AddPhase(const std::string &_name, double _seconds)
+{
+	FindPhase(_name).seconds += _seconds;
+}
+
+void RenderStats::AddPass(const std::string &_name, TileScheduler &_scheduler)
+{
+	Pass *pass = nullptr;
+
+	for ( size_t i = 0; i < m_passes.size(); ++i )
+	{
+		if ( m_passes[i].name == _name )
+		{
+			pass = &m_passes[i];
+		}
+	}
+
+	if ( pass == nullptr )
+	{
+		m_passes.push_back(Pass());
+		pass = &m_passes.back();
+		pass->name = _name;
+		pass->seconds = 0.0;
+		pass->workerBusySeconds.assign(m_threadCount, 0.0);
+	}
+
+	pass->seconds += _scheduler.getRunSeconds();
+
+	const std::vector<double> &busySeconds = _scheduler.getWorkerBusySeconds();
+
+	for ( size_t i = 0; i < busySeconds.size() && i < pass->workerBusySeconds.size(); ++i )
+	{
+		pass->workerBusySeconds[i] += busySeconds[i];
+	}
+
+	const std::vector<Tile> &tiles = _scheduler.getTiles();
+	const std::vector<TileTiming> &tileTimings = _scheduler.getTileTimings();
+
+	for ( size_t i = 0; i < tiles.size() && i < tileTimings.size(); ++i )
+	{
+		const Tile &tile = tiles[i];
+
+		if ( tile.index >= (int)pass->tiles.size() )
+		{
+			Tile unrun = tile;
+			unrun.index = -1;
+
+			pass->tiles.resize(tile.index + 1, unrun);
+			pass->tileSeconds.resize(tile.index + 1, 0.0);
+		}
+
+		pass->tiles[tile.index] = tile;
+		pass->tileSeconds[tile.index] += tileTimings[i].seconds;
+	}
+}
+
+void RenderStats::AddRays(long long _primaryRays, long long _shadowRays)
+{
+	m_primaryRays += _primaryRays;
+	m_shadowRays += _shadowRays;
+}
+
+void RenderStats::AddSamples(long long _pixels, long long _samples)
+{
+	m_pixels += _pixels;
+	m_samples += _samples;
+}
+
+void RenderStats::Print()
+{
+	std::ios::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+
+	std::cout << std::fixed << std::setprecision(2);
+
+	std::cout << "Phase times (wall clock):" << std::endl;
+
+	for ( size_t i = 0; i < m_phases.size(); ++i )
+	{
+		std::cout << "  " << std::left << std::setw(14) << m_phases[i].name << std::right << std::setw(10) << m_phases[i].seconds * 1000.0 << " ms" << std::endl;
+	}
+
+	std::cout << "  " << std::left << std::setw(14) << "total" << std::right << std::setw(10) << m_totalSeconds * 1000.0 << " ms" << std::endl;
+
+	if ( m_firstImageSeconds >= 0.0 )
+	{
+		std::cout << "  " << std::left << std::setw(14) << "first image" << std::right << std::setw(10) << m_firstImageSeconds * 1000.0 << " ms" << std::endl;
+	}
+
+	std::cout << "\n" << std::endl;
+
+	for ( size_t i = 0; i < m_passes.size(); ++i )
+	{
+		const Pass &pass = m_passes[i];
+
+		std::cout << "Pass '" << pass.name << "': " << pass.seconds * 1000.0 << " ms over " << m_frameCount << " frame(s)" << std::endl;
+
+		for ( int worker = 0; worker < (int)pass.workerBusySeconds.size(); ++worker )
+		{
+			double busy = pass.workerBusySeconds[worker];
+			double idle = std::max(0.0, pass.seconds - busy);
+
+			std::cout << "  Thread " << std::setw(3) << worker << ": busy " << std::setw(10) << busy * 1000.0 << " ms, idle " << std::setw(10) << idle * 1000.0 << " ms ("
+				<< std::setw(5) << (pass.seconds > 0.0 ? 100.0 * idle / pass.seconds : 0.0) << "%)" << std::endl;
+		}
+
+		size_t slowest = 0;
+		double fastest = 0.0;
+		double sum = 0.0;
+		int tileCount = 0;
+
+		for ( size_t tile = 0; tile < pass.tiles.size(); ++tile )
+		{
+			if ( pass.tiles[tile].index == -1 )
+			{
+				continue;
+			}
+
+			if ( tileCount == 0 || pass.tileSeconds[tile] > pass.tileSeconds[slowest] )
+			{
+				slowest = tile;
+			}
+
+			fastest = tileCount == 0 ? pass.tileSeconds[tile] : std::min(fastest, pass.tileSeconds[tile]);
+			sum += pass.tileSeconds[tile];
+			++tileCount;
+		}
+
+		if ( tileCount > 0 )
+		{
+			std::cout << "  " << tileCount << " tiles: fastest " << fastest * 1000.0 << " ms, mean " << sum * 1000.0 / tileCount << " ms, slowest "
+				<< pass.tileSeconds[slowest] * 1000.0 << " ms at (" << pass.tiles[slowest].minX << ", " << pass.tiles[slowest].minY << ")" << std::endl;
+		}
+
+		std::cout << "\n" << std::endl;
+	}
+
+	std::cout << "Primary rays: " << m_primaryRays << ", shadow rays: " << m_shadowRays << ", " << getRaysPerSecond() / 1000000.0 << " million rays/second" << std::endl;
+	std::cout << "Average samples per pixel: " << getSamplesPerPixel() << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
+
+bool RenderStats::WriteJSON(const std::string &_path)
+{
+	std::ofstream ofs(_path, std::ios::out);
+
+	ofs << std::setprecision(9);
+
+	ofs << "{\n";
+	ofs << "  \"width\": " << m_width << ",\n";
+	ofs << "  \"height\": " << m_height << ",\n";
+	ofs << "  \"threads\": " << m_threadCount << ",\n";
+	ofs << "  \"frames\": " << m_frameCount << ",\n";
+	ofs << "  \"tileSize\": " << m_tileSize << ",\n";
+	ofs << "  \"totalSeconds\": " << m_totalSeconds << ",\n";
+
+	if ( m_firstImageSeconds >= 0.0 )
+	{
+		ofs << "  \"firstImageSeconds\": " << m_firstImageSeconds << ",\n";
+	}
+
+	ofs << "  \"phases\": [";
+
+	for ( size_t i = 0; i < m_phases.size(); ++i )
+	{
+		ofs << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << m_phases[i].name << "\", \"seconds\": " << m_phases[i].seconds << " }";
+	}
+
+	ofs << "\n  ],\n";
+
+	ofs << "  \"passes\": [";
+
+	for ( size_t i = 0; i < m_passes.size(); ++i )
+	{
+		const Pass &pass = m_passes[i];
+
+		ofs << (i == 0 ? "\n" : ",\n") << "    {\n";
+		ofs << "      \"name\": \"" << pass.name << "\",\n";
+		ofs << "      \"seconds\": " << pass.seconds << ",\n";
+		ofs << "      \"threads\": [";
+
+		for ( size_t worker = 0; worker < pass.workerBusySeconds.size(); ++worker )
+		{
+			double busy = pass.workerBusySeconds[worker];
+
+			ofs << (worker == 0 ? "\n" : ",\n") << "        { \"thread\": " << worker << ", \"busySeconds\": " << busy << ", \"idleSeconds\": " << std::max(0.0, pass.seconds - busy) << " }";
+		}
+
+		ofs << "\n      ],\n";
+		ofs << "      \"tiles\": [";
+
+		bool firstTile = true;
+
+		for ( size_t tile = 0; tile < pass.tiles.size(); ++tile )
+		{
+			const Tile &bounds = pass.tiles[tile];
+
+			if ( bounds.index == -1 )
+			{
+				continue;
+			}
+
+			ofs << (firstTile ? "\n" : ",\n") << "        { \"minX\": " << bounds.minX << ", \"maxX\": " << bounds.maxX << ", \"minY\": " << bounds.minY << ", \"maxY\": " << bounds.maxY
+				<< ", \"seconds\": " << pass.tileSeconds[tile] << " }";
+
+			firstTile = false;
+		}
+
+		ofs << "\n      ]\n";
+		ofs << "    }";
+	}
+
+	ofs << "\n  ],\n";
+
+	ofs << "  \"rays\": { \"primary\": " << m_primaryRays << ", \"shadow\": " << m_shadowRays << ", \"perSecond\": " << getRaysPerSecond() << " },\n";
+	ofs << "  \"samplesPerPixel\": " << getSamplesPerPixel() << "\n";
+	ofs << "}\n";
+	ofs.close();
+
+	return !ofs.fail();
+}
+
+RenderStats::Phase& RenderStats::FindPhase(const std::string &_name)
+{
+	for ( size_t i = 0; i < m_phases.size(); ++i )
+	{
+		if ( m_phases[i].name == _name )
+		{
+			return m_phases[i];
+		}
+	}
+
+	Phase phase;
+	phase.name = _name;
+	phase.seconds = 0.0;
+	m_phases.push_back(phase);
+
+	return m_phases.back();
+}
+
+double RenderStats::getRenderSeconds()
+{
+	for ( size_t i = 0; i < m_phases.size(); ++i )
+	{
+		if ( m_phases[i].name == "render" )
+		{
+			return m_phases[i].seconds;
+		}
+	}
+
+	return 0.0;
+}
+
+double RenderStats::getLoadImbalance()
+{
+	std::vector<double> busySeconds(m_threadCount, 0.0);
+
+	for ( size_t i = 0; i < m_passes.size(); ++i )
+	{
+		for ( int worker = 0; worker < m_threadCount; ++worker )
+		{
+			busySeconds[worker] += m_passes[i].workerBusySeconds[worker];
+		}
+	}
+
+	double busiest = 0.0;
+	double sum = 0.0;
+
+	for ( int worker = 0; worker < m_threadCount; ++worker )
+	{
+		busiest = std::max(busiest, busySeconds[worker]);
+		sum += busySeconds[worker];
+	}
+
+	return sum > 0.0 ? busiest * m_threadCount / sum : 1.0;
+}
+
+double RenderStats::getIdleFraction()
+{
+	double threadSeconds = 0.0;
+	double busySeconds = 0.0;
+
+	for ( size_t i = 0; i < m_passes.size(); ++i )
+	{
+		threadSeconds += m_passes[i].seconds * m_threadCount;
+
+		for ( int worker = 0; worker < m_threadCount; ++worker )
+		{
+			busySeconds += m_passes[i].workerBusySeconds[worker];
+		}
+	}
+
+	return threadSeconds > 0.0 ? std::max(0.0, 1.0 - busySeconds / threadSeconds) : 0.0;
+}
+
+double RenderStats::getSamplesPerPixel()
+{
+	return m_pixels > 0 ? (double)m_samples / m_pixels : 0.0;
+}
+
+double RenderStats::getRaysPerSecond()
+{
+	double renderSeconds = getRenderSeconds();
+
+	return renderSeconds > 0.0 ? (m_primaryRays + m_shadowRays) / renderSeconds : 0.0;
+}
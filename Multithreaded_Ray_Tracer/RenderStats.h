@@ -0,0 +1,86 @@
+/// \file RenderStats.h
+/// \brief Class for the 'RenderStats' which collects wall clock phase times, per thread and per tile timings and ray counts for a render
+/// \author Thomas Hardy
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "TileScheduler.h"
+
+class RenderStats
+{
+public:
+
+	RenderStats(int _threadCount, int _width, int _height, int _tileSize);
+
+	static double SecondsSince(std::chrono::steady_clock::time_point _start);   // Monotonic wall clock, unlike clock() which adds up every thread's CPU time on Linux
+
+	void AddPhase(const std::string &_name, double _seconds);   // Adds onto the phase if it has been seen before, phases are reported in the order they first appear
+
+	void AddPass(const std::string &_name, TileScheduler &_scheduler);   // Takes the timings of the run the scheduler just finished, adding onto earlier frames even if they ran other tiles
+
+	void AddRays(long long _primaryRays, long long _shadowRays);
+
+	void AddSamples(long long _pixels, long long _samples);   // For the average samples per pixel when anti-aliasing
+
+	void setFrameCount( int _frameCount ) { m_frameCount = _frameCount; }
+
+	void setTotalSeconds( double _totalSeconds ) { m_totalSeconds = _totalSeconds; }
+
+	void setFirstImageSeconds( double _firstImageSeconds ) { m_firstImageSeconds = _firstImageSeconds; }   // From the start of the render to the preview's first present
+
+	double getRenderSeconds();   // The "render" phase, every frame's passes
+
+	double getLoadImbalance();   // Busiest thread's time in tiles over the average thread's, summed over the passes, 1 is perfectly even
+
+	double getIdleFraction();   // Share of the thread time in the passes spent outside tiles
+
+	void Print();
+
+	bool WriteJSON(const std::string &_path);   // Same numbers as Print plus every tile, false if the file couldn't be written
+
+private:
+
+	struct Phase
+	{
+		std::string name;
+		double seconds;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		double seconds;   // Wall clock from the first tile handed out to the last one finishing
+		std::vector<double> workerBusySeconds;
+		std::vector<Tile> tiles;   // Indexed by Tile::index, tiles no run has covered yet have an index of -1
+		std::vector<double> tileSeconds;   // Summed over frames
+	};
+
+	Phase& FindPhase(const std::string &_name);
+
+	double getSamplesPerPixel();
+
+	double getRaysPerSecond();   // Over the render phase only, so output doesn't count against it
+
+	int m_threadCount;
+	int m_width;
+	int m_height;
+	int m_tileSize;
+	int m_frameCount;
+
+	double m_totalSeconds;
+	double m_firstImageSeconds;   // Below 0 when there was no preview
+
+	long long m_primaryRays;
+	long long m_shadowRays;
+	long long m_pixels;
+	long long m_samples;
+
+	std::vector<Phase> m_phases;
+	std::vector<Pass> m_passes;
+};
+#endif
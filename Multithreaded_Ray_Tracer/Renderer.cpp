@@ -0,0 +1,676 @@
+/// @file Renderer.cpp
+/// @brief Contains the scene and the functions for tracing, shading and saving a frame
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <fstream>
+#include <iostream>
+#include <gtc/constants.hpp>
+
+#include "Renderer.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "TileScheduler.h"
+
+std::vector<std::shared_ptr<Shape>> CreateShapes(std::vector<std::shared_ptr<Shape>> _shapeVector)
+{
+	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(-2.0, 0, -7), 2, glm::vec3(0.82f, 1.00f, 0.87f)));   // Green
+	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(0.5, 0, -10), 2, glm::vec3(1.00f, 0.95f, 0.82f)));   // Yellow
+	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(3.5, 0, -13), 2, glm::vec3(1.00f, 0.87f, 0.82f)));   // Orange
+	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(6.5, 0, -16), 2, glm::vec3(0.87f, 0.82f, 1.00f)));   // Purple
+	_shapeVector.push_back(std::make_shared<Plane>(glm::vec3(0, -4, 0), glm::vec3(0, 1, 0), glm::vec3(0.57f, 0.57f, 0.57f)));   // Floor
+
+	return _shapeVector;
+}
+
+void AnimateScene(Scene &_scene, const std::vector<glm::vec3> &_restPositions, float _time)
+{
+	for ( int i = 0; i < _scene.getShapeCount() && i < (int)_restPositions.size(); ++i )
+	{
+		if ( _scene.getShapeType(i) == SHAPE_SPHERE )
+		{
+			float height = 1.5f * fabs(sin(glm::pi<float>() * _time + 0.7f * i));   // One bounce a second, each sphere a little behind the one before
+
+			_scene.getSphere(i).setPosition(_restPositions[i] + glm::vec3(0, height, 0));
+		}
+	}
+}
+
+std::shared_ptr<Mesh> LoadMesh(const std::string &_path)
+{
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(glm::vec3(0.82f, 0.90f, 1.00f));   // Blue
+
+	if ( !mesh->LoadOBJ(_path) )
+	{
+		std::cout << "Couldn't open " << _path << ", rendering without it" << std::endl;
+		std::cout << "\n" << std::endl;
+
+		return nullptr;
+	}
+
+	mesh->Fit(glm::vec3(-6.5, -1, -11), 5);   // Any model goes in the space left of the spheres whatever its own units
+	mesh->Build();
+
+	double megabytes = mesh->getMemoryBytes() / (1024.0 * 1024.0);
+
+	std::cout << "Mesh: " << mesh->getTriangleCount() << " triangles, " << mesh->getVertexCount() << " vertices" << std::endl;
+	std::cout << "Memory: " << megabytes << " MB, " << (mesh->getTriangleCount() > 0 ? (double)mesh->getMemoryBytes() / mesh->getTriangleCount() : 0.0) << " bytes per triangle" << std::endl;
+	std::cout << "Loaded in " << mesh->getLoadSeconds() * 1000.0 << " ms, BVH built in " << mesh->getBuildSeconds() * 1000.0 << " ms" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	return mesh;
+}
+
+HitRecord RecordHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _minT, int _shapeHit, Scene &_scene)
+{
+	HitRecord hit;
+	hit.t = _minT;
+	hit.shapeHit = _shapeHit;
+	hit.normal = glm::vec3(0, 0, 0);
+
+	if ( _shapeHit != -1 )
+	{
+		hit.normal = glm::normalize(_scene.Surface(_shapeHit, _rayOrigin + (_minT * _rayDirection)).normal);
+	}
+
+	return hit;
+}
+
+glm::vec3 ShadePixel(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, const HitRecord &_hit, Scene &_scene, BVH &_bvh)
+{
+	if ( _hit.shapeHit == -1 )
+	{
+		return glm::vec3(0.76, 0.93, 0.93);   // If there is no object data and no collision has occured then set pixel to sky blue
+	}
+
+	// Calculating 'Phong lighting' using specular and diffuse
+
+	glm::vec3 p0 = _rayOrigin + (_hit.t * _rayDirection);
+
+	glm::vec3 lightPosition = LIGHT_POSITION;
+	glm::vec3 lightIntensity = glm::vec3(1.0, 1.0, 1.0);
+
+	SurfacePoint surface = _scene.Material(_hit.shapeHit, p0);   // The normal comes from the hit pass
+
+	glm::vec3 diffuseColour = surface.diffuseColour;
+	glm::vec3 specularColour = surface.specularColour;
+	int shininess = surface.shininess;
+
+	glm::vec3 normal = _hit.normal;
+
+	glm::vec3 lightRay = glm::normalize(lightPosition - p0);
+
+	glm::vec3 diffuse = diffuseColour * lightIntensity * glm::max(0.0f, dot(lightRay, normal));
+
+	glm::vec3 reflection = glm::normalize(2 * (dot(lightRay, normal)) * normal - lightRay);
+
+	float maxCalc = glm::max(0.0f, dot(reflection, glm::normalize(_rayOrigin - p0)));
+
+	glm::vec3 specular = specularColour * lightIntensity * pow(maxCalc, (float)shininess);
+
+	bool lightHitShape = _bvh.AnyHit(p0 + (1e-4f * normal), lightRay, _hit.t);   // Shadow rays only need to know something is in the way, not what
+
+	if ( lightHitShape )
+	{
+		return glm::vec3(0.1, 0.1, 0.1);   // Setting it to almost black for the shadows
+	}
+
+	return diffuse + specular;
+}
+
+void TraceHits(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits)
+{
+	if ( _settings.packetSize > 1 )
+	{
+		// Neighbouring pixels are grouped into a small block (2x2, 4x2 or 4x4) and their primary rays go through the BVH together
+
+		int blockWidth = _settings.packetSize >= 8 ? 4 : 2;
+		int blockHeight = _settings.packetSize / blockWidth;
+
+		const Camera &camera = _scene.getCamera();
+
+		RayPacket packet;
+		packet.origin = camera.getPosition();
+
+		int pixelX[RAY_PACKET_MAX];
+		int pixelY[RAY_PACKET_MAX];
+		float t[RAY_PACKET_MAX];
+		int shapeHit[RAY_PACKET_MAX];
+
+		for ( int blockY = _minY; blockY < _maxY; blockY += blockHeight )
+		{
+			for ( int blockX = _minX; blockX < _maxX; blockX += blockWidth )
+			{
+				packet.size = 0;
+
+				for ( int y = blockY; y < std::min(blockY + blockHeight, _maxY); ++y )   // Blocks on the tile edge can come up short
+				{
+					for ( int x = blockX; x < std::min(blockX + blockWidth, _maxX); ++x )
+					{
+						glm::vec3 direction = camera.PixelDirection(x, y);
+
+						pixelX[packet.size] = x;
+						pixelY[packet.size] = y;
+						packet.directionX[packet.size] = direction.x;
+						packet.directionY[packet.size] = direction.y;
+						packet.directionZ[packet.size] = direction.z;
+						packet.size++;
+					}
+				}
+
+				for ( int lane = packet.size; lane < RAY_PACKET_MAX; ++lane )   // Unused lanes are never active but still get a valid direction
+				{
+					packet.directionX[lane] = packet.directionX[0];
+					packet.directionY[lane] = packet.directionY[0];
+					packet.directionZ[lane] = packet.directionZ[0];
+				}
+
+				_bvh.ClosestHitPacket(packet, t, shapeHit);
+
+				for ( int lane = 0; lane < packet.size; ++lane )
+				{
+					glm::vec3 direction = glm::vec3(packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]);
+					_hits.getHit(pixelX[lane], pixelY[lane]) = RecordHit(packet.origin, direction, t[lane], shapeHit[lane], _scene);
+				}
+			}
+		}
+
+		return;
+	}
+
+	const Camera &camera = _scene.getCamera();
+
+	auto tracePixel = [&](int _x, int _y)
+	{
+		Ray ray(camera.getPosition(), camera.PixelDirection(_x, _y));
+
+		float minT = INFINITY;
+		int shapeHit = -1;
+
+		// The BVH only tests the shapes whose boxes the ray passes through
+
+		_bvh.ClosestHit(ray.getOrigin(), ray.getDirection(), &minT, &shapeHit);
+
+		_hits.getHit(_x, _y) = RecordHit(ray.getOrigin(), ray.getDirection(), minT, shapeHit, _scene);
+	};
+
+	if ( _settings.pixelOrder != ORDER_SCANLINE )
+	{
+		// Along the curve, one ray after another stays close by in both directions rather than running off along a row
+
+		unsigned int side = CurveSide(_maxX - _minX, _maxY - _minY);
+
+		for ( unsigned int i = 0; i < side * side; ++i )
+		{
+			unsigned int offsetX = 0;
+			unsigned int offsetY = 0;
+
+			CurvePoint(_settings.pixelOrder, side, i, &offsetX, &offsetY);
+
+			if ( _minX + (int)offsetX < _maxX && _minY + (int)offsetY < _maxY )   // Tiles on the frame edge don't fill the square
+			{
+				tracePixel(_minX + offsetX, _minY + offsetY);
+			}
+		}
+
+		return;
+	}
+
+	for ( int y = _minY; y < _maxY; ++y )   // Row by row so the hit buffer is written in order
+	{
+		for ( int x = _minX; x < _maxX; ++x )
+		{
+			tracePixel(x, y);
+		}
+	}
+}
+
+int ShadeHits(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile)
+{
+	const Camera &camera = _scene.getCamera();
+	glm::vec3 rayOrigin = camera.getPosition();
+	int shadowRays = 0;
+
+	for ( int y = _minY; y < _maxY; ++y )
+	{
+		glm::vec3 *row = _image.getRow(y);
+
+		for ( int x = _minX; x < _maxX; ++x )
+		{
+			shadowRays += _hits.getHit(x, y).shapeHit != -1;   // ShadePixel casts one shadow ray for every pixel that hit something
+
+			row[x] = ShadePixel(rayOrigin, camera.PixelDirection(x, y), _hits.getHit(x, y), _scene, _bvh);   // The direction is cheaper to work out again than to store
+		}
+
+		if ( _mappedFile != nullptr )   // The tile's bytes go straight into the file while the row is still in cache
+		{
+			_image.QuantizeRow(y, _minX, _maxX, _mappedFile->getRow(y) + _minX * 3);
+		}
+	}
+
+	return shadowRays;
+}
+
+void FindEdges(int _minX, int _maxX, int _minY, int _maxY, HitBuffer &_hits, Framebuffer &_image)
+{
+	int width = _image.getWidth();
+	int height = _image.getHeight();
+
+	for ( int y = _minY; y < _maxY; ++y )
+	{
+		for ( int x = _minX; x < _maxX; ++x )
+		{
+			const HitRecord &hit = _hits.getHit(x, y);
+			glm::vec3 colour = glm::min(_image.getPixel(x, y), glm::vec3(1.0f));   // Compared as they'll be saved, so bright highlights don't all count as edges
+
+			// The four neighbours, neighbours in other tiles are only read, and the shading pass that wrote them has finished
+
+			const int offsetX[4] = { -1, 1, 0, 0 };
+			const int offsetY[4] = { 0, 0, -1, 1 };
+			bool edge = false;
+
+			for ( int i = 0; i < 4 && !edge; ++i )
+			{
+				int neighbourX = x + offsetX[i];
+				int neighbourY = y + offsetY[i];
+
+				if ( neighbourX < 0 || neighbourX >= width || neighbourY < 0 || neighbourY >= height )
+				{
+					continue;
+				}
+
+				glm::vec3 difference = glm::abs(colour - glm::min(_image.getPixel(neighbourX, neighbourY), glm::vec3(1.0f)));
+
+				edge = _hits.getHit(neighbourX, neighbourY).shapeHit != hit.shapeHit || glm::max(difference.x, glm::max(difference.y, difference.z)) > AA_CONTRAST_THRESHOLD;
+			}
+
+			_hits.getEdge(x, y) = edge;
+		}
+	}
+}
+
+int ResampleEdges(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, int *_shadowRays)
+{
+	// The pixel is split into a grid of exactly maxSamples cells, as near square as the count allows, with one ray in each. The cell holding
+	// the pixel's centre keeps the ray the shading pass already traced, so an edge pixel costs maxSamples - 1 more rays and none is wasted
+
+	int sampleCount = std::max(1, _settings.maxSamples);
+	int rows = std::max(1, (int)std::sqrt((float)sampleCount));
+
+	while ( sampleCount % rows != 0 )   // A prime count ends up as one row of strips
+	{
+		--rows;
+	}
+
+	int columns = sampleCount / rows;
+	int centreCell = (rows / 2) * columns + columns / 2;
+	int samples = 0;
+	const Camera &camera = _scene.getCamera();
+	glm::vec3 rayOrigin = camera.getPosition();
+
+	for ( int y = _minY; y < _maxY; ++y )
+	{
+		glm::vec3 *row = _image.getRow(y);
+
+		for ( int x = _minX; x < _maxX; ++x )
+		{
+			if ( !_hits.getEdge(x, y) )
+			{
+				continue;
+			}
+
+			glm::vec3 colour = row[x];   // The centre sample, from the shading pass
+
+			for ( int cell = 0; cell < sampleCount; ++cell )
+			{
+				if ( cell == centreCell )
+				{
+					continue;
+				}
+
+				// Jittered inside its cell from a hash of the pixel and cell, so the same frame always comes out the same
+
+				unsigned int hash = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)cell * 83492791u);
+				hash = (hash ^ (hash >> 16)) * 0x45d9f3bu;
+				hash = (hash ^ (hash >> 16)) * 0x45d9f3bu;
+				float jitterX = (hash & 0xFFFF) / 65536.0f;
+				float jitterY = (hash >> 16) / 65536.0f;
+
+				float sampleX = x + (cell % columns + jitterX) / columns;
+				float sampleY = y + (cell / columns + jitterY) / rows;
+				glm::vec3 direction = camera.RayDirection(sampleX, sampleY);
+
+				float minT = INFINITY;
+				int shapeHit = -1;
+
+				_bvh.ClosestHit(rayOrigin, direction, &minT, &shapeHit);
+
+				HitRecord hit = RecordHit(rayOrigin, direction, minT, shapeHit, _scene);
+				colour += ShadePixel(rayOrigin, direction, hit, _scene, _bvh);
+
+				*_shadowRays += shapeHit != -1;
+			}
+
+			row[x] = colour / (float)sampleCount;
+			samples += sampleCount - 1;
+		}
+	}
+
+	return samples;
+}
+
+int TraceCoarse(int _minX, int _maxX, int _minY, int _maxY, int _blockSize, Scene &_scene, BVH &_bvh, Framebuffer &_image, int *_shadowRays)
+{
+	const Camera &camera = _scene.getCamera();
+	glm::vec3 rayOrigin = camera.getPosition();
+	int rays = 0;
+
+	for ( int blockY = _minY; blockY < _maxY; blockY += _blockSize )
+	{
+		for ( int blockX = _minX; blockX < _maxX; blockX += _blockSize )
+		{
+			int blockMaxX = std::min(blockX + _blockSize, _maxX);
+			int blockMaxY = std::min(blockY + _blockSize, _maxY);
+
+			glm::vec3 direction = camera.PixelDirection((blockX + blockMaxX) / 2, (blockY + blockMaxY) / 2);
+
+			float minT = INFINITY;
+			int shapeHit = -1;
+
+			_bvh.ClosestHit(rayOrigin, direction, &minT, &shapeHit);
+
+			glm::vec3 colour = ShadePixel(rayOrigin, direction, RecordHit(rayOrigin, direction, minT, shapeHit, _scene), _scene, _bvh);
+
+			for ( int y = blockY; y < blockMaxY; ++y )
+			{
+				std::fill(_image.getRow(y) + blockX, _image.getRow(y) + blockMaxX, colour);
+			}
+
+			*_shadowRays += shapeHit != -1;
+			++rays;
+		}
+	}
+
+	return rays;
+}
+
+void RenderCoarse(Scene &_scene, BVH &_bvh, Framebuffer &_image, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished)
+{
+	std::atomic<long long> primaryRays(0);
+	std::atomic<long long> shadowRays(0);
+
+	_scheduler.Run(_image.getWidth(), _image.getHeight(), [&](const Tile &_tile)
+	{
+		int tileShadowRays = 0;
+
+		primaryRays += TraceCoarse(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, PREVIEW_BLOCK_SIZE, _scene, _bvh, _image, &tileShadowRays);
+		shadowRays += tileShadowRays;
+
+		_tileFinished(_tile);
+	});
+
+	_stats.AddPass("coarse", _scheduler);
+	_stats.AddRays(primaryRays, shadowRays);
+}
+
+void RenderFrame(Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished)
+{
+	// Tiles are kept small and the same size whatever the thread count so a slow tile (the spheres) can't hold up the frame, idle threads steal from busy ones
+
+	RenderTiles(_scheduler.getFrameTiles(_image.getWidth(), _image.getHeight(), _settings.tileOrder), _scene, _bvh, _settings, _hits, _image, _mappedFile, _scheduler, _stats, _tileFinished);
+}
+
+void RenderTiles(const std::vector<Tile> &_tiles, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished)
+{
+	std::atomic<long long> shadowRays(0);   // Added to once per tile
+	std::atomic<long long> extraSamples(0);
+
+	bool antiAliased = _settings.maxSamples > 1;
+	long long pixelCount = 0;
+
+	for ( size_t i = 0; i < _tiles.size(); ++i )
+	{
+		pixelCount += (long long)(_tiles[i].maxX - _tiles[i].minX) * (_tiles[i].maxY - _tiles[i].minY);
+	}
+
+	// Two passes, every primary ray is traced into the hit buffer first, then every pixel is shaded once from it.
+	// The passes go in through std::ref, a std::function holding a lambda with this many captures would allocate every call
+
+	auto tracePass = [&](const Tile &_tile)
+	{
+		TraceHits(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _settings, _hits);
+	};
+
+	_scheduler.Run(_tiles, std::ref(tracePass));
+
+	_stats.AddPass("trace", _scheduler);
+
+	auto shadePass = [&](const Tile &_tile)
+	{
+		shadowRays += ShadeHits(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _hits, _image, antiAliased ? nullptr : _mappedFile);
+
+		if ( _tileFinished )
+		{
+			_tileFinished(_tile);   // Shown now even with anti-aliasing, the edges are redone in a later pass
+		}
+	};
+
+	_scheduler.Run(_tiles, std::ref(shadePass));
+
+	_stats.AddPass("shade", _scheduler);
+
+	if ( antiAliased )
+	{
+		// Edges are found across all the tiles before any pixel changes, then only those pixels are traced again with more rays
+
+		auto edgesPass = [&](const Tile &_tile)
+		{
+			FindEdges(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _hits, _image);
+		};
+
+		_scheduler.Run(_tiles, std::ref(edgesPass));
+
+		_stats.AddPass("edges", _scheduler);
+
+		auto resamplePass = [&](const Tile &_tile)
+		{
+			int tileShadowRays = 0;
+
+			extraSamples += ResampleEdges(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _settings, _hits, _image, &tileShadowRays);
+			shadowRays += tileShadowRays;
+
+			for ( int y = _tile.minY; y < _tile.maxY && _mappedFile != nullptr; ++y )   // The file gets the finished pixels
+			{
+				_image.QuantizeRow(y, _tile.minX, _tile.maxX, _mappedFile->getRow(y) + _tile.minX * 3);
+			}
+
+			if ( _tileFinished )
+			{
+				_tileFinished(_tile);
+			}
+		};
+
+		_scheduler.Run(_tiles, std::ref(resamplePass));
+
+		_stats.AddPass("resample", _scheduler);
+	}
+
+	_stats.AddRays(pixelCount + extraSamples, shadowRays);   // One primary ray per pixel, plus the extra ones at the edges
+	_stats.AddSamples(pixelCount, pixelCount + extraSamples);
+}
+
+void RenderFrameCheckpointed(Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, Checkpoint *_checkpoint, const std::function<void(const Tile&)> &_tileFinished)
+{
+	const std::vector<Tile> &frameTiles = _scheduler.getFrameTiles(_image.getWidth(), _image.getHeight(), _settings.tileOrder);
+
+	int tilesX = (_image.getWidth() + _settings.tileSize - 1) / _settings.tileSize;   // Tile::index is in row order, so a tile's neighbours are next to it or a row of tiles away
+	int tilesY = (_image.getHeight() + _settings.tileSize - 1) / _settings.tileSize;
+	int tileCount = tilesX * tilesY;
+	bool antiAliased = _settings.maxSamples > 1;
+
+	// RenderTiles runs each pass over the whole frame, so no tile is final until the last pass is under way and a render killed before then
+	// has nothing saved. Here the frame goes down in bands of tile rows instead, each run covering three bands at different stages: band s is
+	// traced and shaded, band s - 2 has its edges found and band s - 4 is resampled. The edge pass reads a row into the bands above and below,
+	// and the lag means they're always shaded and never yet resampled when it does. Without anti-aliasing a tile is done once it's shaded
+
+	const int edgesLag = 2;
+	const int resampleLag = 4;
+
+	int bandRows = std::max(1, (CHECKPOINT_BAND_TILES_PER_THREAD * _scheduler.getThreadCount() + tilesX - 1) / tilesX);   // Enough tiles in each run to keep every thread busy
+	int bandCount = (tilesY + bandRows - 1) / bandRows;
+	int stepCount = bandCount + (antiAliased ? resampleLag : 0);
+
+	enum Stage { STAGE_SHADE, STAGE_EDGES, STAGE_RESAMPLE };
+
+	std::vector<unsigned char> stages(tileCount, STAGE_SHADE);   // What each tile in the current run is having done, by Tile::index
+	std::vector<Tile> stepTiles;
+	stepTiles.reserve(frameTiles.size());
+
+	auto isRestored = [&](int _index)
+	{
+		return _checkpoint != nullptr && _checkpoint->hasTile(_index);
+	};
+
+	// With anti-aliasing the read back tiles next to ones being rendered are traced and shaded too, so the edge pass sees the same neighbours it would in a whole frame
+
+	auto bordersRender = [&](int _index)
+	{
+		int tileX = _index % tilesX;
+
+		return (tileX > 0 && !isRestored(_index - 1)) || (tileX < tilesX - 1 && !isRestored(_index + 1))
+			|| (_index >= tilesX && !isRestored(_index - tilesX)) || (_index + tilesX < tileCount && !isRestored(_index + tilesX));
+	};
+
+	std::atomic<long long> primaryRays(0);
+	std::atomic<long long> shadowRays(0);
+	std::atomic<long long> extraSamples(0);
+	long long pixelCount = 0;
+
+	auto finish = [&](const Tile &_tile)
+	{
+		if ( _checkpoint != nullptr )
+		{
+			_checkpoint->TileFinished(_tile, _image);
+		}
+
+		if ( _tileFinished )
+		{
+			_tileFinished(_tile);
+		}
+	};
+
+	auto tilePass = [&](const Tile &_tile)
+	{
+		int stage = stages[_tile.index];
+		bool restored = isRestored(_tile.index);
+
+		if ( stage == STAGE_SHADE )
+		{
+			TraceHits(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _settings, _hits);
+			shadowRays += ShadeHits(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _hits, _image, antiAliased || restored ? nullptr : _mappedFile);
+			primaryRays += (long long)(_tile.maxX - _tile.minX) * (_tile.maxY - _tile.minY);
+
+			if ( !antiAliased && !restored )
+			{
+				finish(_tile);
+			}
+		}
+		else if ( stage == STAGE_EDGES )
+		{
+			FindEdges(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _hits, _image);
+		}
+		else
+		{
+			int tileShadowRays = 0;
+
+			extraSamples += ResampleEdges(_tile.minX, _tile.maxX, _tile.minY, _tile.maxY, _scene, _bvh, _settings, _hits, _image, &tileShadowRays);
+			shadowRays += tileShadowRays;
+
+			for ( int y = _tile.minY; y < _tile.maxY && _mappedFile != nullptr; ++y )
+			{
+				_image.QuantizeRow(y, _tile.minX, _tile.maxX, _mappedFile->getRow(y) + _tile.minX * 3);
+			}
+
+			finish(_tile);
+		}
+	};
+
+	for ( int step = 0; step < stepCount; ++step )
+	{
+		stepTiles.clear();
+
+		for ( size_t i = 0; i < frameTiles.size(); ++i )   // Kept in the frame's tile order within each band
+		{
+			const Tile &tile = frameTiles[i];
+			int band = tile.index / tilesX / bandRows;
+			bool restored = isRestored(tile.index);
+
+			if ( band == step && (!restored || (antiAliased && bordersRender(tile.index))) )
+			{
+				stages[tile.index] = STAGE_SHADE;
+				stepTiles.push_back(tile);
+
+				pixelCount += restored ? 0 : (long long)(tile.maxX - tile.minX) * (tile.maxY - tile.minY);
+			}
+			else if ( antiAliased && !restored && (band == step - edgesLag || band == step - resampleLag) )
+			{
+				stages[tile.index] = band == step - edgesLag ? STAGE_EDGES : STAGE_RESAMPLE;
+				stepTiles.push_back(tile);
+			}
+		}
+
+		if ( !stepTiles.empty() )
+		{
+			_scheduler.Run(stepTiles, std::ref(tilePass));
+
+			_stats.AddPass("bands", _scheduler);
+		}
+	}
+
+	_stats.AddRays(primaryRays + extraSamples, shadowRays);
+	_stats.AddSamples(pixelCount, pixelCount + extraSamples);
+
+	if ( _checkpoint == nullptr )
+	{
+		return;
+	}
+
+	_checkpoint->Restore(_image, _mappedFile);   // Last, the neighbours' pixels were only shaded
+
+	const std::vector<Tile> &rowTiles = _checkpoint->getTiles();
+
+	for ( size_t i = 0; i < rowTiles.size() && _tileFinished; ++i )
+	{
+		if ( _checkpoint->hasTile(rowTiles[i].index) )
+		{
+			_tileFinished(rowTiles[i]);
+		}
+	}
+}
+
+void EncodePPM(Framebuffer &_image, std::vector<unsigned char> *_file)
+{
+	std::string header = "P6\n" + std::to_string(_image.getWidth()) + " " + std::to_string(_image.getHeight()) + "\n255\n";
+
+	size_t rowBytes = (size_t)_image.getWidth() * 3;
+
+	_file->assign(header.begin(), header.end());
+	_file->resize(header.size() + rowBytes * _image.getHeight());
+
+	for ( int y = 0; y < _image.getHeight(); ++y )
+	{
+		_image.QuantizeRow(y, 0, _image.getWidth(), &(*_file)[header.size() + rowBytes * y]);
+	}
+}
+
+bool WriteFile(const std::string &_path, const std::vector<unsigned char> &_file)
+{
+	std::ofstream ofs(_path, std::ios::out | std::ios::binary);
+	ofs.write((const char*)_file.data(), _file.size());   // The whole file in one call
+	ofs.close();
+
+	return !ofs.fail();
+}
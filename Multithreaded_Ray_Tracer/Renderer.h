@@ -0,0 +1,71 @@
+/// \file Renderer.h
+/// \brief Functions for the scene and the two render passes, kept out of main so the benchmarks can time them on their own
+/// \author Thomas Hardy
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+#include "Shape.h"
+#include "Mesh.h"
+#include "Scene.h"
+#include "BVH.h"
+#include "RenderSettings.h"
+#include "HitBuffer.h"
+#include "Framebuffer.h"
+#include "MappedPPM.h"
+#include "ThreadPool.h"
+#include "RenderStats.h"
+#include "TileScheduler.h"
+#include "Checkpoint.h"
+
+std::vector<std::shared_ptr<Shape>> CreateShapes(std::vector<std::shared_ptr<Shape>> _shapeVector);   // The demo scene
+
+void AnimateScene(Scene &_scene, const std::vector<glm::vec3> &_restPositions, float _time);   // Bounces the spheres up from their rest positions, _time in seconds
+
+std::shared_ptr<Mesh> LoadMesh(const std::string &_path);   // Loads, fits and builds an OBJ mesh and prints its size and load time, null if it couldn't be read
+
+#define LIGHT_POSITION (glm::vec3(25, 155, -2))   // Macro for where the one point light is
+#define PREVIEW_BLOCK_SIZE (8)   // Macro for the width and height of the blocks the coarse preview pass fills from one ray
+#define AA_CONTRAST_THRESHOLD (0.1f)   // Macro for how far apart a colour channel can be from a neighbour's before the pixel counts as an edge
+#define CHECKPOINT_BAND_TILES_PER_THREAD (4)   // Macro for how many tiles each thread gets in a run of a checkpointed render, the bands of tile rows are made tall enough for it
+
+HitRecord RecordHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _minT, int _shapeHit, Scene &_scene);
+
+glm::vec3 ShadePixel(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, const HitRecord &_hit, Scene &_scene, BVH &_bvh);   // Phong lighting and a shadow ray
+
+// The passes take their primary rays from the scene's camera and only read it, whoever sizes the image sets the camera's resolution to match once beforehand
+
+void TraceHits(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits);   // Intersection pass for one tile
+
+int ShadeHits(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile);   // Shading pass for one tile, returns the shadow rays cast
+
+void FindEdges(int _minX, int _maxX, int _minY, int _maxY, HitBuffer &_hits, Framebuffer &_image);   // Marks pixels whose shape differs from a neighbour's or whose colour stands out from it
+
+int ResampleEdges(int _minX, int _maxX, int _minY, int _maxY, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, int *_shadowRays);   // Returns the extra samples taken, maxSamples - 1 for each edge pixel
+
+int TraceCoarse(int _minX, int _maxX, int _minY, int _maxY, int _blockSize, Scene &_scene, BVH &_bvh, Framebuffer &_image, int *_shadowRays);   // Fills each block of the tile from one ray through its middle, returns the rays traced
+
+void RenderCoarse(Scene &_scene, BVH &_bvh, Framebuffer &_image, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished);   // A low resolution frame for the preview to show while the full one renders
+
+// The scheduler is made once with the pool and the tile size and reused for every frame, after the first frame a render allocates nothing
+
+void RenderFrame(Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished = nullptr);   // _tileFinished is called from the render threads once a tile's pixels are final
+
+void RenderTiles(const std::vector<Tile> &_tiles, Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, const std::function<void(const Tile&)> &_tileFinished = nullptr);   // RenderFrame over only some tiles, the rest of the image is left as it was
+
+// RenderFrame that skips the tiles _checkpoint read back, puts their pixels in once the rest are done and hands it every other tile as it finishes.
+// The frame goes down in bands of tile rows with every pass following close behind the one before, so tiles finish all through the render rather
+// than in the last pass, the image comes out the same. A null _checkpoint renders every tile, for timing what checkpointing itself costs
+
+void RenderFrameCheckpointed(Scene &_scene, BVH &_bvh, const RenderSettings &_settings, HitBuffer &_hits, Framebuffer &_image, MappedPPM *_mappedFile, TileScheduler &_scheduler, RenderStats &_stats, Checkpoint *_checkpoint, const std::function<void(const Tile&)> &_tileFinished = nullptr);
+
+void EncodePPM(Framebuffer &_image, std::vector<unsigned char> *_file);
+
+bool WriteFile(const std::string &_path, const std::vector<unsigned char> &_file);
+#endif
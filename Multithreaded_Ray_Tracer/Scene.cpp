@@ -0,0 +1,178 @@
+/// @file Scene.cpp
+/// @brief Contains functions for the Scene class
+/// Sphere and Plane are final, so calls made on the stored objects are direct calls rather than a vtable lookup per object
+
+#include "Scene.h"
+
+Scene::Scene()
+{
+}
+
+Scene::Scene(const std::vector<std::shared_ptr<Shape>> &_shapeVector)
+{
+	for ( size_t i = 0; i < _shapeVector.size(); ++i )
+	{
+		Add(_shapeVector[i]);
+	}
+}
+
+void Scene::Clear()
+{
+	m_entries.clear();
+	m_spheres.clear();
+	m_planes.clear();
+	m_planeShapes.clear();
+	m_otherShapes.clear();
+	m_unboundedOtherShapes.clear();
+}
+
+int Scene::Add(const std::shared_ptr<Shape> &_shape)
+{
+	// The type is looked at once here so nothing after this has to ask again
+
+	ShapeEntry entry;
+	int shapeIndex = (int)m_entries.size();
+
+	if ( Sphere *sphere = dynamic_cast<Sphere*>(_shape.get()) )
+	{
+		entry.type = SHAPE_SPHERE;
+		entry.index = (int)m_spheres.size();
+		m_spheres.push_back(*sphere);
+	}
+	else if ( Plane *plane = dynamic_cast<Plane*>(_shape.get()) )
+	{
+		entry.type = SHAPE_PLANE;
+		entry.index = (int)m_planes.size();
+		m_planes.push_back(*plane);
+		m_planeShapes.push_back(shapeIndex);
+	}
+	else
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+
+		entry.type = SHAPE_OTHER;
+		entry.index = (int)m_otherShapes.size();
+		m_otherShapes.push_back(_shape);
+
+		if ( !_shape->GetBounds(&boundsMin, &boundsMax) )
+		{
+			m_unboundedOtherShapes.push_back(shapeIndex);
+		}
+	}
+
+	m_entries.push_back(entry);
+
+	return shapeIndex;
+}
+
+bool Scene::Intersection(int _shapeIndex, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_t)
+{
+	ShapeEntry entry = m_entries[_shapeIndex];
+
+	switch (entry.type)
+	{
+	case SHAPE_SPHERE:
+		return m_spheres[entry.index].Intersection(_rayOrigin, _rayDirection, _t);
+	case SHAPE_PLANE:
+		return m_planes[entry.index].Intersection(_rayOrigin, _rayDirection, _t);
+	default:
+		return m_otherShapes[entry.index]->Intersection(_rayOrigin, _rayDirection, _t);
+	}
+}
+
+bool Scene::UnboundedClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_maxT, int *_shapeHit)
+{
+	bool hit = false;
+	float t0 = 0.0f;
+
+	for ( size_t i = 0; i < m_planes.size(); ++i )
+	{
+		if ( m_planes[i].Intersection(_rayOrigin, _rayDirection, &t0) && t0 < *_maxT )
+		{
+			*_maxT = t0;
+			*_shapeHit = m_planeShapes[i];
+			hit = true;
+		}
+	}
+
+	for ( size_t i = 0; i < m_unboundedOtherShapes.size(); ++i )
+	{
+		if ( Intersection(m_unboundedOtherShapes[i], _rayOrigin, _rayDirection, &t0) && t0 < *_maxT )
+		{
+			*_maxT = t0;
+			*_shapeHit = m_unboundedOtherShapes[i];
+			hit = true;
+		}
+	}
+
+	return hit;
+}
+
+bool Scene::UnboundedAnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _maxT)
+{
+	float t0 = 0.0f;
+
+	for ( size_t i = 0; i < m_planes.size(); ++i )
+	{
+		if ( m_planes[i].Intersection(_rayOrigin, _rayDirection, &t0) && t0 < _maxT )
+		{
+			return true;
+		}
+	}
+
+	for ( size_t i = 0; i < m_unboundedOtherShapes.size(); ++i )
+	{
+		if ( Intersection(m_unboundedOtherShapes[i], _rayOrigin, _rayDirection, &t0) && t0 < _maxT )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+SurfacePoint Scene::Surface(int _shapeIndex, glm::vec3 _p0)
+{
+	ShapeEntry entry = m_entries[_shapeIndex];
+
+	switch (entry.type)
+	{
+	case SHAPE_SPHERE:
+		return m_spheres[entry.index].Surface(_p0);
+	case SHAPE_PLANE:
+		return m_planes[entry.index].Surface(_p0);
+	default:
+		return m_otherShapes[entry.index]->Surface(_p0);
+	}
+}
+
+SurfacePoint Scene::Material(int _shapeIndex, glm::vec3 _p0)
+{
+	ShapeEntry entry = m_entries[_shapeIndex];
+
+	switch (entry.type)
+	{
+	case SHAPE_SPHERE:
+		return m_spheres[entry.index].Surface(_p0);   // A sphere or plane normal is a subtraction or a copy, not worth a second path
+	case SHAPE_PLANE:
+		return m_planes[entry.index].Surface(_p0);
+	default:
+		return m_otherShapes[entry.index]->Material(_p0);
+	}
+}
+
+bool Scene::GetBounds(int _shapeIndex, glm::vec3 *_boundsMin, glm::vec3 *_boundsMax)
+{
+	ShapeEntry entry = m_entries[_shapeIndex];
+
+	switch (entry.type)
+	{
+	case SHAPE_SPHERE:
+		return m_spheres[entry.index].GetBounds(_boundsMin, _boundsMax);
+	case SHAPE_PLANE:
+		return false;   // Planes go on forever
+	default:
+		return m_otherShapes[entry.index]->GetBounds(_boundsMin, _boundsMax);
+	}
+}
@@ -0,0 +1,83 @@
+/// \file Scene.h
+/// \brief Class for the 'Scene' which keeps each kind of shape in its own array so they can be tested without virtual calls
+/// \author Thomas Hardy
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+#include <memory>
+#include <glm.hpp>
+
+#include "Shape.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Camera.h"
+
+enum ShapeType
+{
+	SHAPE_SPHERE,
+	SHAPE_PLANE,
+	SHAPE_OTHER   // Any other Shape, still goes through the virtual calls
+};
+
+class Scene
+{
+public:
+
+	Scene();
+
+	Scene(const std::vector<std::shared_ptr<Shape>> &_shapeVector);   // Sorts the shapes from CreateShapes into their arrays
+
+	void Clear();
+
+	int Add(const std::shared_ptr<Shape> &_shape);   // Returns the shape's index, hits are reported with it and it follows the order shapes were added in
+
+	bool Intersection(int _shapeIndex, glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_t);   // One switch on the type then a direct call
+
+	bool UnboundedClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float *_maxT, int *_shapeHit);   // Every plane in one loop, then any other shape with no bounds
+
+	bool UnboundedAnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, float _maxT);   // Shadow version, stops at the first hit closer than _maxT
+
+	SurfacePoint Surface(int _shapeIndex, glm::vec3 _p0);   // Normal and material of the shape that was hit
+
+	SurfacePoint Material(int _shapeIndex, glm::vec3 _p0);   // Surface for when the normal is already known, a mesh skips looking for the triangle again
+
+	bool GetBounds(int _shapeIndex, glm::vec3 *_boundsMin, glm::vec3 *_boundsMax);
+
+	int getShapeCount() { return (int)m_entries.size(); }
+
+	ShapeType getShapeType( int _shapeIndex ) { return m_entries[_shapeIndex].type; }
+
+	Sphere& getSphere( int _shapeIndex ) { return m_spheres[m_entries[_shapeIndex].index]; }   // Only for shapes whose type is SHAPE_SPHERE
+
+	Plane& getPlane( int _shapeIndex ) { return m_planes[m_entries[_shapeIndex].index]; }   // Only for shapes whose type is SHAPE_PLANE
+
+	Shape& getOtherShape( int _shapeIndex ) { return *m_otherShapes[m_entries[_shapeIndex].index]; }   // Only for shapes whose type is SHAPE_OTHER
+
+	int getSphereCount() { return (int)m_spheres.size(); }
+
+	int getPlaneCount() { return (int)m_planes.size(); }
+
+	Camera& getCamera() { return m_camera; }
+
+private:
+
+	struct ShapeEntry
+	{
+		ShapeType type;
+		int index;   // Position in the array for that type
+	};
+
+	std::vector<ShapeEntry> m_entries;   // One per shape in the order they were added
+
+	std::vector<Sphere> m_spheres;   // Held by value and back to back rather than one heap object each
+	std::vector<Plane> m_planes;
+	std::vector<int> m_planeShapes;   // Shape index of each plane, so plane hits report the right one
+
+	std::vector<std::shared_ptr<Shape>> m_otherShapes;
+	std::vector<int> m_unboundedOtherShapes;   // Shape indices of the other shapes that have no bounds
+
+	Camera m_camera;   // Left alone by Clear, the view doesn't change with the shapes
+};
+#endif
@@ -0,0 +1,271 @@
+/// @file Sequence.cpp
+/// @brief Contains the functions for rendering an animated sequence
+/// The render stage runs on the calling thread and hands frames to an encode thread and a write thread. Only a few framebuffers exist,
+/// so when the later stages fall behind the render stage waits for one to come back rather than piling frames up in memory
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Sequence.h"
+#include "BoundedQueue.h"
+#include "Renderer.h"
+#include "RenderStats.h"
+#include "PNGWriter.h"
+
+namespace
+{
+	struct StageTimes
+	{
+		const char *name;
+		double busySeconds;
+		double inputWaitSeconds;   // Starved, waiting for the stage before it
+		double outputWaitSeconds;   // Blocked, waiting for the stage after it to make room
+	};
+
+	struct RenderedFrame
+	{
+		int index;
+		std::unique_ptr<Framebuffer> image;
+	};
+
+	struct EncodedFrame
+	{
+		int index;
+		std::vector<unsigned char> file;
+	};
+
+	void PrintStages(const StageTimes *_stages, int _stageCount, int _frameCount, double _totalSeconds)
+	{
+		std::ios::fmtflags flags = std::cout.flags();
+		std::streamsize precision = std::cout.precision();
+
+		std::cout << std::fixed << std::setprecision(2);
+
+		std::cout << std::left << std::setw(10) << "Stage" << std::right << std::setw(14) << "Busy ms" << std::setw(14) << "Per frame ms" << std::setw(12) << "Occupancy"
+			<< std::setw(14) << "Starved ms" << std::setw(14) << "Blocked ms" << std::endl;
+
+		int slowest = 0;
+
+		for ( int i = 0; i < _stageCount; ++i )
+		{
+			const StageTimes &stage = _stages[i];
+
+			std::cout << std::left << std::setw(10) << stage.name << std::right << std::setw(14) << stage.busySeconds * 1000.0 << std::setw(14) << stage.busySeconds * 1000.0 / _frameCount
+				<< std::setw(11) << (_totalSeconds > 0.0 ? 100.0 * stage.busySeconds / _totalSeconds : 0.0) << "%" << std::setw(14) << stage.inputWaitSeconds * 1000.0
+				<< std::setw(14) << stage.outputWaitSeconds * 1000.0 << std::endl;
+
+			if ( stage.busySeconds > _stages[slowest].busySeconds )
+			{
+				slowest = i;
+			}
+		}
+
+		std::cout << "\n" << std::endl;
+		std::cout << "Slowest stage: " << _stages[slowest].name << ", with the stages overlapped it sets the frame rate" << std::endl;
+		std::cout << "Occupancy is the share of the whole run a stage spent working, starved is waiting for the stage before, blocked is waiting for the one after" << std::endl;
+		std::cout << "\n" << std::endl;
+
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+}
+
+std::string SequenceFramePath(int _frame, OutputFormat _format)
+{
+	std::ostringstream path;
+	path << SEQUENCE_PATH << std::setw(4) << std::setfill('0') << _frame << (_format == OUTPUT_PNG ? ".png" : ".ppm");
+
+	return path.str();
+}
+
+void RenderSequence(ThreadPool &_pool, const RenderSettings &_settings, int _frameCount, bool _pipelined)
+{
+	std::vector<std::shared_ptr<Shape>> shapeVector = CreateShapes(std::vector<std::shared_ptr<Shape>>());
+
+	if ( !_settings.meshPath.empty() )
+	{
+		std::shared_ptr<Mesh> mesh = LoadMesh(_settings.meshPath);
+
+		if ( mesh != nullptr )
+		{
+			shapeVector.push_back(mesh);
+		}
+	}
+
+	Scene scene(shapeVector);
+
+	scene.getCamera().LookAt(_settings.cameraPosition, _settings.cameraTarget, glm::vec3(0, 1, 0));
+	scene.getCamera().setFieldOfView(_settings.fieldOfView);
+	scene.getCamera().setResolution(_settings.width, _settings.height);   // Every frame is the same size
+
+	std::vector<glm::vec3> restPositions;
+
+	for ( int i = 0; i < scene.getShapeCount(); ++i )
+	{
+		restPositions.push_back(scene.getShapeType(i) == SHAPE_SPHERE ? scene.getSphere(i).getPosition() : glm::vec3(0, 0, 0));
+	}
+
+	BVH bvh;
+	HitBuffer hits(_settings.width, _settings.height);   // Only the render stage uses it
+	TileScheduler scheduler(_pool, _settings.tileSize);
+	RenderStats stats(_pool.getThreadCount(), _settings.width, _settings.height, _settings.tileSize);
+
+	StageTimes stages[3] = { { "render", 0.0, 0.0, 0.0 }, { "encode", 0.0, 0.0, 0.0 }, { "write", 0.0, 0.0, 0.0 } };
+	StageTimes &render = stages[0];
+	StageTimes &encode = stages[1];
+	StageTimes &write = stages[2];
+
+	std::function<void(int, Framebuffer&)> renderStage = [&](int _frame, Framebuffer &_image)
+	{
+		AnimateScene(scene, restPositions, _frame / SEQUENCE_FRAME_RATE);
+		bvh.Build(scene);   // The spheres moved, a handful of them rebuild in microseconds
+
+		RenderFrame(scene, bvh, _settings, hits, _image, nullptr, scheduler, stats);
+	};
+
+	std::function<void(Framebuffer&, std::vector<unsigned char>*)> encodeStage = [&](Framebuffer &_image, std::vector<unsigned char> *_file)
+	{
+		if ( _settings.outputFormat == OUTPUT_PNG )
+		{
+			EncodePNG(_image, _pool, _file);   // Shares the pool with the render stage, its jobs queue up between the tiles
+		}
+		else
+		{
+			EncodePPM(_image, _file);
+		}
+	};
+
+	std::function<void(int, const std::vector<unsigned char>&)> writeStage = [&](int _frame, const std::vector<unsigned char> &_file)
+	{
+		std::string path = SequenceFramePath(_frame, _settings.outputFormat);
+
+		if ( !WriteFile(path, _file) )
+		{
+			std::cout << "Couldn't write " << path << std::endl;
+		}
+	};
+
+	std::cout << "Rendering " << _frameCount << " frames " << (_pipelined ? "with the stages overlapped" : "one stage at a time") << ".." << std::endl;
+	std::cout << "\n" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point stageStart;
+
+	if ( _pipelined )
+	{
+		// One image being rendered, one being encoded and a full queue between them
+
+		BoundedQueue<std::unique_ptr<Framebuffer>> freeImages(SEQUENCE_QUEUE_DEPTH + 2);
+
+		for ( int i = 0; i < SEQUENCE_QUEUE_DEPTH + 2; ++i )
+		{
+			freeImages.Push(std::unique_ptr<Framebuffer>(new Framebuffer(_settings.width, _settings.height)));
+		}
+
+		BoundedQueue<RenderedFrame> renderedFrames(SEQUENCE_QUEUE_DEPTH);
+		BoundedQueue<EncodedFrame> encodedFrames(SEQUENCE_QUEUE_DEPTH);
+
+		std::thread encodeThread([&]()
+		{
+			std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+			RenderedFrame frame;
+
+			while ( renderedFrames.Pop(&frame) )
+			{
+				encode.inputWaitSeconds += RenderStats::SecondsSince(waitStart);
+
+				EncodedFrame output;
+				output.index = frame.index;
+
+				std::chrono::steady_clock::time_point busyStart = std::chrono::steady_clock::now();
+				encodeStage(*frame.image, &output.file);
+				encode.busySeconds += RenderStats::SecondsSince(busyStart);
+
+				freeImages.Push(std::move(frame.image));   // Never waits, there's a space for every image
+
+				waitStart = std::chrono::steady_clock::now();
+				encodedFrames.Push(std::move(output));
+				encode.outputWaitSeconds += RenderStats::SecondsSince(waitStart);
+
+				waitStart = std::chrono::steady_clock::now();
+			}
+
+			encodedFrames.Close();
+		});
+
+		std::thread writeThread([&]()
+		{
+			std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+			EncodedFrame frame;
+
+			while ( encodedFrames.Pop(&frame) )
+			{
+				write.inputWaitSeconds += RenderStats::SecondsSince(waitStart);
+
+				std::chrono::steady_clock::time_point busyStart = std::chrono::steady_clock::now();
+				writeStage(frame.index, frame.file);
+				write.busySeconds += RenderStats::SecondsSince(busyStart);
+
+				waitStart = std::chrono::steady_clock::now();
+			}
+		});
+
+		for ( int i = 0; i < _frameCount; ++i )
+		{
+			RenderedFrame frame;
+			frame.index = i;
+
+			stageStart = std::chrono::steady_clock::now();
+			freeImages.Pop(&frame.image);   // Waits here when encoding has fallen behind
+			render.outputWaitSeconds += RenderStats::SecondsSince(stageStart);
+
+			stageStart = std::chrono::steady_clock::now();
+			renderStage(i, *frame.image);
+			render.busySeconds += RenderStats::SecondsSince(stageStart);
+
+			stageStart = std::chrono::steady_clock::now();
+			renderedFrames.Push(std::move(frame));
+			render.outputWaitSeconds += RenderStats::SecondsSince(stageStart);
+		}
+
+		renderedFrames.Close();   // The encode thread drains what's left, then closes the write queue in turn
+
+		encodeThread.join();
+		writeThread.join();
+	}
+	else
+	{
+		Framebuffer image(_settings.width, _settings.height);
+		std::vector<unsigned char> file;
+
+		for ( int i = 0; i < _frameCount; ++i )
+		{
+			stageStart = std::chrono::steady_clock::now();
+			renderStage(i, image);
+			render.busySeconds += RenderStats::SecondsSince(stageStart);
+
+			stageStart = std::chrono::steady_clock::now();
+			encodeStage(image, &file);
+			encode.busySeconds += RenderStats::SecondsSince(stageStart);
+
+			stageStart = std::chrono::steady_clock::now();
+			writeStage(i, file);
+			write.busySeconds += RenderStats::SecondsSince(stageStart);
+		}
+	}
+
+	double totalSeconds = RenderStats::SecondsSince(start);
+
+	std::cout << "Time taken: " << totalSeconds << " seconds, " << _frameCount / totalSeconds << " frames/second" << std::endl;
+	std::cout << "Saved as " << SequenceFramePath(0, _settings.outputFormat) << " onwards" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	PrintStages(stages, 3, _frameCount, totalSeconds);
+}
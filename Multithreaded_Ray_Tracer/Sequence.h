@@ -0,0 +1,20 @@
+/// \file Sequence.h
+/// \brief Functions for rendering an animation to one image per frame, with the render, encode and write stages overlapped
+/// \author Thomas Hardy
+
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <string>
+
+#include "RenderSettings.h"
+#include "ThreadPool.h"
+
+#define SEQUENCE_PATH ("../RayTracingFrame_")   // Macro for where the frames are saved, the frame number and extension go on the end
+#define SEQUENCE_QUEUE_DEPTH (2)   // Macro for how many frames can wait between two stages before the stage feeding them has to stop
+#define SEQUENCE_FRAME_RATE (24.0f)   // Macro for the frames per second of animation time, so the motion is the same whatever the frame count
+
+std::string SequenceFramePath(int _frame, OutputFormat _format);
+
+void RenderSequence(ThreadPool &_pool, const RenderSettings &_settings, int _frameCount, bool _pipelined);   // _pipelined runs the stages on their own threads with bounded queues between them, otherwise one frame at a time
+#endif
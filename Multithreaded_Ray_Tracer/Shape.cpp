@@ -27,4 +27,24 @@ bool Shape::Intersection(glm::vec3 rayOrigin, glm::vec3 rayDirection, float *t)
 glm::vec3 Shape::CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour)
 {
 	return m_normal;
+}
+
+SurfacePoint Shape::Surface(glm::vec3 _p0)
+{
+	SurfacePoint surface;
+	surface.shininess = 0;   // The base CalculateNormal leaves these alone
+	surface.diffuseColour = glm::vec3(0, 0, 0);
+	surface.specularColour = glm::vec3(0, 0, 0);
+	surface.normal = CalculateNormal(_p0, &surface.shininess, &surface.diffuseColour, &surface.specularColour);
+	return surface;
+}
+
+SurfacePoint Shape::Material(glm::vec3 _p0)
+{
+	return Surface(_p0);
+}
+
+bool Shape::GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax)
+{
+	return false;   // Shapes are unbounded unless they say otherwise
 }
\ No newline at end of file
@@ -7,6 +7,14 @@
 
 #include <glm.hpp>
 
+struct SurfacePoint   // Everything shading needs from the shape that was hit
+{
+	glm::vec3 normal;   // Not normalised, same as CalculateNormal
+	glm::vec3 diffuseColour;
+	glm::vec3 specularColour;
+	int shininess;
+};
+
 class Shape
 {
 public:
@@ -19,6 +27,12 @@ public:
 
 	virtual glm::vec3 CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour);   // Virtual function to be overriden by inheritance
 
+	virtual SurfacePoint Surface(glm::vec3 _p0);   // CalculateNormal returned as one struct
+
+	virtual SurfacePoint Material(glm::vec3 _p0);   // Surface without the normal, for shapes where finding the normal costs more than the material
+
+	virtual bool GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax);   // Returns false for shapes with no finite bounds (planes)
+
 	glm::vec3 getPosition() { return m_position; }
 	void setPosition( glm::vec3 _position ) { m_position = _position; }
 
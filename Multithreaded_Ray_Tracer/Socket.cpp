@@ -0,0 +1,301 @@
+/// @file Socket.cpp
+/// @brief Contains functions for the Socket class
+/// The calls are the same on both platforms bar the headers, the handle type and a few names, so the differences are kept to the top of the file
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Socket.h"
+#include "ByteOrder.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX   // Stops windows.h defining min and max macros
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef int SocketLength;
+#define CloseSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SOCKET;
+typedef socklen_t SocketLength;
+#define CloseSocket close
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS (MSG_NOSIGNAL)   // Macro for the send flags, a closed connection comes back as an error rather than a signal
+#else
+#define SEND_FLAGS (0)
+#endif
+
+namespace
+{
+	void DisableNagle(SOCKET _socket)   // Tile requests are a few bytes each, waiting to batch them up would only add latency
+	{
+		int noDelay = 1;
+		setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	}
+}
+
+Socket::Socket()
+{
+	m_handle = -1;
+}
+
+Socket::~Socket()
+{
+	Close();
+}
+
+Socket::Socket(Socket &&_other)
+{
+	m_handle = _other.m_handle;
+	_other.m_handle = -1;
+}
+
+Socket& Socket::operator=(Socket &&_other)
+{
+	if ( this != &_other )
+	{
+		Close();
+
+		m_handle = _other.m_handle;
+		_other.m_handle = -1;
+	}
+
+	return *this;
+}
+
+bool Socket::Startup()
+{
+#ifdef _WIN32
+	WSADATA data;
+
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+	signal(SIGPIPE, SIG_IGN);
+
+	return true;
+#endif
+}
+
+bool Socket::Listen(int _port)
+{
+	Close();
+
+	SOCKET handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	if ( handle == (SOCKET)-1 )
+	{
+		return false;
+	}
+
+	m_handle = (long long)handle;
+
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));   // So a coordinator can be started again straight away on the same port
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons((unsigned short)_port);
+
+	if ( bind(handle, (const sockaddr*)&address, sizeof(address)) != 0 || listen(handle, SOMAXCONN) != 0 )
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Socket::Accept(Socket *_connection)
+{
+	SOCKET handle = accept((SOCKET)m_handle, nullptr, nullptr);
+
+	if ( handle == (SOCKET)-1 )
+	{
+		return false;
+	}
+
+	DisableNagle(handle);
+
+	_connection->Close();
+	_connection->m_handle = (long long)handle;
+
+	return true;
+}
+
+bool Socket::Connect(const std::string &_host, int _port)
+{
+	Close();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	addrinfo *addresses = nullptr;
+
+	if ( getaddrinfo(_host.c_str(), std::to_string(_port).c_str(), &hints, &addresses) != 0 )
+	{
+		return false;
+	}
+
+	for ( addrinfo *address = addresses; address != nullptr; address = address->ai_next )
+	{
+		SOCKET handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+		if ( handle == (SOCKET)-1 )
+		{
+			continue;
+		}
+
+		if ( connect(handle, address->ai_addr, (SocketLength)address->ai_addrlen) == 0 )
+		{
+			DisableNagle(handle);
+			m_handle = (long long)handle;
+			break;
+		}
+
+		CloseSocket(handle);
+	}
+
+	freeaddrinfo(addresses);
+
+	return isOpen();
+}
+
+bool Socket::SendAll(const void *_data, size_t _size)
+{
+	const char *bytes = (const char*)_data;
+
+	while ( _size > 0 )
+	{
+		int chunk = (int)std::min(_size, (size_t)(1 << 30));
+		int sent = (int)send((SOCKET)m_handle, bytes, chunk, SEND_FLAGS);
+
+		if ( sent <= 0 )
+		{
+			return false;
+		}
+
+		bytes += sent;
+		_size -= sent;
+	}
+
+	return true;
+}
+
+bool Socket::ReceiveAll(void *_data, size_t _size)
+{
+	char *bytes = (char*)_data;
+
+	while ( _size > 0 )
+	{
+		int chunk = (int)std::min(_size, (size_t)(1 << 30));
+		int received = (int)recv((SOCKET)m_handle, bytes, chunk, 0);
+
+		if ( received <= 0 )   // 0 is the other end closing the connection
+		{
+			return false;
+		}
+
+		bytes += received;
+		_size -= received;
+	}
+
+	return true;
+}
+
+void Socket::setTimeout(int _milliseconds)
+{
+#ifdef _WIN32
+	DWORD timeout = (DWORD)_milliseconds;
+#else
+	timeval timeout;
+	timeout.tv_sec = _milliseconds / 1000;
+	timeout.tv_usec = (_milliseconds % 1000) * 1000;
+#endif
+
+	setsockopt((SOCKET)m_handle, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+	setsockopt((SOCKET)m_handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+int Socket::WaitForData(int _milliseconds)
+{
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET((SOCKET)m_handle, &readable);
+
+	timeval timeout;
+	timeout.tv_sec = _milliseconds / 1000;
+	timeout.tv_usec = (_milliseconds % 1000) * 1000;
+
+	int ready = select((int)(m_handle + 1), &readable, nullptr, nullptr, &timeout);   // The first argument is ignored by Winsock
+
+	return ready < 0 ? -1 : ready > 0 ? 1 : 0;
+}
+
+bool Socket::Send(unsigned int _type, const std::vector<unsigned char> &_payload)
+{
+	unsigned char header[8];
+	PutLittleEndian(header, _type);
+	PutLittleEndian(header + 4, (unsigned int)_payload.size());
+
+	return SendAll(header, sizeof(header)) && (_payload.empty() || SendAll(_payload.data(), _payload.size()));
+}
+
+bool Socket::Receive(unsigned int *_type, std::vector<unsigned char> *_payload)
+{
+	unsigned char header[8];
+
+	if ( !ReceiveAll(header, sizeof(header)) )
+	{
+		return false;
+	}
+
+	unsigned int size = GetLittleEndian(header + 4);
+
+	if ( size > SOCKET_MAX_MESSAGE )
+	{
+		return false;
+	}
+
+	*_type = GetLittleEndian(header);
+	_payload->resize(size);
+
+	return size == 0 || ReceiveAll(_payload->data(), size);
+}
+
+void Socket::Close()
+{
+	if ( m_handle != -1 )
+	{
+		CloseSocket((SOCKET)m_handle);
+		m_handle = -1;
+	}
+}
+
+int Socket::getPort()
+{
+	sockaddr_in address = {};
+	SocketLength length = sizeof(address);
+
+	if ( getsockname((SOCKET)m_handle, (sockaddr*)&address, &length) != 0 )
+	{
+		return 0;
+	}
+
+	return ntohs(address.sin_port);
+}
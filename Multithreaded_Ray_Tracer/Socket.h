@@ -0,0 +1,59 @@
+/// \file Socket.h
+/// \brief Class for the 'Socket' which wraps a blocking TCP connection, Winsock on Windows and BSD sockets everywhere else
+/// \author Thomas Hardy
+
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <string>
+#include <vector>
+
+#define SOCKET_MAX_MESSAGE (256 * 1024 * 1024)   // Macro for the largest message Receive accepts, anything bigger is taken as a broken stream
+
+class Socket
+{
+public:
+
+	Socket();
+
+	~Socket();
+
+	Socket(Socket &&_other);
+	Socket& operator=(Socket &&_other);
+
+	Socket(const Socket&) = delete;   // Two copies would both close the one connection
+	Socket& operator=(const Socket&) = delete;
+
+	static bool Startup();   // Call once before any socket is made, starts Winsock on Windows and stops a closed connection raising SIGPIPE elsewhere
+
+	bool Listen(int _port);   // On every address, 0 lets the OS pick a free port
+
+	bool Accept(Socket *_connection);   // Waits for the next connection, use WaitForData first to wait with a timeout
+
+	bool Connect(const std::string &_host, int _port);
+
+	bool SendAll(const void *_data, size_t _size);
+
+	bool ReceiveAll(void *_data, size_t _size);   // False if the connection closes before _size bytes arrive
+
+	void setTimeout(int _milliseconds);   // Longest a send or receive can wait without any progress before it fails, so a stalled peer can't hang the caller
+
+	int WaitForData(int _milliseconds);   // 1 once there's something to read (or a connection to accept), 0 if the time ran out, -1 if the socket failed
+
+	// Messages are an 8 byte header, the type then the payload length as little endian 32 bit numbers, then the payload
+
+	bool Send(unsigned int _type, const std::vector<unsigned char> &_payload);
+
+	bool Receive(unsigned int *_type, std::vector<unsigned char> *_payload);
+
+	void Close();
+
+	bool isOpen() { return m_handle != -1; }
+
+	int getPort();   // The local port, for a listening socket made with port 0
+
+private:
+
+	long long m_handle;   // A SOCKET on Windows and a file descriptor elsewhere, both fit and both use -1 (INVALID_SOCKET) for none
+};
+#endif
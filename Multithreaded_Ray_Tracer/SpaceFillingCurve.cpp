@@ -0,0 +1,133 @@
+/// @file SpaceFillingCurve.cpp
+/// @brief Contains the Morton and Hilbert curve functions
+/// Both work on coordinates up to 16 bits, far past any tile grid or tile
+
+#include "SpaceFillingCurve.h"
+
+namespace
+{
+	unsigned int SpreadBits(unsigned int _value)   // Puts a zero bit between each of the low 16 bits
+	{
+		_value &= 0x0000ffff;
+		_value = (_value | (_value << 8)) & 0x00ff00ff;
+		_value = (_value | (_value << 4)) & 0x0f0f0f0f;
+		_value = (_value | (_value << 2)) & 0x33333333;
+		_value = (_value | (_value << 1)) & 0x55555555;
+
+		return _value;
+	}
+
+	unsigned int CompactBits(unsigned int _value)   // Undoes SpreadBits on every other bit
+	{
+		_value &= 0x55555555;
+		_value = (_value | (_value >> 1)) & 0x33333333;
+		_value = (_value | (_value >> 2)) & 0x0f0f0f0f;
+		_value = (_value | (_value >> 4)) & 0x00ff00ff;
+		_value = (_value | (_value >> 8)) & 0x0000ffff;
+
+		return _value;
+	}
+
+	void HilbertRotate(unsigned int _size, unsigned int *_x, unsigned int *_y, unsigned int _quadrantX, unsigned int _quadrantY)   // Flips the quadrant so the sub-curve joins up with its neighbours
+	{
+		if ( _quadrantY == 0 )
+		{
+			if ( _quadrantX == 1 )
+			{
+				*_x = _size - 1 - *_x;
+				*_y = _size - 1 - *_y;
+			}
+
+			unsigned int swap = *_x;
+			*_x = *_y;
+			*_y = swap;
+		}
+	}
+}
+
+unsigned int CurveSide(int _width, int _height)
+{
+	unsigned int side = 1;
+
+	while ( side < (unsigned int)_width || side < (unsigned int)_height )
+	{
+		side <<= 1;
+	}
+
+	return side;
+}
+
+unsigned int CurveIndex(CurveOrder _order, unsigned int _side, unsigned int _x, unsigned int _y)
+{
+	switch (_order)
+	{
+	case ORDER_MORTON:
+		return SpreadBits(_x) | (SpreadBits(_y) << 1);
+	case ORDER_HILBERT:
+	{
+		unsigned int index = 0;
+
+		for ( unsigned int size = _side / 2; size > 0; size /= 2 )   // One quadrant per level, biggest first
+		{
+			unsigned int quadrantX = (_x & size) > 0;
+			unsigned int quadrantY = (_y & size) > 0;
+
+			index += size * size * ((3 * quadrantX) ^ quadrantY);
+			HilbertRotate(_side, &_x, &_y, quadrantX, quadrantY);
+		}
+
+		return index;
+	}
+	default:
+		return _y * _side + _x;
+	}
+}
+
+void CurvePoint(CurveOrder _order, unsigned int _side, unsigned int _index, unsigned int *_x, unsigned int *_y)
+{
+	switch (_order)
+	{
+	case ORDER_MORTON:
+		*_x = CompactBits(_index);
+		*_y = CompactBits(_index >> 1);
+		break;
+	case ORDER_HILBERT:
+	{
+		unsigned int x = 0;
+		unsigned int y = 0;
+
+		for ( unsigned int size = 1; size < _side; size *= 2 )   // Built back up from the smallest quadrant
+		{
+			unsigned int quadrantX = 1 & (_index / 2);
+			unsigned int quadrantY = 1 & (_index ^ quadrantX);
+
+			HilbertRotate(size, &x, &y, quadrantX, quadrantY);
+
+			x += size * quadrantX;
+			y += size * quadrantY;
+			_index /= 4;
+		}
+
+		*_x = x;
+		*_y = y;
+		break;
+	}
+	default:
+		*_x = _index % _side;
+		*_y = _index / _side;
+		break;
+	}
+}
+
+const char* CurveName(CurveOrder _order)
+{
+	switch (_order)
+	{
+	case ORDER_MORTON:
+		return "Morton";
+	case ORDER_HILBERT:
+		return "Hilbert";
+	default:
+		return "scanline";
+	}
+}
@@ -0,0 +1,22 @@
+/// \file SpaceFillingCurve.h
+/// \brief Functions for walking a grid along a Morton or Hilbert curve, so cells that are visited one after another are also close together
+/// \author Thomas Hardy
+
+#ifndef SPACEFILLINGCURVE_H
+#define SPACEFILLINGCURVE_H
+
+enum CurveOrder
+{
+	ORDER_SCANLINE,   // Row by row, left to right
+	ORDER_MORTON,   // Z order, bits of x and y interleaved. Cheap, but jumps at the edge of every power of two block
+	ORDER_HILBERT   // Every step moves to a neighbouring cell
+};
+
+unsigned int CurveSide(int _width, int _height);   // The power of two square a _width by _height grid is walked inside, cells outside the grid are skipped
+
+unsigned int CurveIndex(CurveOrder _order, unsigned int _side, unsigned int _x, unsigned int _y);   // Position of cell (x, y) along the curve, _side from CurveSide
+
+void CurvePoint(CurveOrder _order, unsigned int _side, unsigned int _index, unsigned int *_x, unsigned int *_y);   // The cell at that position, the opposite of CurveIndex
+
+const char* CurveName(CurveOrder _order);
+#endif
@@ -52,8 +52,26 @@ bool Sphere::Intersection(glm::vec3 rayOrigin, glm::vec3 rayDirection, float *t)
 
 glm::vec3 Sphere::CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour)
 {
-	*shininess = 64;
-	*diffuseColour = getColour();
-	*specularColour = glm::vec3(0.7, 0.7, 0.7);
-	return (_p0 - getPosition());
+	SurfacePoint surface = Surface(_p0);
+	*shininess = surface.shininess;
+	*diffuseColour = surface.diffuseColour;
+	*specularColour = surface.specularColour;
+	return surface.normal;
 }
+
+SurfacePoint Sphere::Surface(glm::vec3 _p0)
+{
+	SurfacePoint surface;
+	surface.shininess = 64;
+	surface.diffuseColour = getColour();
+	surface.specularColour = glm::vec3(0.7, 0.7, 0.7);
+	surface.normal = _p0 - getPosition();
+	return surface;
+}
+
+bool Sphere::GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax)
+{
+	*_boundsMin = getPosition() - glm::vec3(m_radius);
+	*_boundsMax = getPosition() + glm::vec3(m_radius);
+	return true;
+}
\ No newline at end of file
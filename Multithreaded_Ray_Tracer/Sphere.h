@@ -9,7 +9,7 @@
 
 #include "Shape.h"
 
-class Sphere : public Shape
+class Sphere final : public Shape   // Final so calls on a Sphere the compiler can see skip the vtable
 {
 public:
 
@@ -21,6 +21,10 @@ public:
 
 	glm::vec3 CalculateNormal(glm::vec3 _p0, int *shininess, glm::vec3 *diffuseColour, glm::vec3 *specularColour);
 
+	SurfacePoint Surface(glm::vec3 _p0);
+
+	bool GetBounds(glm::vec3 *_boundsMin, glm::vec3 *_boundsMax);
+
 	float getRadius() { return m_radius; }
 	void setRadius( float _radius ) { m_radius = _radius; }
 
@@ -0,0 +1,354 @@
+/// @file SphereSoA.cpp
+/// @brief Contains the scalar and SIMD ray-sphere kernels for the structure of arrays sphere store
+/// Uses the same geometric test as Sphere::Intersection, with the reject done on s^2 against r^2 so no lane needs a sqrt to be thrown away
+
+#include <cmath>
+
+#include "SphereSoA.h"   // Included first as it decides which kernel is compiled
+
+#if SPHERE_SIMD_WIDTH > 1
+
+#include <immintrin.h>
+
+namespace
+{
+	// Picks the nearest lane, ties go to the lower index so the result matches a front to back scalar scan
+
+	bool ReduceLanes(const float *_laneT, const int *_laneIndex, int _laneCount, float *_t, int *_sphereHit)
+	{
+		float minT = INFINITY;
+		int sphereHit = -1;
+
+		for ( int i = 0; i < _laneCount; ++i )
+		{
+			if ( _laneIndex[i] != -1 && (_laneT[i] < minT || (_laneT[i] == minT && _laneIndex[i] < sphereHit)) )
+			{
+				minT = _laneT[i];
+				sphereHit = _laneIndex[i];
+			}
+		}
+
+		*_t = minT;
+		*_sphereHit = sphereHit;
+
+		return sphereHit != -1;
+	}
+}
+
+#endif
+
+SphereSoA::SphereSoA()
+{
+	Clear();
+}
+
+void SphereSoA::Clear()
+{
+	m_count = 0;
+	m_centreX.clear();
+	m_centreY.clear();
+	m_centreZ.clear();
+	m_radiusSquared.clear();
+
+	Pad();
+}
+
+int SphereSoA::Add(glm::vec3 _centre, float _radius)
+{
+	m_centreX.resize(m_count);   // Drop the padding, it goes back on the end afterwards
+	m_centreY.resize(m_count);
+	m_centreZ.resize(m_count);
+	m_radiusSquared.resize(m_count);
+
+	m_centreX.push_back(_centre.x);
+	m_centreY.push_back(_centre.y);
+	m_centreZ.push_back(_centre.z);
+	m_radiusSquared.push_back(_radius * _radius);
+
+	Pad();
+
+	return m_count++;
+}
+
+int SphereSoA::AddPlaceholder()
+{
+	int index = Add(glm::vec3(0, 0, 0), 0.0f);
+	m_radiusSquared[index] = -1.0f;
+
+	return index;
+}
+
+void SphereSoA::Pad()
+{
+	// A full width load starting at the last sphere has to stay inside the arrays
+
+	m_centreX.resize(m_count + SPHERE_SIMD_WIDTH, 0.0f);
+	m_centreY.resize(m_count + SPHERE_SIMD_WIDTH, 0.0f);
+	m_centreZ.resize(m_count + SPHERE_SIMD_WIDTH, 0.0f);
+	m_radiusSquared.resize(m_count + SPHERE_SIMD_WIDTH, -1.0f);
+}
+
+const char* SphereSoA::getKernelName()
+{
+#if SPHERE_SIMD_WIDTH == 8
+	return "AVX2 (8 spheres per step)";
+#elif SPHERE_SIMD_WIDTH == 4
+	return "SSE2 (4 spheres per step)";
+#else
+	return "Scalar (1 sphere per step)";
+#endif
+}
+
+bool SphereSoA::ClosestHitScalar(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit)
+{
+	float minT = INFINITY;
+	int sphereHit = -1;
+
+	for ( int i = _first; i < _first + _count; ++i )
+	{
+		glm::vec3 L = glm::vec3(m_centreX[i], m_centreY[i], m_centreZ[i]) - _rayOrigin;
+
+		float delta = dot(L, _rayDirection);
+		float s2 = dot(L, L) - (delta * delta);
+
+		if ( delta < 0 || s2 > m_radiusSquared[i] )   // There is no intersection
+		{
+			continue;
+		}
+
+		float thc = sqrt(m_radiusSquared[i] - s2);   // Rounded to float before the subtraction, like Sphere::Intersection
+		float t0 = delta - thc;
+
+		if ( t0 < minT )
+		{
+			minT = t0;
+			sphereHit = i;
+		}
+	}
+
+	*_t = minT;
+	*_sphereHit = sphereHit;
+
+	return sphereHit != -1;
+}
+
+#if SPHERE_SIMD_WIDTH == 8
+
+bool SphereSoA::ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit)
+{
+	const __m256 originX = _mm256_set1_ps(_rayOrigin.x);
+	const __m256 originY = _mm256_set1_ps(_rayOrigin.y);
+	const __m256 originZ = _mm256_set1_ps(_rayOrigin.z);
+	const __m256 directionX = _mm256_set1_ps(_rayDirection.x);
+	const __m256 directionY = _mm256_set1_ps(_rayDirection.y);
+	const __m256 directionZ = _mm256_set1_ps(_rayDirection.z);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i end = _mm256_set1_epi32(_first + _count);
+	const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	__m256 bestT = _mm256_set1_ps(INFINITY);
+	__m256i bestIndex = _mm256_set1_epi32(-1);
+
+	for ( int i = _first; i < _first + _count; i += 8 )
+	{
+		__m256 lx = _mm256_sub_ps(_mm256_loadu_ps(&m_centreX[i]), originX);
+		__m256 ly = _mm256_sub_ps(_mm256_loadu_ps(&m_centreY[i]), originY);
+		__m256 lz = _mm256_sub_ps(_mm256_loadu_ps(&m_centreZ[i]), originZ);
+		__m256 radiusSquared = _mm256_loadu_ps(&m_radiusSquared[i]);
+
+		// Same order of operations as glm::dot, each multiply and add rounded on its own. A scalar build that fuses them into FMAs can differ in the last bit
+
+		__m256 delta = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, directionX), _mm256_mul_ps(ly, directionY)), _mm256_mul_ps(lz, directionZ));
+		__m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz));
+		__m256 s2 = _mm256_sub_ps(lengthSquared, _mm256_mul_ps(delta, delta));
+
+		__m256i index = _mm256_add_epi32(_mm256_set1_epi32(i), laneOffsets);
+		__m256 inRange = _mm256_castsi256_ps(_mm256_cmpgt_epi32(end, index));
+
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(delta, zero, _CMP_GE_OQ), _mm256_cmp_ps(s2, radiusSquared, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, inRange);
+
+		__m256 t0 = _mm256_sub_ps(delta, _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(radiusSquared, s2), zero)));
+		__m256 closer = _mm256_and_ps(hit, _mm256_cmp_ps(t0, bestT, _CMP_LT_OQ));
+
+		bestT = _mm256_blendv_ps(bestT, t0, closer);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), closer));
+	}
+
+	alignas(32) float laneT[8];
+	alignas(32) int laneIndex[8];
+
+	_mm256_store_ps(laneT, bestT);
+	_mm256_store_si256((__m256i*)laneIndex, bestIndex);
+
+	return ReduceLanes(laneT, laneIndex, 8, _t, _sphereHit);
+}
+
+bool SphereSoA::AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float _maxT)
+{
+	const __m256 originX = _mm256_set1_ps(_rayOrigin.x);
+	const __m256 originY = _mm256_set1_ps(_rayOrigin.y);
+	const __m256 originZ = _mm256_set1_ps(_rayOrigin.z);
+	const __m256 directionX = _mm256_set1_ps(_rayDirection.x);
+	const __m256 directionY = _mm256_set1_ps(_rayDirection.y);
+	const __m256 directionZ = _mm256_set1_ps(_rayDirection.z);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 maxT = _mm256_set1_ps(_maxT);
+	const __m256i end = _mm256_set1_epi32(_first + _count);
+	const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	for ( int i = _first; i < _first + _count; i += 8 )
+	{
+		__m256 lx = _mm256_sub_ps(_mm256_loadu_ps(&m_centreX[i]), originX);
+		__m256 ly = _mm256_sub_ps(_mm256_loadu_ps(&m_centreY[i]), originY);
+		__m256 lz = _mm256_sub_ps(_mm256_loadu_ps(&m_centreZ[i]), originZ);
+		__m256 radiusSquared = _mm256_loadu_ps(&m_radiusSquared[i]);
+
+		__m256 delta = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, directionX), _mm256_mul_ps(ly, directionY)), _mm256_mul_ps(lz, directionZ));
+		__m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz));
+		__m256 s2 = _mm256_sub_ps(lengthSquared, _mm256_mul_ps(delta, delta));
+
+		__m256i index = _mm256_add_epi32(_mm256_set1_epi32(i), laneOffsets);
+		__m256 inRange = _mm256_castsi256_ps(_mm256_cmpgt_epi32(end, index));
+
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(delta, zero, _CMP_GE_OQ), _mm256_cmp_ps(s2, radiusSquared, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, inRange);
+
+		__m256 t0 = _mm256_sub_ps(delta, _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(radiusSquared, s2), zero)));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(t0, maxT, _CMP_LT_OQ));
+
+		if ( _mm256_movemask_ps(hit) != 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#elif SPHERE_SIMD_WIDTH == 4
+
+namespace
+{
+	inline __m128 Select(__m128 _mask, __m128 _ifTrue, __m128 _ifFalse)   // SSE2 has no blend instruction
+	{
+		return _mm_or_ps(_mm_and_ps(_mask, _ifTrue), _mm_andnot_ps(_mask, _ifFalse));
+	}
+}
+
+bool SphereSoA::ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit)
+{
+	const __m128 originX = _mm_set1_ps(_rayOrigin.x);
+	const __m128 originY = _mm_set1_ps(_rayOrigin.y);
+	const __m128 originZ = _mm_set1_ps(_rayOrigin.z);
+	const __m128 directionX = _mm_set1_ps(_rayDirection.x);
+	const __m128 directionY = _mm_set1_ps(_rayDirection.y);
+	const __m128 directionZ = _mm_set1_ps(_rayDirection.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i end = _mm_set1_epi32(_first + _count);
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+	__m128 bestT = _mm_set1_ps(INFINITY);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+
+	for ( int i = _first; i < _first + _count; i += 4 )
+	{
+		__m128 lx = _mm_sub_ps(_mm_loadu_ps(&m_centreX[i]), originX);
+		__m128 ly = _mm_sub_ps(_mm_loadu_ps(&m_centreY[i]), originY);
+		__m128 lz = _mm_sub_ps(_mm_loadu_ps(&m_centreZ[i]), originZ);
+		__m128 radiusSquared = _mm_loadu_ps(&m_radiusSquared[i]);
+
+		// Same order of operations as glm::dot, each multiply and add rounded on its own. A scalar build that fuses them into FMAs can differ in the last bit
+
+		__m128 delta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, directionX), _mm_mul_ps(ly, directionY)), _mm_mul_ps(lz, directionZ));
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+		__m128 s2 = _mm_sub_ps(lengthSquared, _mm_mul_ps(delta, delta));
+
+		__m128i index = _mm_add_epi32(_mm_set1_epi32(i), laneOffsets);
+		__m128 inRange = _mm_castsi128_ps(_mm_cmplt_epi32(index, end));
+
+		__m128 hit = _mm_and_ps(_mm_cmpge_ps(delta, zero), _mm_cmple_ps(s2, radiusSquared));
+		hit = _mm_and_ps(hit, inRange);
+
+		__m128 t0 = _mm_sub_ps(delta, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSquared, s2), zero)));
+		__m128 closer = _mm_and_ps(hit, _mm_cmplt_ps(t0, bestT));
+
+		bestT = Select(closer, t0, bestT);
+		bestIndex = _mm_castps_si128(Select(closer, _mm_castsi128_ps(index), _mm_castsi128_ps(bestIndex)));
+	}
+
+	alignas(16) float laneT[4];
+	alignas(16) int laneIndex[4];
+
+	_mm_store_ps(laneT, bestT);
+	_mm_store_si128((__m128i*)laneIndex, bestIndex);
+
+	return ReduceLanes(laneT, laneIndex, 4, _t, _sphereHit);
+}
+
+bool SphereSoA::AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float _maxT)
+{
+	const __m128 originX = _mm_set1_ps(_rayOrigin.x);
+	const __m128 originY = _mm_set1_ps(_rayOrigin.y);
+	const __m128 originZ = _mm_set1_ps(_rayOrigin.z);
+	const __m128 directionX = _mm_set1_ps(_rayDirection.x);
+	const __m128 directionY = _mm_set1_ps(_rayDirection.y);
+	const __m128 directionZ = _mm_set1_ps(_rayDirection.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxT = _mm_set1_ps(_maxT);
+	const __m128i end = _mm_set1_epi32(_first + _count);
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+	for ( int i = _first; i < _first + _count; i += 4 )
+	{
+		__m128 lx = _mm_sub_ps(_mm_loadu_ps(&m_centreX[i]), originX);
+		__m128 ly = _mm_sub_ps(_mm_loadu_ps(&m_centreY[i]), originY);
+		__m128 lz = _mm_sub_ps(_mm_loadu_ps(&m_centreZ[i]), originZ);
+		__m128 radiusSquared = _mm_loadu_ps(&m_radiusSquared[i]);
+
+		__m128 delta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, directionX), _mm_mul_ps(ly, directionY)), _mm_mul_ps(lz, directionZ));
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+		__m128 s2 = _mm_sub_ps(lengthSquared, _mm_mul_ps(delta, delta));
+
+		__m128i index = _mm_add_epi32(_mm_set1_epi32(i), laneOffsets);
+		__m128 inRange = _mm_castsi128_ps(_mm_cmplt_epi32(index, end));
+
+		__m128 hit = _mm_and_ps(_mm_cmpge_ps(delta, zero), _mm_cmple_ps(s2, radiusSquared));
+		hit = _mm_and_ps(hit, inRange);
+
+		__m128 t0 = _mm_sub_ps(delta, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSquared, s2), zero)));
+		hit = _mm_and_ps(hit, _mm_cmplt_ps(t0, maxT));
+
+		if ( _mm_movemask_ps(hit) != 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#else
+
+bool SphereSoA::ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit)
+{
+	return ClosestHitScalar(_rayOrigin, _rayDirection, _first, _count, _t, _sphereHit);
+}
+
+bool SphereSoA::AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float _maxT)
+{
+	float t0 = 0.0f;
+	int sphereHit = -1;
+
+	for ( int i = _first; i < _first + _count; ++i )
+	{
+		if ( ClosestHitScalar(_rayOrigin, _rayDirection, i, 1, &t0, &sphereHit) && t0 < _maxT )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/// \file SphereSoA.h
+/// \brief Class for the 'SphereSoA' which stores spheres as separate arrays so several can be tested at once
+/// \author Thomas Hardy
+
+#ifndef SPHERESOA_H
+#define SPHERESOA_H
+
+#include <vector>
+#include <glm.hpp>
+
+#if defined(__AVX2__)
+#define SPHERE_SIMD_WIDTH (8)   // Macro for how many spheres one kernel step tests, AVX2 fits eight floats
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPHERE_SIMD_WIDTH (4)   // Macro for how many spheres one kernel step tests, SSE fits four floats
+#else
+#define SPHERE_SIMD_WIDTH (1)   // Macro for how many spheres one kernel step tests, no vector unit so the scalar loop is used
+#endif
+
+class SphereSoA
+{
+public:
+
+	SphereSoA();
+
+	void Clear();
+
+	int Add(glm::vec3 _centre, float _radius);   // Returns the index the sphere was stored at
+
+	int AddPlaceholder();   // Takes up an index but can never be hit, for slots that belong to another kind of shape
+
+	bool ClosestHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit);   // Nearest hit among [_first, _first + _count), the same t as Sphere::Intersection to within rounding
+
+	bool ClosestHitScalar(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float *_t, int *_sphereHit);   // One sphere at a time, used when there's no vector unit and to check the kernel
+
+	bool AnyHit(glm::vec3 _rayOrigin, glm::vec3 _rayDirection, int _first, int _count, float _maxT);   // True as soon as any sphere in the range is hit before _maxT
+
+	int getCount() { return m_count; }
+
+	glm::vec3 getCentre( int _index ) { return glm::vec3(m_centreX[_index], m_centreY[_index], m_centreZ[_index]); }
+
+	float getRadiusSquared( int _index ) { return m_radiusSquared[_index]; }
+
+	static const char* getKernelName();
+
+private:
+
+	void Pad();
+
+	// One array per component so a vector load picks up the same component of neighbouring spheres
+
+	std::vector<float> m_centreX;
+	std::vector<float> m_centreY;
+	std::vector<float> m_centreZ;
+	std::vector<float> m_radiusSquared;   // Placeholders hold -1 which no ray can get under
+
+	int m_count;
+};
+#endif
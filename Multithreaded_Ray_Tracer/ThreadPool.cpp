@@ -0,0 +1,162 @@
+/// @file ThreadPool.cpp
+/// @brief Contains functions for the persistent render thread pool
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace
+{
+	thread_local int t_currentWorker = -1;
+}
+
+ThreadPool::ThreadPool(int _threadCount)
+{
+	NumaTopology singleNode;
+
+	StartWorkers(_threadCount, singleNode);
+}
+
+ThreadPool::ThreadPool(int _threadCount, NumaTopology &_topology)
+{
+	StartWorkers(_threadCount, _topology);
+}
+
+void ThreadPool::StartWorkers(int _threadCount, NumaTopology &_topology)
+{
+	m_shuttingDown = false;
+	m_firstBatch = nullptr;
+	m_lastBatch = nullptr;
+
+	int threadCount = std::max(1, _threadCount);
+
+	m_nodeCount = std::min(_topology.getNodeCount(), threadCount);   // A node with no worker on it might as well not be there
+
+	for ( int i = 0; i < threadCount; ++i )
+	{
+		int node = i * m_nodeCount / threadCount;
+
+		m_workerNodes.push_back(node);
+		m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i, m_nodeCount > 1 ? _topology.getCpus(node) : std::vector<int>()));
+	}
+}
+
+int ThreadPool::CurrentWorker()
+{
+	return t_currentWorker;
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_shuttingDown = true;
+	}
+
+	m_jobAvailable.notify_all();
+
+	for ( size_t i = 0; i < m_workers.size(); ++i )
+	{
+		m_workers[i].join();
+	}
+}
+
+void ThreadPool::ParallelRun(int _jobCount, const std::function<void(int)> &_job)
+{
+	if ( _jobCount <= 0 )
+	{
+		return;
+	}
+
+	Batch batch;
+	batch.job = &_job;
+	batch.jobCount = _jobCount;
+	batch.nextJob = 0;
+	batch.unfinishedJobs = _jobCount;
+	batch.next = nullptr;
+
+	std::unique_lock<std::mutex> guard(m_lock);
+
+	if ( m_lastBatch != nullptr )
+	{
+		m_lastBatch->next = &batch;
+	}
+	else
+	{
+		m_firstBatch = &batch;
+	}
+
+	m_lastBatch = &batch;
+
+	m_jobAvailable.notify_all();
+
+	m_batchFinished.wait(guard, [&batch]() { return batch.unfinishedJobs == 0; });   // Every job has to finish before _job goes out of scope, even if one of them threw
+
+	if ( batch.error )
+	{
+		std::rethrow_exception(batch.error);
+	}
+}
+
+void ThreadPool::RunBatchJob(Batch *_batch, int _index, std::unique_lock<std::mutex> &_guard)
+{
+	_guard.unlock();
+
+	std::exception_ptr error;
+
+	try
+	{
+		(*_batch->job)(_index);
+	}
+	catch ( ... )
+	{
+		error = std::current_exception();
+	}
+
+	_guard.lock();
+
+	if ( error && !_batch->error )
+	{
+		_batch->error = error;
+	}
+
+	if ( --_batch->unfinishedJobs == 0 )
+	{
+		m_batchFinished.notify_all();   // Several callers can be waiting on their own batches
+	}
+}
+
+void ThreadPool::WorkerLoop(int _worker, std::vector<int> _cpus)
+{
+	t_currentWorker = _worker;
+
+	NumaTopology::PinCurrentThread(_cpus);   // Before the first job, so everything the worker touches first lands on its node
+
+	std::unique_lock<std::mutex> guard(m_lock);
+
+	while ( true )
+	{
+		m_jobAvailable.wait(guard, [this]() { return m_shuttingDown || m_firstBatch != nullptr; });   // Parks the worker until there is something to do
+
+		if ( m_firstBatch != nullptr )
+		{
+			Batch *batch = m_firstBatch;
+			int index = batch->nextJob++;
+
+			if ( batch->nextJob == batch->jobCount )   // Its last index is handed out, the caller keeps it alive until the jobs finish
+			{
+				m_firstBatch = batch->next;
+
+				if ( m_firstBatch == nullptr )
+				{
+					m_lastBatch = nullptr;
+				}
+			}
+
+			RunBatchJob(batch, index, guard);
+			continue;
+		}
+
+		return;   // Only woken with no batch left when shutting down
+	}
+}
@@ -0,0 +1,67 @@
+/// \file ThreadPool.h
+/// \brief Class for the 'ThreadPool' which keeps render threads alive between frames
+/// \author Thomas Hardy
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "NumaTopology.h"
+
+class ThreadPool
+{
+public:
+
+	ThreadPool(int _threadCount);
+
+	ThreadPool(int _threadCount, NumaTopology &_topology);   // Workers are shared out over the nodes in blocks and pinned to their node's CPUs, with one node nothing is pinned
+
+	~ThreadPool();
+
+	void ParallelRun(int _jobCount, const std::function<void(int)> &_job);   // Runs _job once for each index up to _jobCount and blocks until they have all returned, without allocating
+
+	int getThreadCount() { return (int)m_workers.size(); }
+
+	int getNodeCount() { return m_nodeCount; }
+
+	int getWorkerNode( int _worker ) { return m_workerNodes[_worker]; }   // Workers on one node have neighbouring indices
+
+	static int CurrentWorker();   // Index of the pool worker calling it, -1 on any other thread
+
+private:
+
+	struct Batch   // One ParallelRun call, lives on the caller's stack so handing out its indices allocates nothing
+	{
+		const std::function<void(int)> *job;
+		int jobCount;
+		int nextJob;   // Next index to hand out
+		int unfinishedJobs;
+		std::exception_ptr error;   // The first thing a job threw
+		Batch *next;   // Batches are queued in the order they were started
+	};
+
+	void StartWorkers(int _threadCount, NumaTopology &_topology);
+
+	void WorkerLoop(int _worker, std::vector<int> _cpus);   // _cpus empty leaves the thread wherever the OS puts it
+
+	void RunBatchJob(Batch *_batch, int _index, std::unique_lock<std::mutex> &_guard);   // Called and returns with the lock held
+
+	std::vector<std::thread> m_workers;
+	std::vector<int> m_workerNodes;
+	int m_nodeCount;
+
+	Batch *m_firstBatch;   // Batches with indices left to hand out
+	Batch *m_lastBatch;
+	std::condition_variable m_batchFinished;
+
+	std::mutex m_lock;
+	std::condition_variable m_jobAvailable;
+	bool m_shuttingDown;
+};
+#endif
@@ -0,0 +1,189 @@
+/// @file TileScheduler.cpp
+/// @brief Contains functions for the work stealing tile scheduler
+
+#include <algorithm>
+
+#include "TileScheduler.h"
+
+TileScheduler::TileScheduler(ThreadPool &_pool, int _tileSize) : m_pool(_pool)
+{
+	m_threadCount = _pool.getThreadCount();
+	m_tileSize = std::max(1, _tileSize);
+	m_runSeconds = 0.0;
+	m_workerBusySeconds.assign(m_threadCount, 0.0);
+	m_frameWidth = 0;
+	m_frameHeight = 0;
+	m_frameTileSize = 0;
+	m_frameOrder = ORDER_SCANLINE;
+
+	for ( int i = 0; i < m_threadCount; ++i )
+	{
+		m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+}
+
+std::vector<Tile> TileScheduler::MakeTiles(int _width, int _height, int _tileSize, CurveOrder _order)
+{
+	std::vector<Tile> tiles;
+	std::vector<unsigned int> curveIndices;
+
+	unsigned int side = CurveSide((_width + _tileSize - 1) / _tileSize, (_height + _tileSize - 1) / _tileSize);
+
+	for ( int y = 0; y < _height; y += _tileSize )
+	{
+		for ( int x = 0; x < _width; x += _tileSize )
+		{
+			Tile tile;
+			tile.minX = x;
+			tile.maxX = std::min(x + _tileSize, _width);
+			tile.minY = y;
+			tile.maxY = std::min(y + _tileSize, _height);
+			tile.index = (int)tiles.size();
+			tiles.push_back(tile);
+
+			curveIndices.push_back(CurveIndex(_order, side, x / _tileSize, y / _tileSize));
+		}
+	}
+
+	if ( _order != ORDER_SCANLINE )
+	{
+		// Each worker's starting run then covers a compact patch of the frame rather than a strip, so its rays keep meeting the same part of the scene
+
+		std::sort(tiles.begin(), tiles.end(), [&curveIndices](const Tile &_a, const Tile &_b)
+		{
+			return curveIndices[_a.index] < curveIndices[_b.index];
+		});
+	}
+
+	return tiles;
+}
+
+const std::vector<Tile>& TileScheduler::getFrameTiles(int _width, int _height, CurveOrder _order)
+{
+	if ( _width != m_frameWidth || _height != m_frameHeight || m_tileSize != m_frameTileSize || _order != m_frameOrder )
+	{
+		m_frameTiles = MakeTiles(_width, _height, m_tileSize, _order);
+		m_frameWidth = _width;
+		m_frameHeight = _height;
+		m_frameTileSize = m_tileSize;
+		m_frameOrder = _order;
+	}
+
+	return m_frameTiles;
+}
+
+void TileScheduler::Run(int _width, int _height, const std::function<void(const Tile&)> &_tileFunction)
+{
+	Run(getFrameTiles(_width, _height), _tileFunction);
+}
+
+void TileScheduler::Run(const std::vector<Tile> &_tiles, const std::function<void(const Tile&)> &_tileFunction)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if ( &_tiles != &m_tiles )
+	{
+		m_tiles.assign(_tiles.begin(), _tiles.end());   // Reuses the space from the last run
+	}
+
+	TileTiming unrun;
+	unrun.worker = -1;
+	unrun.owner = -1;
+	unrun.seconds = 0.0;
+	m_tileTimings.assign(m_tiles.size(), unrun);
+
+	m_workerBusySeconds.assign(m_threadCount, 0.0);
+
+	// Each worker starts with one contiguous run of tiles so neighbouring rays stay on the same core, stealing evens out the rest.
+	// The pool gives each node a block of neighbouring workers, so each node starts with a band of rows too, the same band every frame
+
+	for ( int i = 0; i < m_threadCount; ++i )
+	{
+		m_queues[i]->front = (int)(m_tiles.size() * i / m_threadCount);
+		m_queues[i]->back = (int)(m_tiles.size() * (i + 1) / m_threadCount);
+
+		for ( int tile = m_queues[i]->front; tile < m_queues[i]->back; ++tile )
+		{
+			m_tileTimings[tile].owner = i;
+		}
+	}
+
+	m_pool.ParallelRun(m_threadCount, [this, &_tileFunction](int _job)   // One job per pool thread, each starting on its own queue. Two pointers fit inside the std::function
+	{
+		int worker = ThreadPool::CurrentWorker();   // The queue has to be the one for the thread's node, whichever job it picked up
+
+		WorkerLoop(worker >= 0 ? worker : _job, _tileFunction);
+	});
+
+	m_runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TileScheduler::WorkerLoop(int _worker, const std::function<void(const Tile&)> &_tileFunction)
+{
+	int tile = 0;
+	double busySeconds = 0.0;
+
+	// No tiles are added once a frame has started, so a failed steal from every other queue means the frame is finished
+
+	while ( PopLocal(_worker, &tile) || Steal(_worker, &tile) )
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		_tileFunction(m_tiles[tile]);
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();   // Two clock reads per tile, tiny next to the rays in it
+
+		m_tileTimings[tile].worker = _worker;
+		m_tileTimings[tile].seconds = seconds;
+		busySeconds += seconds;
+	}
+
+	m_workerBusySeconds[_worker] += busySeconds;   // A worker that picked up two of the jobs finds its queue empty the second time
+}
+
+bool TileScheduler::PopLocal(int _worker, int *_tile)
+{
+	WorkerQueue &queue = *m_queues[_worker];
+	std::lock_guard<std::mutex> guard(queue.lock);
+
+	if ( queue.front == queue.back )
+	{
+		return false;
+	}
+
+	*_tile = queue.front++;   // Owners work forwards through their run of tiles
+
+	return true;
+}
+
+bool TileScheduler::Steal(int _worker, int *_tile)
+{
+	// Queues on the thief's own node first, their tiles' pixels were first written there. Only then across to another node
+
+	int node = m_pool.getWorkerNode(_worker);
+
+	for ( int pass = 0; pass < 2; ++pass )
+	{
+		for ( int i = 1; i < m_threadCount; ++i )   // Visit the other queues starting with the next worker along so thieves spread out
+		{
+			int victimWorker = (_worker + i) % m_threadCount;
+
+			if ( (m_pool.getWorkerNode(victimWorker) == node) != (pass == 0) )
+			{
+				continue;
+			}
+
+			WorkerQueue &victim = *m_queues[victimWorker];
+			std::lock_guard<std::mutex> guard(victim.lock);
+
+			if ( victim.front != victim.back )
+			{
+				*_tile = --victim.back;   // Thieves take from the far end so they don't fight the owner for the same tiles
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,97 @@
+/// \file TileScheduler.h
+/// \brief Class for the 'TileScheduler' which splits the frame into tiles and shares them between threads
+/// \author Thomas Hardy
+
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "SpaceFillingCurve.h"
+
+struct Tile
+{
+	int minX;
+	int maxX;
+	int minY;
+	int maxY;
+	int index;   // Position in row order over the whole frame whatever order the tiles are run in, the same tile gets the same index every run over the same frame size
+};
+
+struct TileTiming
+{
+	int worker;   // Which worker ran the tile
+	int owner;   // Which worker's queue it started in, the same as worker unless it was stolen
+	double seconds;
+};
+
+class TileScheduler
+{
+public:
+
+	TileScheduler(ThreadPool &_pool, int _tileSize);
+
+	static std::vector<Tile> MakeTiles(int _width, int _height, int _tileSize, CurveOrder _order = ORDER_SCANLINE);   // Cuts the frame into tiles, clamping the last row and column to the frame edge, and puts them in _order
+
+	const std::vector<Tile>& getFrameTiles(int _width, int _height, CurveOrder _order = ORDER_SCANLINE);   // MakeTiles for the whole frame, kept and only cut again when the frame, tile size or order changes
+
+	// Once a run over as many tiles has been done, running again allocates nothing. Pass lambdas in with std::ref so the std::function doesn't allocate either
+
+	void Run(int _width, int _height, const std::function<void(const Tile&)> &_tileFunction);   // Blocks until every tile of the frame has been passed to _tileFunction
+
+	void Run(const std::vector<Tile> &_tiles, const std::function<void(const Tile&)> &_tileFunction);   // Same for any set of tiles, such as the ones a scene change touched
+
+	int getThreadCount() { return m_threadCount; }
+
+	int getTileSize() { return m_tileSize; }
+	void setTileSize( int _tileSize ) { m_tileSize = _tileSize; }
+
+	// Timings of the last call to Run, all wall clock
+
+	double getRunSeconds() { return m_runSeconds; }
+
+	const std::vector<Tile>& getTiles() { return m_tiles; }
+
+	const std::vector<TileTiming>& getTileTimings() { return m_tileTimings; }   // Indexed the same as getTiles, not by Tile::index
+
+	const std::vector<double>& getWorkerBusySeconds() { return m_workerBusySeconds; }   // Time each worker spent inside the tile function, the rest of the run it was stealing or waiting
+
+private:
+
+	struct WorkerQueue   // No tiles are added once a run starts, so a queue is just what's left of the worker's run of positions in m_tiles
+	{
+		std::mutex lock;
+		int front;   // The owner takes from here
+		int back;   // One past the last, thieves take from here
+	};
+
+	void WorkerLoop(int _worker, const std::function<void(const Tile&)> &_tileFunction);
+
+	bool PopLocal(int _worker, int *_tile);
+
+	bool Steal(int _worker, int *_tile);
+
+	ThreadPool &m_pool;
+
+	int m_threadCount;
+	int m_tileSize;
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+	std::vector<Tile> m_frameTiles;
+	int m_frameWidth;
+	int m_frameHeight;
+	int m_frameTileSize;
+	CurveOrder m_frameOrder;
+
+	double m_runSeconds;
+	std::vector<Tile> m_tiles;
+	std::vector<TileTiming> m_tileTimings;   // Each tile is only written by the worker that ran it
+	std::vector<double> m_workerBusySeconds;   // Each worker writes its own once it runs out of tiles
+};
+#endif
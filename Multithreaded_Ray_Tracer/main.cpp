@@ -10,62 +10,133 @@
 #include <math.h>   // Allows for the use of dot/cross product functions
 #include <ppl.h>   // Allows for the use of parallel for loops
 #include <thread>   // Allows for the use threads
-#include <ctime>   // Allows for the use of the clock function
+#include <chrono>   // Allows for the use of the wall clock timers
+#include <string>   // Allows for the use of strings
+#include <atomic>   // Allows for the use of atomic flags
+#include <functional>   // Allows for the use of function objects
+#include <cstring>   // Allows for the use of C string comparisons
 
 #include "Sphere.h"   // Sphere class include
 #include "Plane.h"   // Plane class include
 #include "Shape.h"   // Shape class include
-#include "Ray.h"   // Ray class include
+#include "Scene.h"   // Scene class include
+#include "BVH.h"   // Bounding volume hierarchy class include
+#include "RenderSettings.h"   // Render settings struct include
+#include "HitBuffer.h"   // Hit buffer class include
+#include "Framebuffer.h"   // Framebuffer class include
+#include "MappedPPM.h"   // Memory mapped PPM file class include
+#include "PNGWriter.h"   // PNG writer include
+#include "Benchmark.h"   // Benchmark functions include
+#include "ThreadPool.h"   // Thread pool class include
+#include "NumaTopology.h"   // NUMA node topology class include
+#include "TileScheduler.h"   // Tile scheduler class include
+#include "Renderer.h"   // Render pass functions include
+#include "RenderStats.h"   // Render statistics class include
+#include "Preview.h"   // Live preview window class include
+#include "Sequence.h"   // Animated sequence functions include
+#include "RenderFarm.h"   // Render farm coordinator and worker functions include
+#include "Checkpoint.h"   // Tile checkpoint class include
 
 #define WINDOW_WIDTH (800)   // Macro for window width
 #define WINDOW_HEIGHT (800)   // Macro for window height
+#define IMAGE_PATH ("../RayTracingImage.ppm")   // Macro for where the image is saved
+#define PNG_IMAGE_PATH ("../RayTracingImage.png")   // Macro for where the image is saved as a PNG
+#define REPORT_PATH ("../RenderReport.json")   // Macro for where the timing report is saved
+#define CHECKPOINT_PATH ("../RayTracingImage.checkpoint")   // Macro for where finished tiles are kept until the image is saved
 
-void GameLoop(int _threadChoice);
+void StartRender();
 
-std::vector<std::shared_ptr<Shape>> CreateShapes(std::vector<std::shared_ptr<Shape>> _shapeVector);
+void StartSequence();
 
-glm::vec3** DrawPixel(int _minX, int _maxX, int _minY, int _maxY, std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image);
+void StartFarm(const std::string &_program);
 
-void CreateAndJoinThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image, int _threadChoice);
+void StartFarmWorker();
 
-void OutputImage(glm::vec3 **_image);
+void ChooseCamera(RenderSettings &_settings);
 
-void UseOneThread(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image);
+void GameLoop(ThreadPool &_pool, const RenderSettings &_settings, int _frameCount);
 
-void UseFourThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image);
-
-void UseSixteenThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image);
-
-void UseSixtyFourThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image);
-
-int main()
+int main(int argc, char *argv[])
 {
+	if ( argc >= 5 && strcmp(argv[1], "--farm-worker") == 0 )   // How the coordinator starts its local workers: --farm-worker host port threads
+	{
+		return RunFarmWorker(argv[2], atoi(argv[3]), atoi(argv[4])) ? 0 : 1;
+	}
+
 	std::cout << "Welcome to Tom Hardy's Multi-Threaded Ray Tracer" << std::endl;
 	std::cout << "\n" << std::endl;
 
-	int threadChoice = 0;
-
-	std::cout << "How many threads would you like to run on? 1, 4, 16 or 64" << std::endl;
+	int modeChoice = 0;
+
+	std::cout << "What would you like to do?" << std::endl;
+	std::cout << "1. Render the scene" << std::endl;
+	std::cout << "2. Benchmark the BVH against a linear scan" << std::endl;
+	std::cout << "3. Check and benchmark the SIMD sphere kernel" << std::endl;
+	std::cout << "4. Check and benchmark ray packets against single rays" << std::endl;
+	std::cout << "5. Benchmark the render kernels on their own" << std::endl;
+	std::cout << "6. Sweep thread counts and tile sizes" << std::endl;
+	std::cout << "7. Check and benchmark instanced geometry" << std::endl;
+	std::cout << "8. Re-render only the tiles a moved sphere touches" << std::endl;
+	std::cout << "9. Render an animated sequence, one image per frame" << std::endl;
+	std::cout << "10. Check a frame makes no heap allocations" << std::endl;
+	std::cout << "11. Compare pinning render threads to NUMA nodes against leaving them unpinned" << std::endl;
+	std::cout << "12. Compare scanline, Morton and Hilbert tile and pixel orders" << std::endl;
+	std::cout << "13. Render the scene across a render farm, as its coordinator" << std::endl;
+	std::cout << "14. Join a render farm as a worker" << std::endl;
+	std::cout << "15. Check a render resumed from a checkpoint matches one left to finish, and time the checkpointing" << std::endl;
 	std::cout << "\n" << std::endl;
-	std::cin >> threadChoice;
+	std::cin >> modeChoice;
 	std::cout << "\n" << std::endl;
 
-	switch (threadChoice)
+	switch (modeChoice)
 	{
 	case 1:
-		GameLoop(threadChoice);
+		StartRender();
+		break;
+	case 2:
+		BenchmarkBVH();
+		break;
+	case 3:
+		BenchmarkSphereKernel();
 		break;
 	case 4:
-		GameLoop(threadChoice);
+		BenchmarkRayPackets();
+		break;
+	case 5:
+		BenchmarkKernels();
+		break;
+	case 6:
+		BenchmarkThreadScaling();
+		break;
+	case 7:
+		BenchmarkInstancing();
+		break;
+	case 8:
+		BenchmarkDirtyTiles();
+		break;
+	case 9:
+		StartSequence();
+		break;
+	case 10:
+		BenchmarkAllocations();
+		break;
+	case 11:
+		BenchmarkNuma();
 		break;
-	case 16:
-		GameLoop(threadChoice);
+	case 12:
+		BenchmarkTraversalOrder();
 		break;
-	case 64:
-		GameLoop(threadChoice);
+	case 13:
+		StartFarm(argv[0]);
+		break;
+	case 14:
+		StartFarmWorker();
+		break;
+	case 15:
+		BenchmarkCheckpoint();
 		break;
 	default:
-		std::cout << "Incorrect amount of threads chosen. Shutting down" << std::endl;
+		std::cout << "Incorrect option chosen. Shutting down" << std::endl;
 		std::cout << "\n" << std::endl;
 		break;
 	}
@@ -75,335 +146,583 @@ int main()
 	return 0;
 }
 
-void GameLoop(int _threadChoice)
+void StartRender()
 {
-	std::clock_t startTimer = clock();
+	int threadChoice = 0;
+	int threadsAvailable = std::max(1, (int)std::thread::hardware_concurrency());   // Can report 0 if the core count is unknown
+
+	std::cout << "How many threads would you like to run on? (This PC has " << threadsAvailable << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> threadChoice;
+	std::cout << "\n" << std::endl;
+
+	if ( threadChoice > 0 )
+	{
+		int frameChoice = 0;
+
+		std::cout << "How many frames would you like to render?" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> frameChoice;
+		std::cout << "\n" << std::endl;
+
+		RenderSettings settings;
+
+		std::cout << "What resolution would you like? Width then height, 0 0 for " << WINDOW_WIDTH << " " << WINDOW_HEIGHT << ", each up to " << RENDER_MAX_SIZE << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> settings.width >> settings.height;
+		std::cout << "\n" << std::endl;
+
+		if ( settings.width <= 0 || settings.height <= 0 )
+		{
+			settings.width = WINDOW_WIDTH;
+			settings.height = WINDOW_HEIGHT;
+		}
+
+		settings.width = std::min(RENDER_MAX_SIZE, settings.width);
+		settings.height = std::min(RENDER_MAX_SIZE, settings.height);
+
+		std::cout << "Trace primary rays in packets? 1 = off, 4, 8 or 16 rays per packet" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> settings.packetSize;
+		std::cout << "\n" << std::endl;
+
+		if ( settings.packetSize != 4 && settings.packetSize != 8 && settings.packetSize != 16 )
+		{
+			settings.packetSize = 1;
+		}
+
+		int tileOrderChoice = 0;
+		int pixelOrderChoice = 0;
+
+		std::cout << "What order should the tiles, then the pixels in each tile, be traced in? 0 = scanline, 1 = Morton, 2 = Hilbert (0 0 for row by row)" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> tileOrderChoice >> pixelOrderChoice;
+		std::cout << "\n" << std::endl;
+
+		settings.tileOrder = tileOrderChoice == 1 ? ORDER_MORTON : tileOrderChoice == 2 ? ORDER_HILBERT : ORDER_SCANLINE;
+		settings.pixelOrder = pixelOrderChoice == 1 ? ORDER_MORTON : pixelOrderChoice == 2 ? ORDER_HILBERT : ORDER_SCANLINE;
+
+		ChooseCamera(settings);
+
+		std::cout << "Anti-aliasing? Rays for a pixel on an edge, the one through its centre included: 1 = off, up to " << RENDER_MAX_SAMPLES << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> settings.maxSamples;
+		std::cout << "\n" << std::endl;
+
+		settings.maxSamples = std::max(1, std::min(RENDER_MAX_SAMPLES, settings.maxSamples));
+
+		int outputChoice = 0;
+
+		std::cout << "How should the image be saved?" << std::endl;
+		std::cout << "1. PPM, written once the render is done" << std::endl;
+		std::cout << "2. PPM, written by the render threads as they go (memory mapped)" << std::endl;
+		std::cout << "3. PNG, compressed across the render threads once the render is done" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> outputChoice;
+		std::cout << "\n" << std::endl;
+
+		settings.outputFormat = outputChoice == 2 ? OUTPUT_MAPPED_PPM : outputChoice == 3 ? OUTPUT_PNG : OUTPUT_PPM;
+
+		int checkpointChoice = 0;
+
+		std::cout << "Checkpoint finished tiles so a render that dies can pick up where it stopped? 1 = yes, 0 = no (a render with the same settings carries on from " << CHECKPOINT_PATH << ")" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> checkpointChoice;
+		std::cout << "\n" << std::endl;
+
+		settings.checkpoint = checkpointChoice == 1;
+
+		std::cout << "Add an OBJ mesh to the scene? Type its path, or 0 for none" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> settings.meshPath;
+		std::cout << "\n" << std::endl;
+
+		if ( settings.meshPath == "0" )
+		{
+			settings.meshPath.clear();
+		}
 
-	std::vector<std::shared_ptr<Shape>> shapeVector = CreateShapes(shapeVector);   // Create a vector of shape data
+		int previewChoice = 0;
 
-	glm::vec3 **image = new glm::vec3*[WINDOW_WIDTH];
+		std::cout << "Show a live preview as the tiles finish?" << std::endl;
+		std::cout << "0. No" << std::endl;
+		std::cout << "1. Yes, in a window" << std::endl;
+		std::cout << "2. Yes, headless (SDL's dummy video driver, to time the first image)" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> previewChoice;
+		std::cout << "\n" << std::endl;
+
+		settings.preview = previewChoice == 1 ? PREVIEW_WINDOW : previewChoice == 2 ? PREVIEW_HEADLESS : PREVIEW_OFF;
+
+		int pinChoice = 0;
+
+		std::cout << "Pin the render threads to their NUMA nodes? 1 = yes, 0 = no (only changes anything on a machine with more than one node)" << std::endl;
+		std::cout << "\n" << std::endl;
+		std::cin >> pinChoice;
+		std::cout << "\n" << std::endl;
+
+		NumaTopology topology;   // One node unless it is loaded
+
+		if ( pinChoice == 1 && topology.Load() )
+		{
+			std::cout << "Found " << topology.getNodeCount() << " NUMA node" << (topology.getNodeCount() == 1 ? "" : "s") << std::endl;
+			std::cout << "\n" << std::endl;
+		}
+
+		ThreadPool pool(threadChoice, topology);   // Threads are started once here and parked between frames
 
-	for ( int i = 0; i < WINDOW_WIDTH; ++i )
+		GameLoop(pool, settings, std::max(1, frameChoice));
+	}
+	else
 	{
-		image[i] = new glm::vec3[WINDOW_HEIGHT];
+		std::cout << "Incorrect amount of threads chosen. Shutting down" << std::endl;
+		std::cout << "\n" << std::endl;
 	}
+}
 
-	std::cout << "Firing rays.." << std::endl;
+void StartSequence()
+{
+	int threadChoice = 0;
+	int threadsAvailable = std::max(1, (int)std::thread::hardware_concurrency());
+
+	std::cout << "How many threads would you like to render on? (This PC has " << threadsAvailable << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> threadChoice;
 	std::cout << "\n" << std::endl;
 
-	CreateAndJoinThreads(shapeVector, image, _threadChoice);   // Call the creation of threads
+	if ( threadChoice <= 0 )
+	{
+		std::cout << "Incorrect amount of threads chosen. Shutting down" << std::endl;
+		std::cout << "\n" << std::endl;
 
-	std::cout << "Outputting image to folder.." << std::endl;
+		return;
+	}
+
+	int frameChoice = 0;
+
+	std::cout << "How many frames long is the sequence? (" << SEQUENCE_FRAME_RATE << " frames a second)" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> frameChoice;
 	std::cout << "\n" << std::endl;
 
-	OutputImage(image);   // Call the output image function
+	RenderSettings settings;
 
-	std::clock_t endTimer = clock();
+	std::cout << "What resolution would you like? Width then height, 0 0 for " << WINDOW_WIDTH << " " << WINDOW_HEIGHT << ", each up to " << RENDER_MAX_SIZE << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> settings.width >> settings.height;
+	std::cout << "\n" << std::endl;
 
-	std::clock_t clockTicksTaken = endTimer - startTimer;
+	if ( settings.width <= 0 || settings.height <= 0 )
+	{
+		settings.width = WINDOW_WIDTH;
+		settings.height = WINDOW_HEIGHT;
+	}
 
-	float timeInSeconds = clockTicksTaken / (float)CLOCKS_PER_SEC;
+	settings.width = std::min(RENDER_MAX_SIZE, settings.width);
+	settings.height = std::min(RENDER_MAX_SIZE, settings.height);
 
-	std::cout << "Time taken: " << timeInSeconds << " seconds" << std::endl;
+	ChooseCamera(settings);
+
+	int outputChoice = 0;
+
+	std::cout << "How should the frames be saved? 1 = PPM, 2 = PNG" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> outputChoice;
 	std::cout << "\n" << std::endl;
-}
 
-std::vector<std::shared_ptr<Shape>> CreateShapes(std::vector<std::shared_ptr<Shape>> _shapeVector)
-{
-	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(-2.0, 0, -7), 2, glm::vec3(0.82f, 1.00f, 0.87f)));   // Green
-	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(0.5, 0, -10), 2, glm::vec3(1.00f, 0.95f, 0.82f)));   // Yellow
-	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(3.5, 0, -13), 2, glm::vec3(1.00f, 0.87f, 0.82f)));   // Orange
-	_shapeVector.push_back(std::make_shared<Sphere>(glm::vec3(6.5, 0, -16), 2, glm::vec3(0.87f, 0.82f, 1.00f)));   // Purple
-	_shapeVector.push_back(std::make_shared<Plane>(glm::vec3(0, -4, 0), glm::vec3(0, 1, 0), glm::vec3(0.57f, 0.57f, 0.57f)));   // Floor
+	settings.outputFormat = outputChoice == 2 ? OUTPUT_PNG : OUTPUT_PPM;
+
+	int pipelineChoice = 0;
+
+	std::cout << "Overlap encoding and writing each frame with rendering the next? 1 = yes, 0 = no (one stage at a time, to compare against)" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> pipelineChoice;
+	std::cout << "\n" << std::endl;
+
+	ThreadPool pool(threadChoice);
 
-	return _shapeVector;
+	RenderSequence(pool, settings, std::max(1, frameChoice), pipelineChoice != 0);
 }
 
-glm::vec3** DrawPixel(int _minX, int _maxX, int _minY, int _maxY, std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image)
+void StartFarm(const std::string &_program)
 {
-	for ( int x = _minX; x < _maxX; ++x )   // Each pixel is looping parallel to one another to decrease rendering time
+	RenderSettings settings;
+
+	std::cout << "What resolution would you like? Width then height, 0 0 for " << WINDOW_WIDTH << " " << WINDOW_HEIGHT << ", each up to " << RENDER_MAX_SIZE << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> settings.width >> settings.height;
+	std::cout << "\n" << std::endl;
+
+	if ( settings.width <= 0 || settings.height <= 0 )
 	{
-		for ( int y = _minY; y < _maxY; ++y )
-		{
-			float pixNormalX = (x + 0.5f) / WINDOW_WIDTH;   // Normalising pixel position so ray passes through center of pixel
-			float pixNormalY = (y + 0.5f) / WINDOW_HEIGHT;   // Normalising pixel position so ray passes through center of pixel
+		settings.width = WINDOW_WIDTH;
+		settings.height = WINDOW_HEIGHT;
+	}
 
-			float pixRemapX = (2.0f * pixNormalX - 1.0f);   // Remap coordinates to reverse the direction of the y axis
-			float pixRemapY = 1.0f - 2.0f * pixNormalY;   // Remap coordinates to reverse the direction of the y axis
+	settings.width = std::min(RENDER_MAX_SIZE, settings.width);
+	settings.height = std::min(RENDER_MAX_SIZE, settings.height);
 
-			float pixCameraX = pixRemapX * tan(glm::radians(90.0f) / 2.0f);   // Create a field of view with the camera at 90 (Standard for games)
-			float pixCameraY = pixRemapY * tan(glm::radians(90.0f) / 2.0f);   // Create a field of view with the camera at 90 (Standard for games)
+	ChooseCamera(settings);
 
-			glm::vec3 pCameraSpace = glm::vec3(pixCameraX, pixCameraY, -1);   // The point lies 1 unit away from the camera origin
+	std::cout << "Anti-aliasing? Rays for a pixel on an edge, the one through its centre included: 1 = off, up to " << RENDER_MAX_SAMPLES << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> settings.maxSamples;
+	std::cout << "\n" << std::endl;
 
-			std::shared_ptr<Ray> ray = std::make_shared<Ray>();
-			ray->setOrigin(glm::vec3(0, 0, 0));
-			ray->setDirection(glm::normalize(pCameraSpace - ray->getOrigin()));
+	settings.maxSamples = std::max(1, std::min(RENDER_MAX_SAMPLES, settings.maxSamples));
 
-			float minT = INFINITY;
-			int shapeHit = -1;
-			float t0 = 0.0f;
+	int outputChoice = 0;
 
-			for ( int k = 0; k < _shapeVector.size(); ++k )   // Loop through the shape vector
-			{
-				bool hit = _shapeVector[k]->Intersection(ray->getOrigin(), ray->getDirection(), &t0);   // If there is an intersection return true on hit
+	std::cout << "How should the image be saved? 1 = PPM, 2 = PNG" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> outputChoice;
+	std::cout << "\n" << std::endl;
 
-				if ( hit && t0 < minT )
-				{
-					minT = t0;
-					shapeHit = k;
-				}
+	settings.outputFormat = outputChoice == 2 ? OUTPUT_PNG : OUTPUT_PPM;
 
-				if ( shapeHit != -1 )   // If a shape is hit
-				{
-					// Calculating 'Phong lighting' using specular and diffuse
+	std::cout << "Add an OBJ mesh to the scene? Type its path, or 0 for none (only the coordinator needs the file)" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> settings.meshPath;
+	std::cout << "\n" << std::endl;
 
-					glm::vec3 p0 = ray->getOrigin() + (minT * ray->getDirection());
+	if ( settings.meshPath == "0" )
+	{
+		settings.meshPath.clear();
+	}
+
+	int port = 0;
+
+	std::cout << "Which port should the workers connect to? (0 for " << FARM_DEFAULT_PORT << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> port;
+	std::cout << "\n" << std::endl;
+
+	if ( port <= 0 || port > 65535 )
+	{
+		port = FARM_DEFAULT_PORT;
+	}
+
+	int localWorkers = 0;
+	int workerThreads = 0;
+
+	std::cout << "How many workers should be started on this machine, and how many threads each? (0 0 to start them yourself with option 14 or --farm-worker host port threads)" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> localWorkers >> workerThreads;
+	std::cout << "\n" << std::endl;
 
-					glm::vec3 lightPosition = glm::vec3(25, 155, -2);
-					glm::vec3 lightIntensity = glm::vec3(1.0, 1.0, 1.0);
+	int timeoutSeconds = 0;
 
-					glm::vec3 diffuseColour = glm::vec3(0, 0, 0);
-					glm::vec3 specularColour = glm::vec3(0, 0, 0);
-					int shininess = 0;
+	std::cout << "How many seconds can a tile be out before another worker is given it? (0 for " << FARM_TILE_TIMEOUT_MS / 1000 << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> timeoutSeconds;
+	std::cout << "\n" << std::endl;
 
+	int tileTimeoutMs = timeoutSeconds > 0 ? timeoutSeconds * 1000 : FARM_TILE_TIMEOUT_MS;
 
-					glm::vec3 normal = glm::normalize(_shapeVector[shapeHit]->CalculateNormal(p0, &shininess, &diffuseColour, &specularColour));
+	for ( int i = 0; i < localWorkers; ++i )   // Stand-ins for other machines, they keep retrying until the coordinator is listening
+	{
+		system(FarmWorkerCommand(_program, port, std::max(1, workerThreads)).c_str());
+	}
 
-					glm::vec3 lightRay = glm::normalize(lightPosition - p0);
+	Framebuffer image(settings.width, settings.height);
 
-					glm::vec3 diffuse = diffuseColour * lightIntensity * glm::max(0.0f, dot(lightRay, normal));
+	if ( !RenderFarmFrame(settings, port, tileTimeoutMs, image) )
+	{
+		std::cout << "The frame wasn't finished, nothing was saved" << std::endl;
+		std::cout << "\n" << std::endl;
 
-					glm::vec3 reflection = glm::normalize(2 * (dot(lightRay, normal)) * normal - lightRay);
+		return;
+	}
 
-					float maxCalc = glm::max(0.0f, dot(reflection, glm::normalize(ray->getOrigin() - p0)));
+	std::cout << "Outputting image to folder.." << std::endl;
+	std::cout << "\n" << std::endl;
 
-					glm::vec3 specular = specularColour * lightIntensity * pow(maxCalc, shininess);
+	std::vector<unsigned char> file;
 
-					int lightHitShape = 0;
+	if ( settings.outputFormat == OUTPUT_PNG )
+	{
+		ThreadPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
 
-					for ( int i = 0; i < _shapeVector.size(); ++i )
-					{
-						bool lightingHit = _shapeVector[i]->Intersection(p0 + (1e-4f * normal), lightRay, &t0);
+		EncodePNG(image, pool, &file);
+	}
+	else
+	{
+		EncodePPM(image, &file);
+	}
 
-						if ( lightingHit && t0 < minT )
-						{
-							minT = t0;
-							lightHitShape = 1;
-						}
-					}
+	const char *imagePath = settings.outputFormat == OUTPUT_PNG ? PNG_IMAGE_PATH : IMAGE_PATH;
 
-					if ( lightHitShape != 0 )
-					{
-						_image[x][y] = glm::vec3(0.1, 0.1, 0.1);   // Setting it to almost black for the shadows
-					}
-					else
-					{
-						_image[x][y] = diffuse + specular;
-					}
-				}
-				else
-				{
-					_image[x][y] = glm::vec3(0.76, 0.93, 0.93);   // If there is no object data and no collision has occured then set pixel to sky blue
-				}
-			}
-		}
+	if ( !WriteFile(imagePath, file) )
+	{
+		std::cout << "Couldn't write " << imagePath << std::endl;
+		std::cout << "\n" << std::endl;
 	}
+}
 
-	return _image;
+void StartFarmWorker()
+{
+	std::string host;
+	int port = 0;
+	int threadChoice = 0;
+	int threadsAvailable = std::max(1, (int)std::thread::hardware_concurrency());
+
+	std::cout << "Which coordinator should this worker connect to? Host then port, 0 for " << FARM_DEFAULT_PORT << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> host >> port;
+	std::cout << "\n" << std::endl;
+
+	std::cout << "How many threads would you like to render on? (This PC has " << threadsAvailable << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> threadChoice;
+	std::cout << "\n" << std::endl;
+
+	RunFarmWorker(host, port > 0 ? port : FARM_DEFAULT_PORT, std::max(1, threadChoice));   // Prints what went wrong if it couldn't finish
+	std::cout << "\n" << std::endl;
 }
 
-void CreateAndJoinThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image, int _threadChoice)
+void ChooseCamera(RenderSettings &_settings)
 {
-	if (_threadChoice == 1)
+	std::cout << "Where should the camera be? Position then the point it looks at, x y z x y z (0 0 0 0 0 -1 for straight down the scene)" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> _settings.cameraPosition.x >> _settings.cameraPosition.y >> _settings.cameraPosition.z;
+	std::cin >> _settings.cameraTarget.x >> _settings.cameraTarget.y >> _settings.cameraTarget.z;
+	std::cout << "\n" << std::endl;
+
+	std::cout << "Vertical field of view in degrees? (0 for " << CAMERA_DEFAULT_FOV << ")" << std::endl;
+	std::cout << "\n" << std::endl;
+	std::cin >> _settings.fieldOfView;
+	std::cout << "\n" << std::endl;
+
+	if ( _settings.fieldOfView <= 0.0f || _settings.fieldOfView >= 180.0f )
 	{
-		UseOneThread(_shapeVector, _image);
+		_settings.fieldOfView = CAMERA_DEFAULT_FOV;
 	}
+}
 
-	if (_threadChoice == 4)
+void GameLoop(ThreadPool &_pool, const RenderSettings &_settings, int _frameCount)
+{
+	std::chrono::steady_clock::time_point startTimer = std::chrono::steady_clock::now();   // Wall clock, clock() adds up every thread's CPU time on Linux
+
+	RenderStats stats(_pool.getThreadCount(), _settings.width, _settings.height, _settings.tileSize);
+	stats.setFrameCount(_frameCount);
+
+	std::chrono::steady_clock::time_point phaseStart = std::chrono::steady_clock::now();
+
+	std::vector<std::shared_ptr<Shape>> shapeVector = CreateShapes(std::vector<std::shared_ptr<Shape>>());   // Create the shape data
+
+	if ( !_settings.meshPath.empty() )
 	{
-		UseFourThreads(_shapeVector, _image);
+		std::shared_ptr<Mesh> mesh = LoadMesh(_settings.meshPath);
+
+		if ( mesh != nullptr )
+		{
+			shapeVector.push_back(mesh);   // Goes in the scene as one shape with its own triangle BVH inside
+		}
 	}
 
-	if (_threadChoice == 16)
+	Scene scene(shapeVector);   // The scene sorts the shapes into one array per type
+
+	scene.getCamera().LookAt(_settings.cameraPosition, _settings.cameraTarget, glm::vec3(0, 1, 0));
+	scene.getCamera().setFieldOfView(_settings.fieldOfView);
+	scene.getCamera().setResolution(_settings.width, _settings.height);   // The camera's per pixel steps follow the image, worked out here once rather than by every pass
+
+	BVH bvh;
+	bvh.Build(scene);   // Build the acceleration structure once, every frame shares it
+
+	stats.AddPhase("scene build", RenderStats::SecondsSince(phaseStart));
+
+	bool firstTouch = _pool.getNodeCount() > 1;   // Left unwritten so each page lands on the node whose workers render the rows in it
+
+	HitBuffer hits(_settings.width, _settings.height, !firstTouch);   // Filled by the intersection pass, read by the shading pass
+
+	Framebuffer image(_settings.width, _settings.height, !firstTouch);   // One block for the whole image, freed when the render is done
+
+	MappedPPM mappedFile;
+
+	if ( _settings.outputFormat == OUTPUT_MAPPED_PPM && !mappedFile.Open(IMAGE_PATH, _settings.width, _settings.height) )
 	{
-		UseSixteenThreads(_shapeVector, _image);
+		std::cout << "Couldn't map the image file, it will be written at the end instead" << std::endl;
+		std::cout << "\n" << std::endl;
 	}
 
-	if (_threadChoice == 64)
+	Preview preview(_settings.width, _settings.height);
+
+	if ( _settings.preview != PREVIEW_OFF && !preview.Open(_settings.preview == PREVIEW_HEADLESS) )
 	{
-		UseSixtyFourThreads(_shapeVector, _image);
+		std::cout << "Couldn't open the preview, rendering without it" << std::endl;
+		std::cout << "\n" << std::endl;
 	}
-}
 
-void OutputImage(glm::vec3 **_image)
-{
-	std::ofstream ofs("../RayTracingImage.ppm", std::ios::out | std::ios::binary);
-	ofs << "P6\n" << WINDOW_WIDTH << " " << WINDOW_HEIGHT << "\n255\n";
+	TileScheduler scheduler(_pool, _settings.tileSize);   // Shared by every frame so only the first one allocates its queues and timings
 
-	for ( unsigned y = 0; y < WINDOW_HEIGHT; ++y )
+	Checkpoint checkpoint;   // Only the last frame is checkpointed, the ones before it are repeats for timing
+
+	if ( _settings.checkpoint )
 	{
-		for ( unsigned x = 0; x < WINDOW_WIDTH; ++x )
+		if ( !checkpoint.Open(CHECKPOINT_PATH, _settings, scene) )
 		{
-			ofs << (unsigned char)(std::min((float)1, (float)_image[x][y].x) * 255) <<
-				(unsigned char)(std::min((float)1, (float)_image[x][y].y) * 255) <<
-				(unsigned char)(std::min((float)1, (float)_image[x][y].z) * 255);
+			std::cout << "Couldn't open " << CHECKPOINT_PATH << ", rendering without checkpoints" << std::endl;
+			std::cout << "\n" << std::endl;
+		}
+		else if ( checkpoint.getRestoredCount() > 0 )
+		{
+			std::cout << "Resuming, " << checkpoint.getRestoredCount() << " of " << checkpoint.getTiles().size() << " tiles were read back from " << CHECKPOINT_PATH << std::endl;
+			std::cout << "\n" << std::endl;
 		}
 	}
-	ofs.close();
-}
 
-void UseOneThread(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image)
-{
-	// Did attempt the use of for loops to clean the code up but it slowed down the program to the point where 4 threads were faster than 64
+	std::function<void(const Tile&)> tileFinished;   // Empty unless there's a preview to send tiles to
 
-	std::thread t1(DrawPixel, 0, 800, 0, 800, _shapeVector, _image);
+	if ( preview.isOpen() )
+	{
+		tileFinished = [&](const Tile &_tile) { preview.TileFinished(_tile, image); };
+	}
 
-	t1.join();
-}
+	std::cout << "Firing rays.." << std::endl;
+	std::cout << "\n" << std::endl;
 
-void UseFourThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image)
-{
-	// Did attempt the use of for loops to clean the code up but it slowed down the program to the point where 4 threads were faster than 64
+	phaseStart = std::chrono::steady_clock::now();
+
+	std::function<void()> renderFrames = [&]()
+	{
+		for ( int i = 0; i < _frameCount; ++i )
+		{
+			bool lastFrame = i == _frameCount - 1;
 
-	std::vector<std::shared_ptr<std::thread>> threadVector;   // Create a vector to hold all the chunks of the screen
+			if ( i == 0 && tileFinished )
+			{
+				RenderCoarse(scene, bvh, image, scheduler, stats, tileFinished);   // Something to look at while the first full frame renders
+			}
+
+			if ( lastFrame && checkpoint.isOpen() )
+			{
+				RenderFrameCheckpointed(scene, bvh, _settings, hits, image, mappedFile.isOpen() ? &mappedFile : nullptr, scheduler, stats, &checkpoint, tileFinished);
+			}
+			else
+			{
+				RenderFrame(scene, bvh, _settings, hits, image, lastFrame && mappedFile.isOpen() ? &mappedFile : nullptr, scheduler, stats, tileFinished);   // Hand the frame to the pool's threads
+			}
+		}
+	};
+
+	if ( preview.isOpen() )
+	{
+		// SDL wants its window used from the thread that made it, so the frames are driven from another thread while this one presents
+
+		std::atomic<bool> rendering(true);
 
-	// Split screen into quads
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 400, 0, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 800, 0, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 400, 400, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 800, 400, 800, _shapeVector, _image));
-	
-	for ( int i = 0; i < threadVector.size(); ++i )   // Loop through the thread vector
+		std::thread renderThread([&]()
+		{
+			renderFrames();
+			rendering = false;
+		});
+
+		while ( rendering )
+		{
+			preview.Present();
+			std::this_thread::sleep_for(std::chrono::milliseconds(PREVIEW_INTERVAL_MS));
+		}
+
+		renderThread.join();
+		preview.Present();   // Tiles that finished since the last present
+
+		if ( preview.getPresentCount() > 0 )
+		{
+			stats.setFirstImageSeconds(std::chrono::duration<double>(preview.getFirstPresentTime() - startTimer).count());
+		}
+	}
+	else
 	{
-		threadVector.at(i)->join();   // Call join on all the threads
+		renderFrames();
 	}
-}
 
-void UseSixteenThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image)
-{
-	// Did attempt the use of for loops to clean the code up but it slowed down the program to the point where 4 threads were faster than 64
-
-	std::vector<std::shared_ptr<std::thread>> threadVector;   // Create a vector to hold all the chunks of the screen
-
-	// Top row (1)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 200, 0, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 400, 0, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 600, 0, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 800, 0, 200, _shapeVector, _image));
-
-	// Middle row (2)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 200, 200, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 400, 200, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 600, 200, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 800, 200, 400, _shapeVector, _image));
-
-	// Middle row (3)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 200, 400, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 400, 400, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 600, 400, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 800, 400, 600, _shapeVector, _image));
-
-	// Bottom row (4)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 200, 600, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 400, 600, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 600, 600, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 800, 600, 800, _shapeVector, _image));
-
-	for ( int i = 0; i < threadVector.size(); ++i )   // Loop through the thread vector
+	stats.AddPhase("render", RenderStats::SecondsSince(phaseStart));
+
+	if ( checkpoint.isOpen() )
 	{
-		threadVector.at(i)->join();   // Call join on all the threads
+		checkpoint.Close();   // The last tiles go out now, in case saving the image fails
+
+		std::cout << "Checkpoint: " << checkpoint.getBytesWritten() / 1024 << " KB written in " << checkpoint.getWriteSeconds() * 1000.0 << " ms on its own thread, "
+			<< checkpoint.getQueueSeconds() * 1000.0 << " ms of the render threads' time spent queueing tiles" << std::endl;
+		std::cout << "\n" << std::endl;
 	}
-}
 
-void UseSixtyFourThreads(std::vector<std::shared_ptr<Shape>> _shapeVector, glm::vec3 **_image)
-{
-	// Did attempt the use of for loops to clean the code up but it slowed down the program to the point where 4 threads were faster than 64
-
-	std::vector<std::shared_ptr<std::thread>> threadVector;   // Create a vector to hold all the chunks of the screen
-
-	// Top row (1)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 0, 100, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 0, 100, _shapeVector, _image));
-	
-	// Middle row (2)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 100, 200, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 100, 200, _shapeVector, _image));
-
-	// Middle row (3)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 200, 300, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 200, 300, _shapeVector, _image));
-
-	// Middle row (4)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 300, 400, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 300, 400, _shapeVector, _image));
-
-	// Middle row (5)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 400, 500, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 400, 500, _shapeVector, _image));
-
-	// Middle row (6)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 500, 600, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 500, 600, _shapeVector, _image));
-
-	// Middle row (7)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 600, 700, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 600, 700, _shapeVector, _image));
-
-	// Bottom row (8)
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 0, 100, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 100, 200, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 200, 300, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 300, 400, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 400, 500, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 500, 600, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 600, 700, 700, 800, _shapeVector, _image));
-	threadVector.push_back(std::make_shared<std::thread>(DrawPixel, 700, 800, 700, 800, _shapeVector, _image));
-
-	for ( int i = 0; i < threadVector.size(); ++i )   // Loop through the thread vector
+	bool imageSaved = true;
+
+	if ( mappedFile.isOpen() )
 	{
-		threadVector.at(i)->join();   // Call join on all the threads
+		phaseStart = std::chrono::steady_clock::now();
+
+		mappedFile.Close();   // The pixels are already in the file, encoding happened in the shading pass
+
+		stats.AddPhase("write", RenderStats::SecondsSince(phaseStart));
 	}
-}
\ No newline at end of file
+	else
+	{
+		std::cout << "Outputting image to folder.." << std::endl;
+		std::cout << "\n" << std::endl;
+
+		std::vector<unsigned char> file;
+
+		phaseStart = std::chrono::steady_clock::now();
+
+		if ( _settings.outputFormat == OUTPUT_PNG )
+		{
+			EncodePNG(image, _pool, &file);
+		}
+		else
+		{
+			EncodePPM(image, &file);
+		}
+
+		stats.AddPhase("encode", RenderStats::SecondsSince(phaseStart));
+
+		phaseStart = std::chrono::steady_clock::now();
+
+		const char *imagePath = _settings.outputFormat == OUTPUT_PNG ? PNG_IMAGE_PATH : IMAGE_PATH;
+
+		imageSaved = WriteFile(imagePath, file);
+
+		if ( !imageSaved )
+		{
+			std::cout << "Couldn't write " << imagePath << std::endl;
+			std::cout << "\n" << std::endl;
+		}
+
+		stats.AddPhase("write", RenderStats::SecondsSince(phaseStart));
+	}
+
+	if ( _settings.checkpoint && imageSaved )
+	{
+		checkpoint.Remove();   // Nothing left to resume, a later render starts from scratch
+	}
+
+	double timeInSeconds = RenderStats::SecondsSince(startTimer);
+
+	stats.setTotalSeconds(timeInSeconds);
+
+	std::cout << "Time taken: " << timeInSeconds << " seconds" << std::endl;
+	std::cout << "\n" << std::endl;
+
+	if ( _frameCount > 1 )
+	{
+		std::cout << "Time per frame: " << stats.getRenderSeconds() / _frameCount << " seconds" << std::endl;
+		std::cout << "\n" << std::endl;
+	}
+
+	stats.Print();
+
+	if ( !stats.WriteJSON(REPORT_PATH) )
+	{
+		std::cout << "Couldn't write " << REPORT_PATH << std::endl;
+		std::cout << "\n" << std::endl;
+	}
+
+	if ( _settings.preview == PREVIEW_WINDOW && preview.isOpen() )
+	{
+		std::cout << "Close the preview window to carry on" << std::endl;
+		std::cout << "\n" << std::endl;
+
+		preview.WaitForClose();
+	}
+}